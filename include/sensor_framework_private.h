@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2011 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+
+#ifndef __SENSOR_FRAMEWORK_PRIVATE_H__
+#define __SENSOR_FRAMEWORK_PRIVATE_H__
+
+#ifndef SENSOR_WITHOUT_FRAMEWORK
+
+#include <sensor.h>
+#include <sensor_accel.h>
+#include <sensor_geomag.h>
+#include <sensor_light.h>
+#include <sensor_proxi.h>
+#include <sensor_motion.h>
+#include <sensor_gyro.h>
+
+#else
+
+/*
+ * Built without the sensor framework, on the mock backend only. These are
+ * the framework types and identifiers the library uses, the values only
+ * have to be consistent inside the library.
+ */
+typedef enum {
+    UNKNOWN_SENSOR          = 0x0000,
+    ACCELEROMETER_SENSOR    = 0x0001,
+    GEOMAGNETIC_SENSOR      = 0x0002,
+    LIGHT_SENSOR            = 0x0004,
+    PROXIMITY_SENSOR        = 0x0008,
+    GYROSCOPE_SENSOR        = 0x0020,
+    MOTION_SENSOR           = 0x0080,
+} sensor_type_t;
+
+enum {
+    SENSOR_ACCURACY_UNDEFINED = -1,
+    SENSOR_ACCURACY_BAD = 0,
+    SENSOR_ACCURACY_NORMAL = 1,
+    SENSOR_ACCURACY_GOOD = 2,
+    SENSOR_ACCURACY_VERYGOOD = 3,
+};
+
+typedef enum {
+    CONDITION_NO_OP,
+    CONDITION_EQUAL,
+    CONDITION_GREAT_THAN,
+    CONDITION_LESS_THAN,
+} condition_op_t;
+
+typedef struct {
+    condition_op_t cond_op;
+    float cond_value1;
+} event_condition_t;
+
+typedef struct {
+    int data_accuracy;
+    int data_unit_idx;
+    unsigned long long time_stamp;
+    int values_num;
+    float values[12];
+} sensor_data_t;
+
+typedef struct {
+    unsigned int event_type;
+    void *event_data;
+    int event_data_size;
+} sensor_event_data_t;
+
+typedef struct {
+    int sensor_unit_idx;
+    float sensor_min_range;
+    float sensor_max_range;
+    float sensor_resolution;
+    char sensor_name[64];
+    char sensor_vendor[64];
+} sensor_properties_t;
+
+typedef struct {
+    int sensor_unit_idx;
+    float sensor_min_range;
+    float sensor_max_range;
+    float sensor_resolution;
+} sensor_data_properties_t;
+
+typedef struct {
+    int x;
+    int y;
+} sensor_panning_data_t;
+
+typedef void (*sensor_callback_func_t)(unsigned int event_type, sensor_event_data_t *event, void *udata);
+
+#define ACCELEROMETER_BASE_DATA_SET                     0x00010001
+#define ACCELEROMETER_EVENT_RAW_DATA_REPORT_ON_TIME     0x00010002
+#define ACCELEROMETER_EVENT_CALIBRATION_NEEDED          0x00010004
+
+#define GEOMAGNETIC_BASE_DATA_SET                       0x00020001
+#define GEOMAGNETIC_RAW_DATA_SET                        0x00020002
+#define GEOMAGNETIC_EVENT_CALIBRATION_NEEDED            0x00020001
+#define GEOMAGNETIC_EVENT_ATTITUDE_DATA_REPORT_ON_TIME  0x00020004
+#define GEOMAGNETIC_EVENT_RAW_DATA_REPORT_ON_TIME       0x00020008
+
+#define LIGHT_LUX_DATA_SET                              0x00040001
+#define LIGHT_EVENT_LUX_DATA_REPORT_ON_TIME             0x00040002
+
+#define PROXIMITY_DISTANCE_DATA_SET                     0x00080002
+#define PROXIMITY_EVENT_DISTANCE_DATA_REPORT_ON_TIME    0x00080004
+
+#define GYRO_BASE_DATA_SET                              0x00200001
+#define GYROSCOPE_EVENT_RAW_DATA_REPORT_ON_TIME         0x00200001
+
+#define MOTION_ENGINE_EVENT_SNAP                        0x00800001
+#define MOTION_ENGINE_EVENT_SHAKE                       0x00800002
+#define MOTION_ENGINE_EVENT_DOUBLETAP                   0x00800004
+#define MOTION_ENGINE_EVENT_PANNING                     0x00800008
+#define MOTION_ENGINE_EVENT_TOP_TO_BOTTOM               0x00800010
+
+#define MOTION_ENGIEN_DOUBLTAP_DETECTION                1
+#define MOTION_ENGIEN_TOP_TO_BOTTOM_DETECTION           1
+
+#endif
+
+#endif // __SENSOR_FRAMEWORK_PRIVATE_H__
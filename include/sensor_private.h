@@ -20,11 +20,104 @@
 #ifndef __SENSOR_PRIVATE_H__
 #define __SENSOR_PRIVATE_H__
 
+#include <pthread.h>
+
 #ifdef __cplusplus
 extern "C"
 {
 #endif
 
+#define _DEBUG 1
+
+#ifdef _DEBUG
+#undef LOG_TAG
+#define LOG_TAG "TIZEN_SYSTEM_SENSOR"
+#include <dlog.h>
+
+#define _MSG_SENSOR_ERROR_IO_ERROR "Io Error"
+#define _MSG_SENSOR_ERROR_INVALID_PARAMETER "Invalid Parameter"
+#define _MSG_SENSOR_ERROR_OUT_OF_MEMORY "Out of Memory"
+#define _MSG_SENSOR_ERROR_NOT_NEED_CALIBRATION "Not need calibration"
+#define _MSG_SENSOR_ERROR_NOT_SUPPORTED "Not supported"
+#define _MSG_SENSOR_ERROR_OPERATION_FAILED "Operation failed"
+
+#define DEBUG_PRINT(txt) LOGD("%s : " txt, __FUNCTION__)
+#define DEBUG_PRINTF(fmt, ...) LOGD("%s : " fmt, __FUNCTION__, __VA_ARGS__)
+#define ERROR_PRINT(err) LOGD("[%s]" _MSG_##err "(0x%08x)", __FUNCTION__, err)
+#define ERROR_PRINTF(err, fmt, ...) LOGD("[%s]" _MSG_##err "(0x%08x) : " fmt, __FUNCTION__, err, __VA_ARGS__)
+#else
+#define DEBUG_PRINT(txt)
+#define DEBUG_PRINTF(fmt, ...)
+#define ERROR_PRINT(err)
+#define ERROR_PRINTF(err)
+#endif
+
+#define RETURN_VAL_IF(expr, err) \
+	do { \
+		if (expr) { \
+            ERROR_PRINT(err); \
+			return (err); \
+		} \
+	} while(0)
+
+#define RETURN_ERROR(err) \
+    do { \
+        ERROR_PRINT(err); \
+        return err; \
+    } while(0)
+
+
+#define RETURN_IF_NOT_HANDLE(handle) \
+	RETURN_VAL_IF(handle == NULL, SENSOR_ERROR_INVALID_PARAMETER)
+
+#define RETURN_IF_NOT_TYPE(type) \
+	RETURN_VAL_IF(type >= CB_NUMBERS || type < 0, SENSOR_ERROR_INVALID_PARAMETER)
+
+#define RETURN_IF_MOTION_TYPE(type) \
+	RETURN_VAL_IF(type > SENSOR_PROXIMITY && type <= SENSOR_MOTION_FACEDOWN, SENSOR_ERROR_INVALID_PARAMETER)
+
+// virtual sensors are computed in the library from the stream of another sensor type
+#define _IS_VIRTUAL_TYPE(type) ((type) > SENSOR_MOTION_FACEDOWN)
+
+#define RETURN_IF_VIRTUAL_TYPE(type) \
+	RETURN_VAL_IF(_IS_VIRTUAL_TYPE(type), SENSOR_ERROR_INVALID_PARAMETER)
+
+#define RETURN_IF_ERROR(val) \
+	RETURN_VAL_IF(val < 0, val)
+
+// sensor_data_t::time_stamp is reported by the sensor server in microseconds
+#define MICROSECONDS(tv)        ((tv.tv_sec * 1000000ll) + tv.tv_usec)
+
+/*
+ * Single writer sequence lock. The dispatch path is the only writer of the
+ * guarded data, readers on any thread retry until they see an even, unchanged
+ * sequence number.
+ */
+static inline void _sensor_seq_write_begin(unsigned int* seq)
+{
+    __atomic_store_n(seq, *seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void _sensor_seq_write_end(unsigned int* seq)
+{
+    __atomic_store_n(seq, *seq + 1, __ATOMIC_RELEASE);
+}
+
+static inline unsigned int _sensor_seq_read_begin(unsigned int* seq)
+{
+    unsigned int s;
+    while((s = __atomic_load_n(seq, __ATOMIC_ACQUIRE)) & 1)
+        ;
+    return s;
+}
+
+static inline int _sensor_seq_read_retry(unsigned int* seq, unsigned int s)
+{
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(seq, __ATOMIC_RELAXED) != s;
+}
+
 enum _sensor_ids_index{
     ID_ACCELEOMETER, 
     ID_GEOMAGNETIC,
@@ -35,11 +128,49 @@ enum _sensor_ids_index{
     ID_NUMBERS
 };
 
-#define CB_NUMBERS (SENSOR_MOTION_FACEDOWN+1)
+#define CB_NUMBERS (SENSOR_PEDOMETER+1)
 #define CALIB_CB_NUMBERS (SENSOR_ORIENTATION+1)
+#define LISTENER_NUMBERS 16
+
+// runtime counters of a type, added to with relaxed atomics and read by sensor_get_stats()
+struct sensor_counters_s {
+    unsigned long long events;
+    unsigned long long samples_delivered;
+    unsigned long long samples_dropped;
+    unsigned long long connect_calls;
+    unsigned long long read_calls;
+    unsigned long long register_calls;
+    unsigned long long callback_time[SENSOR_STATS_CALLBACK_BUCKETS];
+};
+
+#define _COUNT(counter, n) __atomic_fetch_add(&(counter), (n), __ATOMIC_RELAXED)
+
+struct sensor_stats_s;
+struct sensor_gyro_integrator_s;
+struct sensor_device_orientation_s;
+struct sensor_pedometer_s;
+struct sensor_spectrum_s;
+struct sensor_sync_s;
+struct sensor_motion_fallback_s;
+struct sensor_adaptive_rate_s;
+struct sensor_magnetic_calibration_s;
+struct sensor_gyroscope_bias_estimator_s;
+struct sensor_state_s;
+struct sensor_record_s;
+struct sensor_share_s;
+struct sensor_latency_s;
+struct sensor_jitter_s;
 
 struct sensor_handle_s {
 	int ids[ID_NUMBERS];
+
+    // held by the dispatch of an event, and while the state it feeds is released
+    pthread_mutex_t lock;
+
+    // dispatches under way, a handle destroyed by one of their callbacks is freed after the last
+    int dispatching;
+    int destroyed;
+
 //	sensor_type_e type;
     int started[CB_NUMBERS];
 	void* cb_func[CB_NUMBERS];
@@ -47,6 +178,42 @@ struct sensor_handle_s {
 	
 	void* calib_func[CALIB_CB_NUMBERS];
 	void* calib_user_data[CALIB_CB_NUMBERS];
+
+    // event registration shared by the user callback and in-library consumers
+    int registered[CB_NUMBERS];
+    int rate[CB_NUMBERS];
+    int listeners[CB_NUMBERS];
+
+    // intervals asked by the user callback and by each listener, the stream runs at the fastest
+    int user_rate[CB_NUMBERS];
+    int listener_rate[CB_NUMBERS][LISTENER_NUMBERS];
+
+    // cb_func of a data type is a sensor_batch_cb
+    int batch[CB_NUMBERS];
+
+    struct sensor_stats_s* stats[CB_NUMBERS];
+    struct sensor_gyro_integrator_s* gyro_integrator;
+    struct sensor_device_orientation_s* device_orientation;
+    struct sensor_pedometer_s* pedometer;
+    struct sensor_spectrum_s* spectrum[CB_NUMBERS];
+    struct sensor_sync_s* sync;
+
+    // motion types detected in the library, on the accelerometer connection
+    int fallback[CB_NUMBERS];
+    struct sensor_motion_fallback_s* motion_fallback;
+
+    struct sensor_adaptive_rate_s* adaptive_rate[CB_NUMBERS];
+    struct sensor_magnetic_calibration_s* magnetic_calibration;
+    struct sensor_gyroscope_bias_estimator_s* gyroscope_bias;
+    struct sensor_state_s* state;
+    struct sensor_record_s* record;
+    sensor_record_format_e record_format;
+    struct sensor_share_s* share;
+
+    struct sensor_counters_s counters[CB_NUMBERS];
+    unsigned long long unknown_events;
+    struct sensor_latency_s* latency[CB_NUMBERS];
+    struct sensor_jitter_s* jitter[CB_NUMBERS];
 };
 
 #define SENSOR_INIT(handle) \
@@ -68,6 +235,8 @@ struct sensor_handle_s {
         handle->started[SENSOR_MOTION_DOUBLETAP] = 0; \
         handle->started[SENSOR_MOTION_PANNING] = 0; \
         handle->started[SENSOR_MOTION_FACEDOWN] = 0; \
+        handle->started[SENSOR_DEVICE_ORIENTATION] = 0; \
+        handle->started[SENSOR_PEDOMETER] = 0; \
         handle->cb_func[SENSOR_ACCELEROMETER] = NULL; \
         handle->cb_func[SENSOR_MAGNETIC] = NULL; \
         handle->cb_func[SENSOR_ORIENTATION] = NULL; \
@@ -79,6 +248,8 @@ struct sensor_handle_s {
         handle->cb_func[SENSOR_MOTION_DOUBLETAP] = NULL; \
         handle->cb_func[SENSOR_MOTION_PANNING] = NULL; \
         handle->cb_func[SENSOR_MOTION_FACEDOWN] = NULL; \
+        handle->cb_func[SENSOR_DEVICE_ORIENTATION] = NULL; \
+        handle->cb_func[SENSOR_PEDOMETER] = NULL; \
         handle->cb_user_data[SENSOR_ACCELEROMETER] = NULL; \
         handle->cb_user_data[SENSOR_MAGNETIC] = NULL; \
         handle->cb_user_data[SENSOR_ORIENTATION] = NULL; \
@@ -90,14 +261,223 @@ struct sensor_handle_s {
         handle->cb_user_data[SENSOR_MOTION_DOUBLETAP] = NULL; \
         handle->cb_user_data[SENSOR_MOTION_PANNING] = NULL; \
         handle->cb_user_data[SENSOR_MOTION_FACEDOWN] = NULL; \
+        handle->cb_user_data[SENSOR_DEVICE_ORIENTATION] = NULL; \
+        handle->cb_user_data[SENSOR_PEDOMETER] = NULL; \
 		handle->calib_func[SENSOR_ACCELEROMETER] = NULL; \
 		handle->calib_func[SENSOR_MAGNETIC] = NULL; \
 		handle->calib_func[SENSOR_ORIENTATION] = NULL; \
 		handle->calib_user_data[SENSOR_ACCELEROMETER] = NULL; \
 		handle->calib_user_data[SENSOR_MAGNETIC] = NULL; \
 		handle->calib_user_data[SENSOR_ORIENTATION] = NULL; \
+        handle->dispatching = 0; \
+        handle->destroyed = 0; \
+        memset(handle->registered, 0, sizeof(handle->registered)); \
+        memset(handle->rate, 0, sizeof(handle->rate)); \
+        memset(handle->listeners, 0, sizeof(handle->listeners)); \
+        memset(handle->user_rate, 0, sizeof(handle->user_rate)); \
+        memset(handle->listener_rate, 0, sizeof(handle->listener_rate)); \
+        memset(handle->batch, 0, sizeof(handle->batch)); \
+        memset(handle->stats, 0, sizeof(handle->stats)); \
+        handle->gyro_integrator = NULL; \
+        handle->device_orientation = NULL; \
+        handle->pedometer = NULL; \
+        memset(handle->spectrum, 0, sizeof(handle->spectrum)); \
+        handle->sync = NULL; \
+        memset(handle->fallback, 0, sizeof(handle->fallback)); \
+        handle->motion_fallback = NULL; \
+        memset(handle->adaptive_rate, 0, sizeof(handle->adaptive_rate)); \
+        handle->magnetic_calibration = NULL; \
+        handle->gyroscope_bias = NULL; \
+        handle->state = NULL; \
+        handle->record = NULL; \
+        handle->record_format = SENSOR_RECORD_FORMAT_RAW; \
+        handle->share = NULL; \
+        memset(handle->counters, 0, sizeof(handle->counters)); \
+        handle->unknown_events = 0; \
+        memset(handle->latency, 0, sizeof(handle->latency)); \
+        memset(handle->jitter, 0, sizeof(handle->jitter)); \
     }while(0) \
 
+// the sf_* calls of the library, served by the sensor framework, a replay or the mock
+struct sensor_backend_s {
+    int (*connect)(sensor_type_t sensor_type);
+    int (*disconnect)(int handle);
+    int (*start)(int handle, int option);
+    int (*stop)(int handle);
+    int (*register_event)(int handle, unsigned int event_type, event_condition_t *event_condition, sensor_callback_func_t cb, void *cb_data);
+    int (*unregister_event)(int handle, unsigned int event_type);
+    int (*get_data)(int handle, unsigned int data_id, sensor_data_t* values);
+    int (*get_properties)(sensor_type_t sensor_type, sensor_properties_t *return_properties);
+    int (*get_data_properties)(unsigned int data_id, sensor_data_properties_t *return_data_properties);
+    int (*is_sensor_event_available)(sensor_type_t sensor_type, unsigned int event_type);
+};
+
+const struct sensor_backend_s* _sensor_backend(void);
+void _sensor_backend_hold(int count);
+
+extern const struct sensor_backend_s _sensor_replay_backend;
+int _sensor_replay_open(const char* path, float speed);
+void _sensor_replay_close(void);
+
+extern const struct sensor_backend_s _sensor_mock_backend;
+
+extern sensor_type_t _TYPE[];
+extern int _DTYPE[];
+extern int _EVENT[];
+extern int _CALIBRATION[];
+
+int _sensor_listen(sensor_h handle, sensor_type_e type, int rate);
+int _sensor_unlisten(sensor_h handle, sensor_type_e type, int rate);
+int _sensor_update_rate(sensor_h handle, sensor_type_e type);
+void _sensor_release(sensor_h handle, void (*release)(sensor_h handle));
+
+void _sensor_stats_feed(struct sensor_stats_s* stats, sensor_data_t* data, int data_num);
+void _sensor_stats_release(sensor_h handle);
+
+void _sensor_gyro_integrator_feed(struct sensor_gyro_integrator_s* integrator, sensor_data_t* data, int data_num);
+void _sensor_gyro_integrator_release(sensor_h handle);
+
+void _sensor_device_orientation_feed(sensor_h handle, sensor_data_t* data, int data_num);
+void _sensor_device_orientation_release(sensor_h handle);
+
+void _sensor_pedometer_feed(sensor_h handle, sensor_data_t* data, int data_num);
+void _sensor_pedometer_release(sensor_h handle);
+
+void _sensor_spectrum_feed(struct sensor_spectrum_s* spectrum, sensor_data_t* data, int data_num);
+void _sensor_spectrum_release(sensor_h handle);
+
+void _sensor_sync_feed(struct sensor_sync_s* sync, sensor_type_e type, sensor_data_t* data, int data_num);
+void _sensor_sync_release(sensor_h handle);
+
+void _sensor_motion_fallback_feed(sensor_h handle, sensor_data_t* data, int data_num);
+void _sensor_motion_fallback_release(sensor_h handle);
+int _sensor_motion_fallback_enable(sensor_h handle, sensor_type_e type);
+int _sensor_motion_fallback_disable(sensor_h handle, sensor_type_e type);
+
+void _sensor_adaptive_rate_feed(sensor_h handle, sensor_type_e type, sensor_data_t* data, int data_num);
+void _sensor_adaptive_rate_reset(sensor_h handle, sensor_type_e type, int interval);
+int _sensor_adaptive_rate_interval(sensor_h handle, sensor_type_e type, int interval);
+void _sensor_adaptive_rate_release(sensor_h handle);
+
+void _sensor_magnetic_calibration_feed(sensor_h handle, sensor_data_t* data, int data_num);
+void _sensor_magnetic_calibration_correct(sensor_h handle, sensor_data_t* data);
+void _sensor_magnetic_calibration_release(sensor_h handle);
+
+void _sensor_gyroscope_bias_feed(sensor_h handle, sensor_type_e type, sensor_data_t* data, int data_num);
+void _sensor_gyroscope_bias_correct(sensor_h handle, sensor_data_t* data);
+void _sensor_gyroscope_bias_release(sensor_h handle);
+
+// sections of the state file, their layout is part of the file version
+#define SENSOR_STATE_MAGNETIC       0x1
+#define SENSOR_STATE_GYROSCOPE      0x2
+
+struct sensor_state_magnetic_s {
+    double theta[9];
+    double p[9][9];
+    int samples;
+    float last[3];
+    float error2;
+};
+
+struct sensor_state_gyroscope_s {
+    float bias[3];
+    int valid;
+};
+
+void _sensor_state_feed(sensor_h handle, unsigned long long time_stamp);
+void _sensor_state_restore(sensor_h handle, unsigned int sections);
+void _sensor_state_release(sensor_h handle);
+
+void _sensor_magnetic_calibration_save(sensor_h handle, struct sensor_state_magnetic_s* state);
+void _sensor_magnetic_calibration_load(sensor_h handle, const struct sensor_state_magnetic_s* state);
+void _sensor_gyroscope_bias_save(sensor_h handle, struct sensor_state_gyroscope_s* state);
+void _sensor_gyroscope_bias_load(sensor_h handle, const struct sensor_state_gyroscope_s* state);
+
+// recording format, written by sensor_record_start() and read by the replay
+#define RECORD_MAGIC        0x43524e53      // "SNRC"
+#define RECORD_VERSION      2
+#define RECORD_CHUNK_SIZE   4096
+
+#define RECORD_ENCODING_RAW     0
+#define RECORD_ENCODING_DELTA   1
+
+struct sensor_record_file_s {
+    unsigned int magic;
+    unsigned short version;
+    unsigned short header_size;
+    unsigned int chunk_size;
+    unsigned int record_size;   // 0 when the records are encoded
+    unsigned int chunks;        // chunks in use after the header
+    unsigned int dropped;       // samples lost on a full file
+    unsigned int closed;
+    unsigned int types;         // mask of the recorded sensor_type_e
+    unsigned int encoding;
+    float resolution[CB_NUMBERS];   // quantization step of the encoded values
+};
+
+struct sensor_record_chunk_s {
+    unsigned int type;
+    unsigned int count;
+};
+
+struct sensor_record_sample_s {
+    unsigned long long time_stamp;
+    int accuracy;
+    float values[3];
+};
+
+#define RECORD_PER_CHUNK    ((RECORD_CHUNK_SIZE - sizeof(struct sensor_record_chunk_s)) / sizeof(struct sensor_record_sample_s))
+
+// reads the records of one chunk in order, of either encoding
+struct sensor_record_cursor_s {
+    const unsigned char* p;
+    const unsigned char* end;
+    unsigned int left;
+    unsigned int encoding;
+    float resolution;
+    unsigned long long time_stamp;
+    int accuracy;
+    int q[3];
+};
+
+void _sensor_record_feed(struct sensor_record_s* record, sensor_type_e type, sensor_data_t* data, int data_num);
+void _sensor_record_release(sensor_h handle);
+int _sensor_record_map(const char* path, char** map, size_t* size);
+void _sensor_record_cursor_init(struct sensor_record_cursor_s* cursor, const struct sensor_record_file_s* file, const struct sensor_record_chunk_s* chunk);
+int _sensor_record_cursor_next(struct sensor_record_cursor_s* cursor, struct sensor_record_sample_s* sample);
+
+void _sensor_share_feed(struct sensor_share_s* share, sensor_type_e type, sensor_data_t* data, int data_num);
+void _sensor_share_release(sensor_h handle);
+
+struct timespec;
+void _sensor_latency_feed(struct sensor_latency_s* latency, sensor_type_e type, const struct timespec* now, sensor_data_t* data, int data_num);
+int _sensor_latency_create(sensor_h handle, sensor_type_e type);
+void _sensor_latency_release(sensor_h handle);
+
+void _sensor_jitter_feed(sensor_h handle, sensor_type_e type, sensor_data_t* data, int data_num);
+void _sensor_jitter_release(sensor_h handle);
+
+// spans of sensor_trace_export(), a disabled trace costs a load per span
+enum _sensor_trace_span {
+    TRACE_CONNECT,
+    TRACE_REGISTER,
+    TRACE_UNREGISTER,
+    TRACE_GET_DATA,
+    TRACE_DISPATCH,
+    TRACE_USER_CALLBACK,
+};
+
+extern volatile int _sensor_trace_on;
+unsigned long long _sensor_trace_now(void);
+void _sensor_trace_add(int span, int type, unsigned long long begin, unsigned long long end);
+
+#define _TRACE_BEGIN() (_sensor_trace_on ? _sensor_trace_now() : 0)
+#define _TRACE_END(span, type, begin) \
+    do { \
+        if(begin != 0) \
+            _sensor_trace_add(span, type, begin, _sensor_trace_now()); \
+    } while(0)
+
 
 #ifdef __cplusplus
 }
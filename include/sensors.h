@@ -81,7 +81,9 @@ typedef enum
 	SENSOR_MOTION_SHAKE,                     /**< Shake motion sensor */
 	SENSOR_MOTION_DOUBLETAP,                 /**< Double tap motion sensor */
     SENSOR_MOTION_PANNING,                   /**< Panning motion sensor */
-    SENSOR_MOTION_FACEDOWN                   /**< Face to down motion sensor */
+    SENSOR_MOTION_FACEDOWN,                  /**< Face to down motion sensor */
+    SENSOR_DEVICE_ORIENTATION,               /**< Screen rotation virtual sensor computed from the accelerometer */
+    SENSOR_PEDOMETER                         /**< Step counter virtual sensor computed from the accelerometer */
 } sensor_type_e;
 /**
  * @}
@@ -440,6 +442,10 @@ typedef void (*sensor_motion_facedown_event_cb) ( unsigned long long timestamp,
  * @details
  * You need to check availability of a sensor first because this sensor may not be supported on the device.
  *
+ * @remark On a device without a motion engine, #SENSOR_MOTION_SNAP, #SENSOR_MOTION_SHAKE, #SENSOR_MOTION_DOUBLETAP
+ * and #SENSOR_MOTION_FACEDOWN are supported as long as the accelerometer is. They are then detected in the library
+ * from the accelerometer stream, registered at 100Hz.
+ *
  * @param[in]   type        The sensor type to check
  * @param[out]  supported   @c true if this sensor type is supported, otherwise @c false
  *
@@ -495,6 +501,8 @@ int sensor_create(sensor_h *sensor);
  *
  * @remark After this function is called, the attached sensor will be detached and 
  *		the corresponding sensor connection will be released.
+ * @remark It may be called from a callback of @a sensor: the callback gets no more samples, and the handle is
+ *		freed once the callback returns.
  *
  * @param[in] sensor	The sensor handle
  *
@@ -527,7 +535,8 @@ int sensor_destroy(sensor_h sensor);
  * @post This function invokes sensor_calibration_cb(), sensor_accelerometer_event_cb(), sensor_magnetic_event_cb(),
  * sensor_orientation_event_cb(), sensor_gyroscope_event_cb(), sensor_light_event_cb(),
  * sensor_proximity_event_cb(), sensor_motion_snap_event_cb(), sensor_motion_shake_event_cb(),
- * sensor_motion_doubletap_event_cb(), sensor_motion_panning_event_cb(), or sensor_motion_facedown_event_cb().
+ * sensor_motion_doubletap_event_cb(), sensor_motion_panning_event_cb(), sensor_motion_facedown_event_cb(),
+ * sensor_device_orientation_event_cb(), or sensor_pedometer_event_cb().
  *
  * @see sensor_stop()
  */
@@ -1738,7 +1747,7 @@ int sensor_util_get_inclination(float I[], float* inclination);
  * Compute the device's orientation based on the rotation matrix
  *
  * @details
- * When it returns, they array values is filled with the result:
+ * When it returns, they array values is filled with the result, in radians:
  *  - values[0]: azimuth, rotation around the Z axis.
  *  - values[1]: pitch, rotation around the X axis.
  *  - values[2]: roll, rotation around the Y axis.
@@ -1767,7 +1776,7 @@ int sensor_util_get_orientation(float R[], float values[]);
  * @details
  * Given a current rotation matrix (R) and a previous rotation matrix (prevR) computes 
  * the rotation around the x,y, and z axes which transforms prevR to R. 
- * outputs a 3 element vector containing the x,y, and z angle change at indexes 0, 1, and 2 respectively. \n
+ * outputs a 3 element vector containing the x,y, and z angle change at indexes 0, 1, and 2 respectively, in radians. \n
  *
  * @remark
  * Each input matrix is 3x3 matrix like this form:
@@ -1791,9 +1800,13 @@ int sensor_util_get_angle_change(float R[], float prevR[], float angleChange[]);
  * @brief
  * Getting the declination of the horizontal component of the magnetic field from true north, in degrees
  *
- * @param[in]  latitude     Latitude in geodetic coordinates 
- * @param[in]  longitude    Longitude in geodetic coordinates
- * @param[in]  altitude     Altitude in geodetic coordinates
+ * @remark
+ * The field is computed with the World Magnetic Model 2025 at the current date, east declinations are positive.
+ * Past the five years of the model, it is computed at the end of its validity.
+ *
+ * @param[in]  latitude     Latitude in geodetic coordinates, in degrees
+ * @param[in]  longitude    Longitude in geodetic coordinates, in degrees
+ * @param[in]  altitude     Altitude in geodetic coordinates, in meters
  * @param[out] declination  The declination of the horizontal component of the magnetic field in degrees.
  *
  * @return      0 on success, otherwise a negative error value
@@ -1807,6 +1820,7 @@ int sensor_util_get_declination(float latitude, float longitude, float altitude,
  * 
  * @remark
  * This function can be used to determine the proximity to device from other object like human face.
+ * A distance under the range of the proximity sensor is near.
  *
  * @param[in] distance      Distance in centimeter from proximity sensor.
  * @param[out] is_near      proximity to device from other object.
@@ -1818,6 +1832,1739 @@ int sensor_util_is_near(float distance, bool *is_near);
  */
 
 
+/**
+ * @addtogroup CAPI_SYSTEM_SENSOR_STATISTICS_MODULE
+ * @{
+ */
+
+/**
+ * @brief The handle of windowed statistics aggregated on a sensor stream.
+ */
+typedef struct sensor_stats_s* sensor_stats_h;
+
+/**
+ * @brief Summary of the samples inside the current statistics window.
+ *
+ * @remark Light and proximity sensors report a single value, only index 0 of each array is meaningful for them.
+ */
+typedef struct
+{
+    unsigned long long timestamp;   /**< Time stamp of the newest sample in the window */
+    int count;                      /**< Number of samples in the window */
+    float mean[3];                  /**< Mean of each axis */
+    float variance[3];              /**< Population variance of each axis */
+    float min[3];                   /**< Minimum of each axis */
+    float max[3];                   /**< Maximum of each axis */
+    float rms[3];                   /**< Root mean square of each axis */
+} sensor_stats_summary_s;
+
+/**
+ * @brief Called once per window with the summary of the window that just elapsed.
+ *
+ * @param[in] summary       The summary of the elapsed window
+ * @param[in] user_data     The user data passed from the callback registration function
+ *
+ * @see sensor_stats_set_window_cb()
+ * @see sensor_stats_unset_window_cb()
+ */
+typedef void (*sensor_stats_window_cb)(const sensor_stats_summary_s *summary, void *user_data);
+
+/**
+ * @brief Creates a rolling statistics aggregator on the given sensor stream.
+ * @details
+ * The aggregator keeps mean, variance, min, max and RMS over the samples of the last @a window_ms milliseconds.
+ * It is updated in constant time for each sample delivered to @a sensor, whether or not
+ * a per-sample callback is registered for @a type.
+ *
+ * @remark The window holds at most one sample per millisecond, older samples are dropped first when the stream is faster.
+ * @remark All aggregators are destroyed by sensor_destroy().
+ *
+ * @param[in]   sensor      The sensor handle
+ * @param[in]   type        The sensor type, except motion sensors
+ * @param[in]   window_ms   The length of the window in milliseconds
+ * @param[out]  stats       A new statistics handle
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter
+ * @retval      #SENSOR_ERROR_OUT_OF_MEMORY         Out of memory
+ * @retval      #SENSOR_ERROR_NOT_SUPPORTED         The sensor type is not supported in current device
+ * @retval      #SENSOR_ERROR_IO_ERROR              I/O error
+ * @retval      #SENSOR_ERROR_OPERATION_FAILED      Operation failed
+ *
+ * @pre sensor_start() must be called for @a type to feed the aggregator.
+ *
+ * @see sensor_stats_destroy()
+ * @see sensor_stats_get()
+ */
+int sensor_stats_create(sensor_h sensor, sensor_type_e type, int window_ms, sensor_stats_h *stats);
+
+/**
+ * @brief Destroys the statistics aggregator.
+ *
+ * @param[in]   stats       The statistics handle
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter
+ *
+ * @see sensor_stats_create()
+ */
+int sensor_stats_destroy(sensor_stats_h stats);
+
+/**
+ * @brief Gets the summary of the current window.
+ *
+ * @remark This function does not take any lock and can be called from any thread.
+ *
+ * @param[in]   stats       The statistics handle
+ * @param[out]  summary     The summary of the current window
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter
+ */
+int sensor_stats_get(sensor_stats_h stats, sensor_stats_summary_s *summary);
+
+/**
+ * @brief Registers a callback function to be invoked once per elapsed window.
+ *
+ * @param[in]   stats       The statistics handle
+ * @param[in]   callback    The callback function to register
+ * @param[in]   user_data   The user data to be passed to the callback function
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter
+ *
+ * @see sensor_stats_window_cb()
+ * @see sensor_stats_unset_window_cb()
+ */
+int sensor_stats_set_window_cb(sensor_stats_h stats, sensor_stats_window_cb callback, void *user_data);
+
+/**
+ * @brief Unregisters the window callback function.
+ *
+ * @param[in]   stats       The statistics handle
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter
+ *
+ * @see sensor_stats_set_window_cb()
+ */
+int sensor_stats_unset_window_cb(sensor_stats_h stats);
+
+/**
+ * @}
+ */
+
+/**
+ * @addtogroup CAPI_SYSTEM_SENSOR_GYROSCOPE_MODULE
+ * @{
+ */
+
+/**
+ * @brief The handle of a gyroscope integrator.
+ */
+typedef struct sensor_gyro_integrator_s* sensor_gyro_integrator_h;
+
+/**
+ * @brief Creates an integrator that accumulates the gyroscope rates into an orientation quaternion.
+ * @details
+ * The integrator runs inside the gyroscope event dispatch and uses the time stamps of the samples
+ * as integration step, so no gyroscope callback is needed by the application.
+ * The orientation starts from the identity quaternion when the integrator is created.
+ *
+ * @remark All integrators are destroyed by sensor_destroy().
+ *
+ * @param[in]   sensor      The sensor handle
+ * @param[out]  integrator  A new integrator handle
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter
+ * @retval      #SENSOR_ERROR_OUT_OF_MEMORY         Out of memory
+ * @retval      #SENSOR_ERROR_NOT_SUPPORTED         The gyroscope is not supported in current device
+ * @retval      #SENSOR_ERROR_IO_ERROR              I/O error
+ * @retval      #SENSOR_ERROR_OPERATION_FAILED      Operation failed
+ *
+ * @pre sensor_start() must be called for #SENSOR_GYROSCOPE to feed the integrator.
+ *
+ * @see sensor_gyro_integrator_destroy()
+ * @see sensor_gyro_integrator_get()
+ */
+int sensor_gyro_integrator_create(sensor_h sensor, sensor_gyro_integrator_h *integrator);
+
+/**
+ * @brief Destroys the gyroscope integrator.
+ *
+ * @param[in]   integrator  The integrator handle
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter
+ *
+ * @see sensor_gyro_integrator_create()
+ */
+int sensor_gyro_integrator_destroy(sensor_gyro_integrator_h integrator);
+
+/**
+ * @brief Resets the integrated orientation to the identity quaternion.
+ *
+ * @remark The reset takes effect with the next gyroscope sample.
+ *
+ * @param[in]   integrator  The integrator handle
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter
+ */
+int sensor_gyro_integrator_reset(sensor_gyro_integrator_h integrator);
+
+/**
+ * @brief Gets the integrated orientation.
+ *
+ * @remark This function does not take any lock and can be called from any thread.
+ *
+ * @param[in]   integrator  The integrator handle
+ * @param[out]  q           The orientation quaternion in the same order as the rotation vector:
+ *                          x*sin(θ/2), y*sin(θ/2), z*sin(θ/2), cos(θ/2)
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter
+ */
+int sensor_gyro_integrator_get(sensor_gyro_integrator_h integrator, float q[4]);
+
+/**
+ * @}
+ */
+
+/**
+ * @addtogroup CAPI_SYSTEM_SENSOR_DEVICE_ORIENTATION_MODULE
+ * @{
+ */
+
+/**
+ * @brief	Enumerations of screen rotation reported by the device orientation sensor.
+ */
+typedef enum
+{
+    SENSOR_DEVICE_ORIENTATION_0,        /**< Portrait, top of the device up */
+    SENSOR_DEVICE_ORIENTATION_90,       /**< Landscape, top of the device to the right */
+    SENSOR_DEVICE_ORIENTATION_180,      /**< Portrait, top of the device down */
+    SENSOR_DEVICE_ORIENTATION_270,      /**< Landscape, top of the device to the left */
+} sensor_device_orientation_e;
+
+/**
+ * @brief Called when the screen rotation of the device changes.
+ *
+ * @param[in] timestamp     The time stamp of the accelerometer sample that confirmed the change
+ * @param[in] orientation   The new screen rotation
+ * @param[in] user_data     The user data passed from the callback registration function
+ *
+ * @pre sensor_start() will invoke this callback if you register this callback using sensor_device_orientation_set_cb().
+ * @see sensor_device_orientation_set_cb()
+ * @see sensor_device_orientation_unset_cb()
+ */
+typedef void (*sensor_device_orientation_event_cb)(unsigned long long timestamp, sensor_device_orientation_e orientation, void *user_data);
+
+/**
+ * @brief	Registers a callback function to be invoked when the screen rotation changes.
+ * @details
+ * The rotation is computed in the library from the accelerometer stream.
+ * It is not updated while the device lies flat or is shaken, a new rotation has to
+ * pass a hysteresis band and stay stable for 200 milliseconds before it is reported.
+ * The callback is called only when the rotation changes, never for each accelerometer sample.
+ *
+ * @param[in]   sensor      The sensor handle
+ * @param[in]   callback    The callback function to register
+ * @param[in]   user_data   The user data to be passed to the callback function
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter
+ * @retval      #SENSOR_ERROR_OUT_OF_MEMORY         Out of memory
+ * @retval      #SENSOR_ERROR_NOT_SUPPORTED         The accelerometer is not supported in current device
+ * @retval      #SENSOR_ERROR_IO_ERROR              I/O error
+ * @retval      #SENSOR_ERROR_OPERATION_FAILED      Operation failed
+ *
+ * @post sensor_device_orientation_event_cb() will be invoked after sensor_start() is called with #SENSOR_DEVICE_ORIENTATION.
+ *
+ * @see sensor_device_orientation_event_cb()
+ * @see sensor_device_orientation_unset_cb()
+ */
+int sensor_device_orientation_set_cb(sensor_h sensor, sensor_device_orientation_event_cb callback, void *user_data);
+
+/**
+ * @brief	Unregister the device orientation callback function.
+ *
+ * @param[in]   sensor     The sensor handle
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                    Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER       Invalid parameter
+ * @retval      #SENSOR_ERROR_IO_ERROR                I/O error
+ * @retval      #SENSOR_ERROR_OPERATION_FAILED        Operation failed
+ *
+ * @see sensor_device_orientation_set_cb()
+ */
+int sensor_device_orientation_unset_cb(sensor_h sensor);
+
+/**
+ * @}
+ */
+
+/**
+ * @addtogroup CAPI_SYSTEM_SENSOR_PEDOMETER_MODULE
+ * @{
+ */
+
+/**
+ * @brief Called when new steps are detected.
+ *
+ * @param[in] timestamp     The time stamp of the accelerometer sample of the last detected step
+ * @param[in] steps         The number of steps detected since the previous call
+ * @param[in] user_data     The user data passed from the callback registration function
+ *
+ * @pre sensor_start() will invoke this callback if you register this callback using sensor_pedometer_set_cb().
+ * @see sensor_pedometer_set_cb()
+ * @see sensor_pedometer_unset_cb()
+ */
+typedef void (*sensor_pedometer_event_cb)(unsigned long long timestamp, int steps, void *user_data);
+
+/**
+ * @brief	Registers a callback function to be invoked when steps are detected.
+ * @details
+ * Steps are detected in the library from the magnitude of the accelerometer stream,
+ * band-pass filtered and searched for peaks against a threshold that adapts to the walking intensity.
+ * Steps are only reported once four regular steps have been seen in a row, and then one by one.
+ *
+ * @remark The accelerometer is listened to at 20ms while the callback is set, or at the faster interval another consumer asks for.
+ *
+ * @param[in]   sensor      The sensor handle
+ * @param[in]   callback    The callback function to register
+ * @param[in]   user_data   The user data to be passed to the callback function
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter
+ * @retval      #SENSOR_ERROR_OUT_OF_MEMORY         Out of memory
+ * @retval      #SENSOR_ERROR_NOT_SUPPORTED         The accelerometer is not supported in current device
+ * @retval      #SENSOR_ERROR_IO_ERROR              I/O error
+ * @retval      #SENSOR_ERROR_OPERATION_FAILED      Operation failed
+ *
+ * @post sensor_pedometer_event_cb() will be invoked after sensor_start() is called with #SENSOR_PEDOMETER.
+ *
+ * @see sensor_pedometer_event_cb()
+ * @see sensor_pedometer_unset_cb()
+ */
+int sensor_pedometer_set_cb(sensor_h sensor, sensor_pedometer_event_cb callback, void *user_data);
+
+/**
+ * @brief	Unregister the pedometer callback function.
+ *
+ * @param[in]   sensor     The sensor handle
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                    Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER       Invalid parameter
+ * @retval      #SENSOR_ERROR_IO_ERROR                I/O error
+ * @retval      #SENSOR_ERROR_OPERATION_FAILED        Operation failed
+ *
+ * @see sensor_pedometer_set_cb()
+ */
+int sensor_pedometer_unset_cb(sensor_h sensor);
+
+/**
+ * @}
+ */
+
+/**
+ * @addtogroup CAPI_SYSTEM_SENSOR_SPECTRUM_MODULE
+ * @{
+ */
+
+/**
+ * @brief The handle of a vibration spectrum analyzer on a sensor stream.
+ */
+typedef struct sensor_spectrum_s* sensor_spectrum_h;
+
+/**
+ * @brief Spectrum of one window of samples.
+ *
+ * @remark The band energies point to buffers owned by the analyzer, they are only valid during the callback.
+ */
+typedef struct
+{
+    unsigned long long timestamp;   /**< Time stamp of the last sample of the window */
+    float sample_rate;              /**< Sample rate in Hz, measured from the time stamps of the window */
+    int bands;                      /**< Number of bands in each band_energy array */
+    float peak_frequency[3];        /**< Frequency in Hz of the strongest bin of each axis */
+    float peak_power[3];            /**< Power of the strongest bin of each axis */
+    const float *band_energy[3];    /**< Energy of each band of each axis, as a mean square of the signal */
+} sensor_spectrum_window_s;
+
+/**
+ * @brief Called once per window with the spectrum of the window that just filled.
+ *
+ * @param[in] window        The spectrum of the window
+ * @param[in] user_data     The user data passed from the callback registration function
+ *
+ * @see sensor_spectrum_set_window_cb()
+ * @see sensor_spectrum_unset_window_cb()
+ */
+typedef void (*sensor_spectrum_window_cb)(const sensor_spectrum_window_s *window, void *user_data);
+
+/**
+ * @brief Creates a vibration spectrum analyzer on the given sensor stream.
+ * @details
+ * Every @a window_size samples, the mean of each axis is removed, a Hann window is applied and
+ * the power spectrum is computed with a real FFT. The bins from the first one up to the Nyquist frequency
+ * are split into @a bands bands of equal width.
+ * Windows do not overlap, and every buffer is allocated here so that no memory is allocated per window.
+ *
+ * @remark If @a type is not registered yet, it is registered with @a interval_ms.
+ * @remark All analyzers are destroyed by sensor_destroy().
+ *
+ * @param[in]   sensor          The sensor handle
+ * @param[in]   type            #SENSOR_ACCELEROMETER, #SENSOR_MAGNETIC or #SENSOR_GYROSCOPE
+ * @param[in]   interval_ms     The interval sensor events are delivered at (in milliseconds)
+ * @param[in]   window_size     The number of samples of a window, a power of two between 16 and 8192
+ * @param[in]   bands           The number of bands, between 1 and @a window_size / 2
+ * @param[out]  spectrum        A new spectrum handle
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter
+ * @retval      #SENSOR_ERROR_OUT_OF_MEMORY         Out of memory
+ * @retval      #SENSOR_ERROR_NOT_SUPPORTED         The sensor type is not supported in current device
+ * @retval      #SENSOR_ERROR_IO_ERROR              I/O error
+ * @retval      #SENSOR_ERROR_OPERATION_FAILED      Operation failed
+ *
+ * @pre sensor_start() must be called for @a type to feed the analyzer.
+ *
+ * @see sensor_spectrum_destroy()
+ * @see sensor_spectrum_set_window_cb()
+ */
+int sensor_spectrum_create(sensor_h sensor, sensor_type_e type, int interval_ms, int window_size, int bands, sensor_spectrum_h *spectrum);
+
+/**
+ * @brief Destroys the spectrum analyzer.
+ *
+ * @param[in]   spectrum    The spectrum handle
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter
+ *
+ * @see sensor_spectrum_create()
+ */
+int sensor_spectrum_destroy(sensor_spectrum_h spectrum);
+
+/**
+ * @brief Registers a callback function to be invoked once per window.
+ *
+ * @param[in]   spectrum    The spectrum handle
+ * @param[in]   callback    The callback function to register
+ * @param[in]   user_data   The user data to be passed to the callback function
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter
+ *
+ * @see sensor_spectrum_window_cb()
+ * @see sensor_spectrum_unset_window_cb()
+ */
+int sensor_spectrum_set_window_cb(sensor_spectrum_h spectrum, sensor_spectrum_window_cb callback, void *user_data);
+
+/**
+ * @brief Unregisters the window callback function.
+ * @details The samples of the window being filled are dropped.
+ *
+ * @param[in]   spectrum    The spectrum handle
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter
+ *
+ * @see sensor_spectrum_set_window_cb()
+ */
+int sensor_spectrum_unset_window_cb(sensor_spectrum_h spectrum);
+
+/**
+ * @}
+ */
+
+/**
+ * @addtogroup CAPI_SYSTEM_SENSOR_SYNC_MODULE
+ * @{
+ */
+
+/**
+ * @brief The handle of a synchronizer of the accelerometer, gyroscope and magnetic streams.
+ */
+typedef struct sensor_sync_s* sensor_sync_h;
+
+/**
+ * @brief Called once per frame with the values of the three streams at the same time stamp.
+ *
+ * @remark The arrays are only valid during the callback.
+ *
+ * @param[in] timestamp     The time stamp of the frame, a multiple of the frame interval
+ * @param[in] accel         The accelerometer values on x, y and z axis
+ * @param[in] gyro          The gyroscope values on x, y and z axis
+ * @param[in] mag           The magnetic sensor values on x, y and z axis
+ * @param[in] user_data     The user data passed from the callback registration function
+ *
+ * @see sensor_sync_set_frame_cb()
+ * @see sensor_sync_unset_frame_cb()
+ */
+typedef void (*sensor_frame_cb)(unsigned long long timestamp, const float accel[3], const float gyro[3], const float mag[3], void *user_data);
+
+/**
+ * @brief Called once per frame, right after sensor_frame_cb(), with the orientation at the same time stamp.
+ *
+ * @param[in] timestamp     The time stamp of the frame
+ * @param[in] azimuth       The azimuth in degrees [0 ~ 360]
+ * @param[in] pitch         The pitch in degrees [-180 ~ 180]
+ * @param[in] roll          The roll in degrees [-90 ~ 90]
+ * @param[in] user_data     The user data passed from the callback registration function
+ *
+ * @see sensor_sync_set_orientation_cb()
+ * @see sensor_orientation_event_cb()
+ */
+typedef void (*sensor_orientation_frame_cb)(unsigned long long timestamp, float azimuth, float pitch, float roll, void *user_data);
+
+/**
+ * @brief Creates a synchronizer that emits aligned frames of the accelerometer, gyroscope and magnetic streams.
+ * @details
+ * Each stream is buffered briefly and resampled on a common clock, every multiple of @a interval_ms.
+ * Vectors are interpolated linearly between the two samples around the frame time, the orientation is interpolated
+ * with SLERP. A frame is emitted as soon as every stream has a sample at or after its time stamp,
+ * and at the latest when the newest sample of any stream is @a max_latency_ms past it;
+ * a stream that is late then holds its last value.
+ *
+ * @remark The streams that are not registered yet are registered with @a interval_ms.
+ * @remark A stream that has not delivered any sample within @a max_latency_ms is reported as zeros.
+ * @remark All synchronizers are destroyed by sensor_destroy().
+ *
+ * @param[in]   sensor          The sensor handle
+ * @param[in]   interval_ms     The interval between frames in milliseconds
+ * @param[in]   max_latency_ms  The longest a frame is held waiting for a late stream, in milliseconds
+ * @param[out]  sync            A new synchronizer handle
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter
+ * @retval      #SENSOR_ERROR_OUT_OF_MEMORY         Out of memory
+ * @retval      #SENSOR_ERROR_NOT_SUPPORTED         One of the sensors is not supported in current device
+ * @retval      #SENSOR_ERROR_IO_ERROR              I/O error
+ * @retval      #SENSOR_ERROR_OPERATION_FAILED      Operation failed
+ *
+ * @pre sensor_start() must be called for #SENSOR_ACCELEROMETER, #SENSOR_GYROSCOPE and #SENSOR_MAGNETIC to feed the synchronizer.
+ *
+ * @see sensor_sync_destroy()
+ * @see sensor_sync_set_frame_cb()
+ */
+int sensor_sync_create(sensor_h sensor, int interval_ms, int max_latency_ms, sensor_sync_h *sync);
+
+/**
+ * @brief Destroys the synchronizer.
+ *
+ * @param[in]   sync        The synchronizer handle
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter
+ *
+ * @see sensor_sync_create()
+ */
+int sensor_sync_destroy(sensor_sync_h sync);
+
+/**
+ * @brief Registers a callback function to be invoked once per frame.
+ *
+ * @param[in]   sync        The synchronizer handle
+ * @param[in]   callback    The callback function to register
+ * @param[in]   user_data   The user data to be passed to the callback function
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter
+ *
+ * @see sensor_frame_cb()
+ * @see sensor_sync_unset_frame_cb()
+ */
+int sensor_sync_set_frame_cb(sensor_sync_h sync, sensor_frame_cb callback, void *user_data);
+
+/**
+ * @brief Unregisters the frame callback function.
+ * @details The buffered samples are dropped.
+ *
+ * @param[in]   sync        The synchronizer handle
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter
+ *
+ * @see sensor_sync_set_frame_cb()
+ */
+int sensor_sync_unset_frame_cb(sensor_sync_h sync);
+
+/**
+ * @brief Adds the orientation stream to the frames and registers a callback function to receive it.
+ * @details Frames then also wait for the orientation stream, within the same latency bound.
+ *
+ * @param[in]   sync        The synchronizer handle
+ * @param[in]   callback    The callback function to register
+ * @param[in]   user_data   The user data to be passed to the callback function
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter
+ * @retval      #SENSOR_ERROR_NOT_SUPPORTED         The orientation sensor is not supported in current device
+ * @retval      #SENSOR_ERROR_IO_ERROR              I/O error
+ * @retval      #SENSOR_ERROR_OPERATION_FAILED      Operation failed
+ *
+ * @pre sensor_start() must be called for #SENSOR_ORIENTATION to feed the synchronizer.
+ *
+ * @see sensor_orientation_frame_cb()
+ * @see sensor_sync_unset_orientation_cb()
+ */
+int sensor_sync_set_orientation_cb(sensor_sync_h sync, sensor_orientation_frame_cb callback, void *user_data);
+
+/**
+ * @brief Removes the orientation stream from the frames and unregisters its callback function.
+ *
+ * @param[in]   sync        The synchronizer handle
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter
+ * @retval      #SENSOR_ERROR_IO_ERROR              I/O error
+ * @retval      #SENSOR_ERROR_OPERATION_FAILED      Operation failed
+ *
+ * @see sensor_sync_set_orientation_cb()
+ */
+int sensor_sync_unset_orientation_cb(sensor_sync_h sync);
+
+/**
+ * @}
+ */
+
+/**
+ * @addtogroup CAPI_SYSTEM_SENSOR_ADAPTIVE_RATE_MODULE
+ * @{
+ */
+
+/**
+ * @brief Time spent by an adaptive rate stream at each of its intervals.
+ */
+typedef struct
+{
+    int full_interval_ms;               /**< Interval requested for the stream, 0 for the default one */
+    int floor_interval_ms;              /**< Interval while the device is still */
+    int current_interval_ms;            /**< Interval currently registered */
+    unsigned long long full_time_us;    /**< Time spent at the full interval, in microseconds of sample time */
+    unsigned long long floor_time_us;   /**< Time spent at the floor interval, in microseconds of sample time */
+    int switches;                       /**< Number of interval changes */
+} sensor_adaptive_rate_stats_s;
+
+/**
+ * @brief Lowers the rate of a stream while the device is still.
+ * @details
+ * Every sample of the stream is checked against a stillness threshold. Once the device has been still
+ * for two seconds, the event is registered again with @a floor_interval_ms.
+ * The first sample showing motion registers it back with the interval it was set with, so the full rate
+ * is restored within one sample at the floor interval.
+ *
+ * @remark The stream must already be registered, by a callback or by an in-library consumer.
+ * @remark The floor never makes the stream slower than the interval an in-library consumer of the stream
+ * asked for, such as the pedometer or the motion detection, the stream keeps the fastest of them.
+ * @remark Setting the callback of @a type again makes its new interval the full one.
+ *
+ * @param[in]   sensor              The sensor handle
+ * @param[in]   type                #SENSOR_ACCELEROMETER or #SENSOR_GYROSCOPE
+ * @param[in]   floor_interval_ms   The interval while the device is still (in milliseconds)
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter
+ * @retval      #SENSOR_ERROR_OUT_OF_MEMORY         Out of memory
+ * @retval      #SENSOR_ERROR_IO_ERROR              I/O error
+ * @retval      #SENSOR_ERROR_OPERATION_FAILED      Operation failed
+ *
+ * @see sensor_adaptive_rate_unset()
+ * @see sensor_adaptive_rate_get_stats()
+ */
+int sensor_adaptive_rate_set(sensor_h sensor, sensor_type_e type, int floor_interval_ms);
+
+/**
+ * @brief Stops adapting the rate of a stream and restores its full rate.
+ *
+ * @param[in]   sensor      The sensor handle
+ * @param[in]   type        The sensor type
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter
+ * @retval      #SENSOR_ERROR_IO_ERROR              I/O error
+ * @retval      #SENSOR_ERROR_OPERATION_FAILED      Operation failed
+ *
+ * @see sensor_adaptive_rate_set()
+ */
+int sensor_adaptive_rate_unset(sensor_h sensor, sensor_type_e type);
+
+/**
+ * @brief Gets the time spent by an adaptive rate stream at each interval.
+ *
+ * @remark This function does not take any lock and can be called from any thread.
+ *
+ * @param[in]   sensor      The sensor handle
+ * @param[in]   type        The sensor type
+ * @param[out]  stats       The interval statistics
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter, or the rate of @a type is not adaptive
+ *
+ * @see sensor_adaptive_rate_set()
+ */
+int sensor_adaptive_rate_get_stats(sensor_h sensor, sensor_type_e type, sensor_adaptive_rate_stats_s *stats);
+
+/**
+ * @}
+ */
+
+/**
+ * @addtogroup CAPI_SYSTEM_SENSOR_MAGNETIC_MODULE
+ * @{
+ */
+
+/**
+ * @brief Hard and soft-iron calibration of the magnetic sensor, computed in the library.
+ * @details A calibrated field is matrix * (raw - offset).
+ */
+typedef struct
+{
+    float offset[3];        /**< Hard-iron offset in micro-Tesla */
+    float matrix[3][3];     /**< Soft-iron correction, row major */
+    float field;            /**< Strength of the calibrated field in micro-Tesla, 0 until the fit is valid */
+    float error;            /**< RMS relative deviation of the calibrated field strength from @a field */
+    sensor_data_accuracy_e accuracy;    /**< Accuracy reported with the calibrated samples */
+} sensor_magnetic_calibration_s;
+
+/**
+ * @brief Enables or disables the calibration of the magnetic sensor in the library.
+ * @details
+ * An ellipsoid is fitted on the raw magnetic samples by recursive least squares, in constant time per sample and
+ * without allocation. Once the fit is valid, every sample is corrected for the hard-iron offset and the soft-iron distortion
+ * before it reaches sensor_magnetic_event_cb() and the other consumers of the stream, sensor_magnetic_read_data() included.
+ * Recordings and shared streams keep the raw samples.
+ * The accuracy passed with the samples is then the quality of the fit instead of the one of the sensor server:
+ * #SENSOR_DATA_ACCURACY_BAD until enough orientations have been seen, up to #SENSOR_DATA_ACCURACY_VERYGOOD
+ * when the calibrated field strength deviates less than 2%.
+ *
+ * @remark Samples only feed the fit when they are 4 micro-Tesla away from the previous one, so a still device does not degrade it.
+ *
+ * @param[in]   sensor      The sensor handle
+ * @param[in]   enable      @c true to calibrate, @c false to deliver the raw samples again and drop the fit
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter
+ * @retval      #SENSOR_ERROR_OUT_OF_MEMORY         Out of memory
+ *
+ * @see sensor_magnetic_auto_calibration_get()
+ */
+int sensor_magnetic_auto_calibration_set(sensor_h sensor, bool enable);
+
+/**
+ * @brief Gets the current calibration of the magnetic sensor.
+ *
+ * @remark Call this function from the thread the sensor events are delivered on.
+ *
+ * @param[in]   sensor          The sensor handle
+ * @param[out]  calibration     The current calibration
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter, or the calibration is not enabled
+ *
+ * @see sensor_magnetic_auto_calibration_set()
+ */
+int sensor_magnetic_auto_calibration_get(sensor_h sensor, sensor_magnetic_calibration_s *calibration);
+
+/**
+ * @}
+ */
+
+/**
+ * @addtogroup CAPI_SYSTEM_SENSOR_GYROSCOPE_MODULE
+ * @{
+ */
+
+/**
+ * @brief Bias of the gyroscope, estimated in the library.
+ */
+typedef struct
+{
+    float bias[3];          /**< Bias subtracted from the x, y and z rates in degrees/s */
+    bool valid;             /**< @c false until a rest period has been seen or a bias has been restored */
+} sensor_gyroscope_bias_s;
+
+/**
+ * @brief Enables or disables the compensation of the gyroscope bias in the library.
+ * @details
+ * The device is at rest when the variance of both the accelerometer and the gyroscope stays low for a second.
+ * During rest the bias of each axis follows the measured rate through an exponential filter.
+ * The bias is subtracted from every sample before it reaches sensor_gyroscope_event_cb() and the other consumers of the stream,
+ * sensor_gyroscope_read_data() included. Recordings and shared streams keep the raw rates.
+ *
+ * @remark The accelerometer is listened to at 20ms while the compensation is enabled. While it is not started, rest is detected on the gyroscope alone.
+ * @remark Save the bias with sensor_gyroscope_bias_get() and give it back with sensor_gyroscope_bias_restore()
+ * so that a new process compensates from its first sample.
+ *
+ * @param[in]   sensor      The sensor handle
+ * @param[in]   enable      @c true to compensate, @c false to deliver the raw rates again and drop the estimate
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter
+ * @retval      #SENSOR_ERROR_NOT_SUPPORTED         The accelerometer is not supported
+ * @retval      #SENSOR_ERROR_OUT_OF_MEMORY         Out of memory
+ * @retval      #SENSOR_ERROR_IO_ERROR              I/O error
+ * @retval      #SENSOR_ERROR_OPERATION_FAILED      Operation failed
+ *
+ * @see sensor_gyroscope_bias_get()
+ * @see sensor_gyroscope_bias_restore()
+ */
+int sensor_gyroscope_bias_compensation_set(sensor_h sensor, bool enable);
+
+/**
+ * @brief Gets the current estimate of the gyroscope bias.
+ *
+ * @remark Call this function from the thread the sensor events are delivered on.
+ *
+ * @param[in]   sensor      The sensor handle
+ * @param[out]  bias        The current estimate
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter, or the compensation is not enabled
+ *
+ * @see sensor_gyroscope_bias_compensation_set()
+ */
+int sensor_gyroscope_bias_get(sensor_h sensor, sensor_gyroscope_bias_s *bias);
+
+/**
+ * @brief Restores a gyroscope bias saved by sensor_gyroscope_bias_get().
+ * @details The restored bias is compensated at once, the next rest periods keep refining it.
+ *
+ * @param[in]   sensor      The sensor handle
+ * @param[in]   bias        The saved estimate, ignored if it is not valid
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter, or the compensation is not enabled
+ *
+ * @see sensor_gyroscope_bias_compensation_set()
+ */
+int sensor_gyroscope_bias_restore(sensor_h sensor, const sensor_gyroscope_bias_s *bias);
+
+/**
+ * @}
+ */
+
+/**
+ * @addtogroup CAPI_SYSTEM_SENSOR_STATE_MODULE
+ * @{
+ */
+
+/**
+ * @brief Keeps the calibration state of the handle in a file, so that a new process starts calibrated.
+ * @details
+ * The file is memory mapped. The state it holds is loaded at once into the calibrations that are enabled,
+ * and into the ones enabled later with sensor_magnetic_auto_calibration_set() or sensor_gyroscope_bias_compensation_set().
+ * The state is saved into the file every @a interval_ms of sensor time, when sensor_state_file_unset() is called and when the handle is destroyed.
+ * A save is a copy into the mapping, the sensor callbacks make no system call for it.
+ *
+ * @remark The file holds the magnetic calibration fit and the gyroscope bias. A file of another version, or one left by an interrupted save, is ignored and overwritten.
+ * @remark The state of a calibration that is not enabled is kept as it is in the file.
+ *
+ * @param[in]   sensor          The sensor handle
+ * @param[in]   path            The path of the state file, created if it does not exist
+ * @param[in]   interval_ms     The interval between two saves, 0 to only save on unset and destroy
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter
+ * @retval      #SENSOR_ERROR_OUT_OF_MEMORY         Out of memory
+ * @retval      #SENSOR_ERROR_IO_ERROR              The file cannot be created or mapped
+ *
+ * @see sensor_state_file_unset()
+ */
+int sensor_state_file_set(sensor_h sensor, const char *path, int interval_ms);
+
+/**
+ * @brief Saves the calibration state a last time and releases the state file.
+ *
+ * @param[in]   sensor          The sensor handle
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter
+ *
+ * @see sensor_state_file_set()
+ */
+int sensor_state_file_unset(sensor_h sensor);
+
+/**
+ * @}
+ */
+
+/**
+ * @addtogroup CAPI_SYSTEM_SENSOR_RECORD_MODULE
+ * @{
+ */
+
+/**
+ * @brief Enumerations of the encodings of a recording.
+ */
+typedef enum
+{
+    SENSOR_RECORD_FORMAT_RAW,           /**< Records of 24 bytes, the values as delivered */
+    SENSOR_RECORD_FORMAT_COMPRESSED,    /**< Delta coded records, the values rounded to the resolution of the sensor */
+} sensor_record_format_e;
+
+/**
+ * @brief Called for every sample of a recording.
+ *
+ * @param[in] type          The sensor type of the sample
+ * @param[in] timestamp     The time stamp of the sample in microseconds
+ * @param[in] accuracy      The accuracy of the sample
+ * @param[in] values        The three values of the sample
+ * @param[in] user_data     The user data passed from the foreach function
+ *
+ * @return      @c true to continue with the next sample, @c false to stop
+ *
+ * @see sensor_record_foreach_sample()
+ */
+typedef bool (*sensor_record_sample_cb)(sensor_type_e type, unsigned long long timestamp,
+		sensor_data_accuracy_e accuracy, const float values[3], void *user_data);
+
+/**
+ * @brief Sets the encoding of the next recordings of the handle.
+ * @details
+ * The raw encoding is the default. The compressed encoding stores a sample in about a third of the space:
+ * the time stamp as a varint delta, and every value rounded to the resolution sensor_get_spec() reports,
+ * as a delta to the previous value of the axis packed on the bits it needs.
+ * The values are then exact up to half of the resolution. A sensor without a resolution is rounded to 0.0001.
+ *
+ * @param[in]   sensor          The sensor handle
+ * @param[in]   format          The encoding
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter
+ *
+ * @see sensor_record_start()
+ */
+int sensor_record_set_format(sensor_h sensor, sensor_record_format_e format);
+
+/**
+ * @brief Starts recording the samples of the handle into a binary file.
+ * @details
+ * The samples are recorded as the sensor server delivers them, before the in-library calibrations, so that a replay
+ * with the calibrations enabled corrects them once.
+ * The file is allocated to @a max_size_kb on start and memory mapped, a sample is recorded without any system call.
+ * Once the file is full, the next samples are counted as dropped. The file is cut to its used size when the recording stops.
+ *
+ * The file is made of chunks of 4096 bytes in the byte order of the device:
+ *  - The first chunk holds the header: magic 0x43524e53, version 2 (16 bits), header size (16 bits),
+ *    chunk size, record size (0 when compressed), chunks in use after the header, dropped samples, closed flag,
+ *    mask of the recorded types and encoding (0 raw, 1 compressed), all 32 bits, then the float resolution of every type.
+ *  - Every other chunk holds the records of one type: type, record count, then the records.
+ *    A raw record is the time stamp (64 bits), the accuracy (32 bits) and three float values, 24 bytes.
+ *  - A compressed chunk restarts its deltas, so it can be decoded on its own. A record is:
+ *    a varint (LEB128) of the zigzag coded time stamp delta shifted left once, its low bit set when the accuracy changes;
+ *    the accuracy plus one in a byte when it changes; a byte of the bit width w;
+ *    then the zigzag coded deltas of the three values in resolution units, w bits each from the low bit, padded to a byte.
+ *    The first record of a chunk is a delta to 0 and always carries the accuracy.
+ *
+ * The record count of a chunk is updated after the record, a live recording can be read while it grows.
+ *
+ * @remark Only the streams already delivered to the handle are recorded, start them as usual.
+ *
+ * @param[in]   sensor          The sensor handle
+ * @param[in]   path            The path of the recording, overwritten if it exists
+ * @param[in]   types           The sensor types to record
+ * @param[in]   type_count      The number of entries in @a types
+ * @param[in]   max_size_kb     The size of the file in kilobytes, 8 at least
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter
+ * @retval      #SENSOR_ERROR_OUT_OF_MEMORY         Out of memory
+ * @retval      #SENSOR_ERROR_IO_ERROR              The file cannot be created, allocated or mapped
+ *
+ * @see sensor_record_stop()
+ * @see sensor_record_set_format()
+ */
+int sensor_record_start(sensor_h sensor, const char *path, const sensor_type_e *types, int type_count, unsigned int max_size_kb);
+
+/**
+ * @brief Stops the recording and closes its file.
+ * @details A recording still running is also stopped by sensor_destroy().
+ *
+ * @param[in]   sensor          The sensor handle
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter
+ *
+ * @see sensor_record_start()
+ */
+int sensor_record_stop(sensor_h sensor);
+
+/**
+ * @brief Reads the samples of a recording, of either encoding.
+ * @details
+ * The samples are decoded as they are read from the mapped file, a chunk at a time.
+ * They come in the order of the chunks: the samples of a type are in time order, and the types interleave by chunks.
+ * A recording still being written can be read, up to its last complete sample.
+ *
+ * @param[in]   path            The path of the recording
+ * @param[in]   callback        The callback function to invoke
+ * @param[in]   user_data       The user data to be passed to the callback function
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter, or the file is not a recording
+ * @retval      #SENSOR_ERROR_IO_ERROR              The file cannot be opened
+ *
+ * @see sensor_record_start()
+ */
+int sensor_record_foreach_sample(const char *path, sensor_record_sample_cb callback, void *user_data);
+
+/**
+ * @}
+ */
+
+/**
+ * @addtogroup CAPI_SYSTEM_SENSOR_REPLAY_MODULE
+ * @{
+ */
+
+/**
+ * @brief Serves the sensors of the process from a recording instead of the sensor framework.
+ * @details
+ * The recording is a file of sensor_record_start(). The recorded types are the supported sensors, started handles
+ * receive the recorded samples with their original time stamps, on a thread of the library.
+ * The samples are delivered at their recorded timing divided by @a speed, or as fast as possible when @a speed is 0.
+ * The replay starts when the first sensor is started, and plays the file once.
+ *
+ * The replay can also be chosen without code change: the CAPI_SENSOR_REPLAY environment variable gives the path of the recording
+ * and CAPI_SENSOR_REPLAY_SPEED the speed, 1 by default. This function overrides the environment.
+ *
+ * @remark Call this function before any sensor handle is created, it fails while a handle exists.
+ * @remark The intervals asked with the callbacks are not applied, every stream is replayed at its recorded rate.
+ *
+ * @param[in]   path    The path of the recording, or @c NULL to use the sensor framework, or the mock when it is set, again
+ * @param[in]   speed   The replay speed, 1 for the original timing, 0 for as fast as possible
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter, the file is not a recording, or a handle exists
+ * @retval      #SENSOR_ERROR_OUT_OF_MEMORY         Out of memory
+ * @retval      #SENSOR_ERROR_IO_ERROR              The file cannot be opened
+ *
+ * @see sensor_record_start()
+ * @see sensor_replay_wait()
+ */
+int sensor_replay_set(const char *path, float speed);
+
+/**
+ * @brief Waits until the whole recording has been delivered.
+ *
+ * @remark Do not call this function from a sensor callback.
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     No replay is running
+ *
+ * @see sensor_replay_set()
+ */
+int sensor_replay_wait(void);
+
+/**
+ * @}
+ */
+
+/**
+ * @addtogroup CAPI_SYSTEM_SENSOR_MOCK_MODULE
+ * @{
+ */
+
+/**
+ * @brief Enumerations of the calls into the sensor framework whose failure can be injected in the mock.
+ */
+typedef enum
+{
+    SENSOR_MOCK_CALL_CONNECT,                   /**< Connection to a sensor, on the first use of a type by a handle */
+    SENSOR_MOCK_CALL_START,                     /**< Start of a sensor, by sensor_start() */
+    SENSOR_MOCK_CALL_STOP,                      /**< Stop of a sensor, by sensor_stop() */
+    SENSOR_MOCK_CALL_REGISTER,                  /**< Registration of a callback, by the sensor_*_set_cb() functions */
+    SENSOR_MOCK_CALL_UNREGISTER,                /**< Removal of a callback, by the sensor_*_unset_cb() functions */
+    SENSOR_MOCK_CALL_READ,                      /**< Read of the last sample, by the sensor_*_read_data() functions */
+} sensor_mock_call_e;
+
+/**
+ * @brief Description of a sensor of the mock.
+ */
+typedef struct
+{
+    const char *vendor;         /**< The vendor name, "mock" when @c NULL */
+    const char *model;          /**< The model name, "mock" when @c NULL */
+    float min_range;            /**< The minimal value of the sensor */
+    float max_range;            /**< The maximal value of the sensor */
+    float resolution;           /**< The resolution of the sensor */
+    int min_interval_ms;        /**< The shortest interval the sensor runs at, faster callbacks get this interval */
+} sensor_mock_spec_s;
+
+/**
+ * @brief A sample of a batch delivered by the mock.
+ */
+typedef struct
+{
+    unsigned long long timestamp;       /**< The time stamp in microseconds */
+    sensor_data_accuracy_e accuracy;    /**< The accuracy */
+    int values_num;                     /**< The number of values, up to 12 */
+    float values[12];                   /**< The values */
+} sensor_mock_sample_s;
+
+/**
+ * @brief Serves the sensors of the process from an in-process mock instead of the sensor framework.
+ * @details
+ * The mock has no sensor until sensor_mock_add() is called, the samples are pushed with sensor_mock_emit().
+ * It lets the library and its users run and be measured on a system without the sensor framework.
+ * The library built with WITHOUT_SENSOR_FRAMEWORK uses the mock in any case.
+ *
+ * The mock can also be chosen without code change, by setting the CAPI_SENSOR_MOCK environment variable to 1.
+ * This function overrides the environment.
+ *
+ * @remark Call this function before any sensor handle is created, it fails while a handle exists.
+ * @remark A running replay is stopped.
+ *
+ * @param[in]   enable      @c true to use the mock, @c false to use the sensor framework
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     A sensor handle exists
+ * @retval      #SENSOR_ERROR_NOT_SUPPORTED         The library is built without the sensor framework
+ *
+ * @see sensor_mock_add()
+ * @see sensor_mock_emit()
+ */
+int sensor_mock_set(bool enable);
+
+/**
+ * @brief Adds a sensor to the mock, or changes its description.
+ * @details
+ * The type is then supported, sensor_get_spec() returns the values of @a spec.
+ * The virtual sensors are supported when the sensor they are computed from is.
+ *
+ * @param[in]   type        The sensor type, not a virtual one
+ * @param[in]   spec        The description of the sensor
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter
+ *
+ * @see sensor_mock_reset()
+ */
+int sensor_mock_add(sensor_type_e type, const sensor_mock_spec_s *spec);
+
+/**
+ * @brief Makes the next calls of an operation into the mock fail.
+ * @details
+ * The operation returns @a code as the sensor framework would, -2 is reported as #SENSOR_ERROR_IO_ERROR by the
+ * functions that distinguish it. A @a count of 0 stops the failures.
+ *
+ * @param[in]   call        The operation
+ * @param[in]   code        The negative code returned
+ * @param[in]   count       The number of calls that fail, a negative count makes every call fail
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter
+ */
+int sensor_mock_fail(sensor_mock_call_e call, int code, int count);
+
+/**
+ * @brief Delays every call into the mock and every delivery of a sample, like a round trip to the sensor server.
+ *
+ * @param[in]   latency_us  The delay in microseconds, 0 for none
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ */
+int sensor_mock_set_latency(unsigned int latency_us);
+
+/**
+ * @brief Gets the interval a sensor of the mock is asked to run at.
+ * @details
+ * The interval is the shortest one of the started callbacks of the type, raised to the minimal interval of the sensor.
+ * It is 0 when no callback of the type is started, or when the started ones do not ask for an interval.
+ *
+ * @param[in]   type        The sensor type
+ * @param[out]  interval_ms The interval in milliseconds
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter
+ */
+int sensor_mock_get_interval(sensor_type_e type, int *interval_ms);
+
+/**
+ * @brief Delivers a sample of a sensor of the mock.
+ * @details
+ * The sample reaches the started callbacks of the type before this function returns, on the calling thread,
+ * and is the last sample returned by the read functions.
+ * A motion event takes its value from @a values[0], a panning event takes x and y from @a values[0] and @a values[1].
+ *
+ * @remark The timing of the samples is the caller's, the interval of the callbacks is not applied.
+ *
+ * @param[in]   type        The sensor type, not a virtual one
+ * @param[in]   timestamp   The time stamp of the sample in microseconds
+ * @param[in]   accuracy    The accuracy of the sample
+ * @param[in]   values      The values of the sample
+ * @param[in]   values_num  The number of values, up to 12
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter
+ * @retval      #SENSOR_ERROR_NOT_SUPPORTED         The type has not been added to the mock
+ */
+int sensor_mock_emit(sensor_type_e type, unsigned long long timestamp, sensor_data_accuracy_e accuracy, const float values[], int values_num);
+
+/**
+ * @brief Delivers a batch of samples of a sensor of the mock in a single event.
+ * @details
+ * The sensor framework delivers several samples in one event when it flushes a hardware FIFO.
+ * The batch reaches every started callback of the type before this function returns, on the calling thread.
+ *
+ * @param[in]   type        The sensor type, one of the data sensors
+ * @param[in]   samples     The samples, oldest first
+ * @param[in]   count       The number of samples, up to 128
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter
+ * @retval      #SENSOR_ERROR_NOT_SUPPORTED         The type has not been added to the mock
+ *
+ * @see sensor_mock_emit()
+ */
+int sensor_mock_emit_batch(sensor_type_e type, const sensor_mock_sample_s *samples, int count);
+
+/**
+ * @brief Removes the sensors of the mock, its failures and its latency.
+ *
+ * @remark Destroy every handle before resetting the mock.
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ */
+int sensor_mock_reset(void);
+
+/**
+ * @}
+ */
+
+/**
+ * @addtogroup CAPI_SYSTEM_SENSOR_SHARE_MODULE
+ * @{
+ */
+
+/**
+ * @brief The handle of a reader of shared sensor streams.
+ */
+typedef struct sensor_share_reader_s *sensor_share_reader_h;
+
+/**
+ * @brief A sample read from shared sensor streams.
+ */
+typedef struct
+{
+    sensor_type_e type;                 /**< The sensor type */
+    unsigned long long timestamp;       /**< The time stamp in microseconds */
+    sensor_data_accuracy_e accuracy;    /**< The accuracy */
+    float values[3];                    /**< The first three values, as delivered to the callbacks */
+} sensor_share_sample_s;
+
+/**
+ * @brief Publishes the samples of the handle to other processes.
+ * @details
+ * The samples of the given types are written, as the sensor server delivers them to the handle and before the in-library
+ * calibrations, into a ring of @a slots samples in the POSIX shared memory object @a name. Any number of local processes read them with sensor_share_reader_open(),
+ * so the streams are subscribed to the sensor framework once for all of them.
+ * The publisher never waits for a reader, a reader that falls more than @a slots samples behind loses the oldest ones.
+ * A publication costs no system call unless a reader is waiting.
+ *
+ * The name must not be in use by another live publisher. The object of a publisher that exited without stopping
+ * is taken over: its readers see it closed, and it is replaced by a new one.
+ * The object can be opened by the user and the group of the publisher.
+ *
+ * @remark Only the streams already delivered to the handle are published, start them as usual.
+ *
+ * @param[in]   sensor          The sensor handle
+ * @param[in]   name            The name of the shared memory object, starting with '/'
+ * @param[in]   types           The sensor types to publish
+ * @param[in]   type_count      The number of entries in @a types
+ * @param[in]   slots           The number of samples of the ring, a power of 2
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter
+ * @retval      #SENSOR_ERROR_OUT_OF_MEMORY         Out of memory
+ * @retval      #SENSOR_ERROR_IO_ERROR              The shared memory cannot be created, or the name is in use
+ *
+ * @see sensor_share_stop()
+ * @see sensor_share_reader_open()
+ */
+int sensor_share_start(sensor_h sensor, const char *name, const sensor_type_e *types, int type_count, unsigned int slots);
+
+/**
+ * @brief Stops publishing the samples of the handle.
+ * @details
+ * The readers read the samples left in the ring, then get #SENSOR_ERROR_IO_ERROR.
+ * Publishing is also stopped by sensor_destroy().
+ *
+ * @param[in]   sensor          The sensor handle
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter
+ *
+ * @see sensor_share_start()
+ */
+int sensor_share_stop(sensor_h sensor);
+
+/**
+ * @brief Attaches to the samples published by another process.
+ * @details The reader gets the samples published after it is opened. It needs no sensor handle.
+ *
+ * @param[in]   name            The name given to sensor_share_start()
+ * @param[out]  reader          The reader handle
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter, or the object is not a sensor ring
+ * @retval      #SENSOR_ERROR_OUT_OF_MEMORY         Out of memory
+ * @retval      #SENSOR_ERROR_IO_ERROR              No object of that name can be opened
+ *
+ * @see sensor_share_reader_close()
+ */
+int sensor_share_reader_open(const char *name, sensor_share_reader_h *reader);
+
+/**
+ * @brief Reads the next published samples.
+ * @details
+ * The samples are copied in publication order. When none is pending, the function waits up to @a timeout_ms
+ * for the next publication, and returns with a @a count of 0 if none comes.
+ *
+ * @remark A reader is used from one thread at a time.
+ *
+ * @param[in]   reader          The reader handle
+ * @param[out]  samples         The array receiving the samples
+ * @param[in]   max             The number of entries in @a samples
+ * @param[in]   timeout_ms      The longest wait in milliseconds, 0 not to wait, -1 to wait without limit
+ * @param[out]  count           The number of samples read
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter
+ * @retval      #SENSOR_ERROR_IO_ERROR              The publisher has stopped and every sample has been read
+ *
+ * @see sensor_share_reader_get_lost()
+ */
+int sensor_share_reader_read(sensor_share_reader_h reader, sensor_share_sample_s *samples, int max, int timeout_ms, int *count);
+
+/**
+ * @brief Gets the number of samples the reader missed, overwritten before they were read.
+ *
+ * @param[in]   reader          The reader handle
+ * @param[out]  lost            The number of samples lost since the reader was opened
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter
+ */
+int sensor_share_reader_get_lost(sensor_share_reader_h reader, unsigned long long *lost);
+
+/**
+ * @brief Detaches a reader.
+ *
+ * @param[in]   reader          The reader handle
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter
+ *
+ * @see sensor_share_reader_open()
+ */
+int sensor_share_reader_close(sensor_share_reader_h reader);
+
+/**
+ * @}
+ */
+
+/**
+ * @addtogroup CAPI_SYSTEM_SENSOR_MODULE
+ * @{
+ */
+
+/**
+ * @brief Number of buckets of the callback time histogram of #sensor_runtime_stats_s.
+ */
+#define SENSOR_STATS_CALLBACK_BUCKETS   16
+
+/**
+ * @brief Runtime counters of a sensor type in a handle, since the handle was created.
+ * @details
+ * Bucket 0 of @a callback_time counts the events whose user callbacks ran in less than 1 microsecond,
+ * bucket i those that took from 2^(i-1) to 2^i microseconds, the last bucket everything longer.
+ * A batch of samples delivered in one event is timed as a whole.
+ */
+typedef struct
+{
+    unsigned long long events;              /**< Events received for the type */
+    unsigned long long samples_delivered;   /**< Samples passed to the user callback */
+    unsigned long long samples_dropped;     /**< Samples received while the callback was not set or not started, and motion events filtered out */
+    unsigned long long unknown_events;      /**< Events of no known type received by the handle, the same for every type */
+    unsigned long long connect_calls;       /**< Connections made to the sensor framework */
+    unsigned long long read_calls;          /**< Data reads made to the sensor framework */
+    unsigned long long register_calls;      /**< Event registrations and unregistrations made to the sensor framework */
+    unsigned long long callback_time[SENSOR_STATS_CALLBACK_BUCKETS];   /**< Histogram of the time spent in the user callback per event */
+} sensor_runtime_stats_s;
+
+/**
+ * @brief Gets the runtime counters of a sensor type.
+ *
+ * @remark The counters are updated without a lock, this function can be called from any thread.
+ * Each counter is read atomically, but they are not a snapshot of a single instant.
+ *
+ * @param[in]   sensor      The sensor handle
+ * @param[in]   type        The sensor type
+ * @param[out]  stats       The counters
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter
+ */
+int sensor_get_stats(sensor_h sensor, sensor_type_e type, sensor_runtime_stats_s *stats);
+
+/**
+ * @}
+ */
+
+/**
+ * @addtogroup CAPI_SYSTEM_SENSOR_LATENCY_MODULE
+ * @{
+ */
+
+/**
+ * @brief Called when the 99th percentile of the sample ages of a window is over its budget.
+ *
+ * @remark It is called from the thread delivering the samples, before the user callback of the window's last sample.
+ *
+ * @param[in] type          The sensor type
+ * @param[in] p99_us        The 99th percentile of the ages in the window (in microseconds)
+ * @param[in] user_data     The user data passed from the callback registration function
+ *
+ * @see sensor_latency_set_budget_cb()
+ */
+typedef void (*sensor_latency_budget_cb)(sensor_type_e type, unsigned int p99_us, void *user_data);
+
+/**
+ * @brief Gets a percentile of the ages of the samples delivered to the callback of a sensor type.
+ * @details
+ * The age of a sample is the time between its timestamp and its delivery to the callback.
+ * The ages are kept from the first time a callback of the type is set, in a histogram with buckets at most
+ * 1/8 as wide as their value, and a percentile is the upper bound of its bucket.
+ * The clock of the timestamps, monotonic or wall clock, is found on the first sample.
+ *
+ * @remark This function does not take any lock and can be called from any thread.
+ * @remark Only #SENSOR_ACCELEROMETER to #SENSOR_PROXIMITY have timestamped samples.
+ *
+ * @param[in]   sensor          The sensor handle
+ * @param[in]   type            The sensor type
+ * @param[in]   percentile      The percentile, from 0 to 100
+ * @param[out]  latency_us      The age at @a percentile (in microseconds), 0 before the first sample
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter, or no callback of @a type was ever set
+ */
+int sensor_latency_get_percentile(sensor_h sensor, sensor_type_e type, double percentile, unsigned int *latency_us);
+
+/**
+ * @brief Registers a callback called when the sample ages of a sensor type go over a budget.
+ * @details
+ * The ages are also gathered in windows of @a window_ms, at the end of a window its 99th percentile is
+ * compared with @a budget_us. The callback is called for every window over the budget.
+ *
+ * @param[in]   sensor          The sensor handle
+ * @param[in]   type            #SENSOR_ACCELEROMETER to #SENSOR_PROXIMITY
+ * @param[in]   budget_us       The budget of the 99th percentile (in microseconds)
+ * @param[in]   window_ms       The length of a window (in milliseconds)
+ * @param[in]   callback        The callback function to register
+ * @param[in]   user_data       The user data to be passed to the callback function
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter
+ * @retval      #SENSOR_ERROR_OUT_OF_MEMORY         Out of memory
+ *
+ * @see sensor_latency_budget_cb()
+ * @see sensor_latency_unset_budget_cb()
+ */
+int sensor_latency_set_budget_cb(sensor_h sensor, sensor_type_e type, unsigned int budget_us, int window_ms, sensor_latency_budget_cb callback, void *user_data);
+
+/**
+ * @brief Unregisters the budget callback of a sensor type.
+ *
+ * @param[in]   sensor      The sensor handle
+ * @param[in]   type        The sensor type
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter
+ *
+ * @see sensor_latency_set_budget_cb()
+ */
+int sensor_latency_unset_budget_cb(sensor_h sensor, sensor_type_e type);
+
+/**
+ * @}
+ */
+
+/**
+ * @addtogroup CAPI_SYSTEM_SENSOR_JITTER_MODULE
+ * @{
+ */
+
+/**
+ * @brief Cadence of a stream, from the timestamps of its samples.
+ * @details
+ * A server batching samples delivers several of them per event, with regular timestamps: @a events is below
+ * @a samples, and @a missed stays near 0. Samples really dropped leave gaps: @a missed_in_gaps and @a missed grow together.
+ * Samples arriving in bursts with irregular timestamps show as @a short_intervals compensated by longer gaps,
+ * with @a missed_in_gaps growing but not @a missed.
+ */
+typedef struct
+{
+    int requested_interval_ms;              /**< Interval the event is registered with, 0 for the default one */
+    unsigned long long samples;             /**< Samples received */
+    unsigned long long events;              /**< Events they were delivered in */
+    float mean_rate_hz;                     /**< Samples per second of timestamp */
+    float mean_interval_ms;                 /**< Mean interval between timestamps */
+    float stddev_interval_ms;               /**< Standard deviation of the intervals, the jitter */
+    float max_gap_ms;                       /**< Longest interval */
+    unsigned long long short_intervals;     /**< Intervals under half the requested one, and repeated or older timestamps */
+    unsigned long long missed_in_gaps;      /**< Samples missing in the intervals over 1.5 times the requested one */
+    unsigned long long missed;              /**< Samples the time span should hold at the intervals requested along it, minus those received */
+    float burstiness;                       /**< (stddev - mean) / (stddev + mean) of the intervals: -1 periodic, 0 random, towards 1 bursty */
+} sensor_jitter_stats_s;
+
+/**
+ * @brief Starts analyzing the timestamps of a stream of a handle.
+ * @details
+ * Each interval between two samples updates a few running sums, nothing is allocated while the stream runs.
+ * Enabling an analyzed stream again starts the analysis over.
+ *
+ * @remark The missed samples are only estimated when the callback of @a type was set with an interval.
+ * @remark The sensor server may deliver a stream faster than requested when another client asked for a faster rate,
+ * the intervals are then mostly short.
+ *
+ * @param[in]   sensor      The sensor handle
+ * @param[in]   type        #SENSOR_ACCELEROMETER to #SENSOR_PROXIMITY
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter
+ * @retval      #SENSOR_ERROR_OUT_OF_MEMORY         Out of memory
+ *
+ * @see sensor_jitter_disable()
+ * @see sensor_jitter_get_stats()
+ */
+int sensor_jitter_enable(sensor_h sensor, sensor_type_e type);
+
+/**
+ * @brief Stops analyzing the timestamps of a stream.
+ *
+ * @param[in]   sensor      The sensor handle
+ * @param[in]   type        The sensor type
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter
+ *
+ * @see sensor_jitter_enable()
+ */
+int sensor_jitter_disable(sensor_h sensor, sensor_type_e type);
+
+/**
+ * @brief Gets the cadence of an analyzed stream.
+ *
+ * @remark This function does not take any lock and can be called from any thread.
+ *
+ * @param[in]   sensor      The sensor handle
+ * @param[in]   type        The sensor type
+ * @param[out]  stats       The cadence of the stream since it was enabled
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter, or @a type is not analyzed
+ *
+ * @see sensor_jitter_enable()
+ */
+int sensor_jitter_get_stats(sensor_h sensor, sensor_type_e type, sensor_jitter_stats_s *stats);
+
+/**
+ * @}
+ */
+
+/**
+ * @addtogroup CAPI_SYSTEM_SENSOR_TRACE_MODULE
+ * @{
+ */
+
+/**
+ * @brief Starts recording the spans of the library, for all the handles of the process.
+ * @details
+ * The spans are the calls to the sensor server (connect, register, unregister and get data), the dispatch of each event
+ * and the user callbacks it runs. Each thread records its spans in a ring of its own, without any lock: once full,
+ * the oldest spans of the thread are overwritten. Starting again drops the spans recorded so far.
+ * The ring of a thread that exited is kept for the export until the next start, which frees it.
+ *
+ * @remark While the trace is stopped, a span costs one load.
+ *
+ * @param[in]   spans_per_thread    The spans kept per thread, a power of 2 from 2
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter
+ *
+ * @see sensor_trace_stop()
+ * @see sensor_trace_export()
+ */
+int sensor_trace_start(unsigned int spans_per_thread);
+
+/**
+ * @brief Stops recording spans, the recorded ones are kept for sensor_trace_export().
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ *
+ * @see sensor_trace_start()
+ */
+int sensor_trace_stop(void);
+
+/**
+ * @brief Writes the recorded spans to a file, in the Chrome trace event format.
+ * @details
+ * The file opens in chrome://tracing and in the Perfetto UI. Timestamps are those of the monotonic clock, in microseconds,
+ * each span carries the sensor type it was recorded for.
+ *
+ * @remark The trace may be exported while it records, the spans overwritten during the export are left out.
+ *
+ * @param[in]   path        The file to write, replaced if it exists
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter
+ * @retval      #SENSOR_ERROR_IO_ERROR              The file could not be written
+ *
+ * @see sensor_trace_start()
+ */
+int sensor_trace_export(const char *path);
+
+/**
+ * @}
+ */
+
+/**
+ * @addtogroup CAPI_SYSTEM_SENSOR_BATCH_MODULE
+ * @{
+ */
+
+/**
+ * @brief A sample of a data type.
+ */
+typedef struct
+{
+    unsigned long long timestamp;       /**< Time stamp of the sample, in microseconds */
+    sensor_data_accuracy_e accuracy;    /**< Accuracy of the sample */
+    float values[3];                    /**< The values of the sensor callback of the type, in its units: x, y and z, or the lux or distance first */
+} sensor_sample_s;
+
+/**
+ * @brief Called with the samples of an event, in one call instead of a callback per sample.
+ *
+ * @param[in] type          The sensor type
+ * @param[in] samples       The samples in the order they were taken, valid during the call only
+ * @param[in] count         The number of samples, 64 at most
+ * @param[in] user_data     The user data passed from the callback registration function
+ *
+ * @see sensor_batch_set_cb()
+ */
+typedef void (*sensor_batch_cb)(sensor_type_e type, const sensor_sample_s *samples, int count, void *user_data);
+
+/**
+ * @brief Registers a callback receiving the samples of a sensor by event.
+ * @details
+ * The callback takes the place of the callback of the type, set with sensor_accelerometer_set_cb() for instance,
+ * and setting that callback again replaces this one. An event of more than 64 samples is delivered in several calls.
+ *
+ * @param[in]   sensor          The sensor handle
+ * @param[in]   type            #SENSOR_ACCELEROMETER to #SENSOR_PROXIMITY
+ * @param[in]   interval_ms     The interval sensor events are delivered in (in milliseconds), 100 when zero
+ * @param[in]   callback        The callback function to register
+ * @param[in]   user_data       The user data to be passed to the callback function
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter
+ * @retval      #SENSOR_ERROR_IO_ERROR              I/O error
+ * @retval      #SENSOR_ERROR_NOT_SUPPORTED         The sensor type is not supported in current device
+ *
+ * @see sensor_batch_cb()
+ * @see sensor_batch_unset_cb()
+ */
+int sensor_batch_set_cb(sensor_h sensor, sensor_type_e type, int interval_ms, sensor_batch_cb callback, void *user_data);
+
+/**
+ * @brief Unregisters the batch callback of a sensor.
+ *
+ * @param[in]   sensor      The sensor handle
+ * @param[in]   type        #SENSOR_ACCELEROMETER to #SENSOR_PROXIMITY
+ *
+ * @return      0 on success, otherwise a negative error value
+ * @retval      #SENSOR_ERROR_NONE                  Successful
+ * @retval      #SENSOR_ERROR_INVALID_PARAMETER     Invalid parameter
+ * @retval      #SENSOR_ERROR_IO_ERROR              I/O error
+ *
+ * @see sensor_batch_set_cb()
+ */
+int sensor_batch_unset_cb(sensor_h sensor, sensor_type_e type);
+
+/**
+ * @}
+ */
+
 /**
  * @}
  *
@@ -0,0 +1,395 @@
+/*
+ * Copyright (c) 2011 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+
+#ifndef __SENSOR_HPP__
+#define __SENSOR_HPP__
+
+#include <cstddef>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include <sensors.h>
+
+/**
+ * @file sensors.hpp
+ * @brief C++17 wrapper of the sensor API, header only.
+ *
+ * @code
+ * sensor::handle h;
+ * sensor::subscription<sensor::accelerometer> accel(h, 10,
+ *         [&](unsigned long long timestamp, sensor_data_accuracy_e accuracy, float x, float y, float z) { ... });
+ * sensor::subscription<sensor::gyroscope> gyro(h, 10,
+ *         [&](sensor::span<const sensor_sample_s> samples) { for(auto &s : samples) ... });
+ * @endcode
+ *
+ * Every callable type gets a callback of its own, a template instantiated for it, which the library calls with the
+ * callable as user data: the callable is inlined there, with no virtual call or std::function between the dispatch
+ * and its body. A callable taking a span of samples receives the samples of an event at once, through sensor_batch_set_cb().
+ */
+
+namespace sensor {
+
+/**
+ * @brief The error of a failed sensor call, its code is a #sensor_error_e.
+ */
+class error : public std::runtime_error
+{
+public:
+    explicit error(int code) : std::runtime_error(message(code)), code_(code) {}
+
+    int code() const noexcept { return code_; }
+
+private:
+    static const char *message(int code)
+    {
+        switch(code){
+            case SENSOR_ERROR_IO_ERROR: return "sensor: I/O error";
+            case SENSOR_ERROR_INVALID_PARAMETER: return "sensor: invalid parameter";
+            case SENSOR_ERROR_OUT_OF_MEMORY: return "sensor: out of memory";
+            case SENSOR_ERROR_NOT_NEED_CALIBRATION: return "sensor: the sensor does not need calibration";
+            case SENSOR_ERROR_NOT_SUPPORTED: return "sensor: not supported on this device";
+            case SENSOR_ERROR_OPERATION_FAILED: return "sensor: operation failed";
+            default: return "sensor: error";
+        }
+    }
+
+    int code_;
+};
+
+/**
+ * @brief A view of contiguous elements, what std::span is to C++20.
+ */
+template <typename T>
+class span
+{
+public:
+    constexpr span(T *data, std::size_t size) noexcept : data_(data), size_(size) {}
+
+    constexpr T *data() const noexcept { return data_; }
+    constexpr std::size_t size() const noexcept { return size_; }
+    constexpr bool empty() const noexcept { return size_ == 0; }
+    constexpr T &operator[](std::size_t i) const noexcept { return data_[i]; }
+    constexpr T *begin() const noexcept { return data_; }
+    constexpr T *end() const noexcept { return data_ + size_; }
+
+private:
+    T *data_;
+    std::size_t size_;
+};
+
+namespace detail {
+
+inline void check(int err)
+{
+    if(err != SENSOR_ERROR_NONE)
+        throw error(err);
+}
+
+// the types of the handles a subscription holds, a handle has a single callback per type
+inline bool claim(sensor_h sensor, sensor_type_e type, bool take)
+{
+    static std::mutex lock;
+    static std::set<std::pair<sensor_h, int>> claimed;
+    std::lock_guard<std::mutex> guard(lock);
+
+    if(take)
+        return claimed.emplace(sensor, type).second;
+
+    claimed.erase(std::make_pair(sensor, static_cast<int>(type)));
+    return true;
+}
+
+template <typename F>
+void xyz_trampoline(unsigned long long timestamp, sensor_data_accuracy_e accuracy, float x, float y, float z, void *user_data)
+{
+    (*static_cast<F *>(user_data))(timestamp, accuracy, x, y, z);
+}
+
+template <typename F>
+void value_trampoline(unsigned long long timestamp, float value, void *user_data)
+{
+    (*static_cast<F *>(user_data))(timestamp, value);
+}
+
+template <typename F, typename E>
+void motion_trampoline(unsigned long long timestamp, E motion, void *user_data)
+{
+    (*static_cast<F *>(user_data))(timestamp, motion);
+}
+
+template <typename F>
+void gesture_trampoline(unsigned long long timestamp, void *user_data)
+{
+    (*static_cast<F *>(user_data))(timestamp);
+}
+
+template <typename F>
+void panning_trampoline(unsigned long long timestamp, int x, int y, void *user_data)
+{
+    (*static_cast<F *>(user_data))(timestamp, x, y);
+}
+
+template <typename F>
+void batch_trampoline(sensor_type_e, const sensor_sample_s *samples, int count, void *user_data)
+{
+    (*static_cast<F *>(user_data))(span<const sensor_sample_s>(samples, count));
+}
+
+} // namespace detail
+
+/*
+ * The sensors a subscription is made to. The callable of a data type takes
+ * (unsigned long long timestamp, sensor_data_accuracy_e accuracy, float x, float y, float z),
+ * or (unsigned long long timestamp, float value) for the light and the proximity, or a span of samples.
+ */
+struct accelerometer
+{
+    static constexpr sensor_type_e type = SENSOR_ACCELEROMETER;
+    template <typename F>
+    static int set(sensor_h sensor, int interval_ms, F *f) { return sensor_accelerometer_set_cb(sensor, interval_ms, detail::xyz_trampoline<F>, f); }
+    static int unset(sensor_h sensor) { return sensor_accelerometer_unset_cb(sensor); }
+};
+
+struct magnetic
+{
+    static constexpr sensor_type_e type = SENSOR_MAGNETIC;
+    template <typename F>
+    static int set(sensor_h sensor, int interval_ms, F *f) { return sensor_magnetic_set_cb(sensor, interval_ms, detail::xyz_trampoline<F>, f); }
+    static int unset(sensor_h sensor) { return sensor_magnetic_unset_cb(sensor); }
+};
+
+struct orientation
+{
+    static constexpr sensor_type_e type = SENSOR_ORIENTATION;
+    template <typename F>
+    static int set(sensor_h sensor, int interval_ms, F *f) { return sensor_orientation_set_cb(sensor, interval_ms, detail::xyz_trampoline<F>, f); }
+    static int unset(sensor_h sensor) { return sensor_orientation_unset_cb(sensor); }
+};
+
+struct gyroscope
+{
+    static constexpr sensor_type_e type = SENSOR_GYROSCOPE;
+    template <typename F>
+    static int set(sensor_h sensor, int interval_ms, F *f) { return sensor_gyroscope_set_cb(sensor, interval_ms, detail::xyz_trampoline<F>, f); }
+    static int unset(sensor_h sensor) { return sensor_gyroscope_unset_cb(sensor); }
+};
+
+struct light
+{
+    static constexpr sensor_type_e type = SENSOR_LIGHT;
+    template <typename F>
+    static int set(sensor_h sensor, int interval_ms, F *f) { return sensor_light_set_cb(sensor, interval_ms, detail::value_trampoline<F>, f); }
+    static int unset(sensor_h sensor) { return sensor_light_unset_cb(sensor); }
+};
+
+struct proximity
+{
+    static constexpr sensor_type_e type = SENSOR_PROXIMITY;
+    template <typename F>
+    static int set(sensor_h sensor, int interval_ms, F *f) { return sensor_proximity_set_cb(sensor, interval_ms, detail::value_trampoline<F>, f); }
+    static int unset(sensor_h sensor) { return sensor_proximity_unset_cb(sensor); }
+};
+
+/*
+ * The motion types take (unsigned long long timestamp, sensor_motion_snap_e snap) and
+ * (unsigned long long timestamp, sensor_motion_shake_e shake), (unsigned long long timestamp, int x, int y)
+ * for the panning, and the timestamp alone for the double tap and the face down. Their interval is ignored.
+ */
+struct motion_snap
+{
+    static constexpr sensor_type_e type = SENSOR_MOTION_SNAP;
+    template <typename F>
+    static int set(sensor_h sensor, int, F *f) { return sensor_motion_snap_set_cb(sensor, detail::motion_trampoline<F, sensor_motion_snap_e>, f); }
+    static int unset(sensor_h sensor) { return sensor_motion_snap_unset_cb(sensor); }
+};
+
+struct motion_shake
+{
+    static constexpr sensor_type_e type = SENSOR_MOTION_SHAKE;
+    template <typename F>
+    static int set(sensor_h sensor, int, F *f) { return sensor_motion_shake_set_cb(sensor, detail::motion_trampoline<F, sensor_motion_shake_e>, f); }
+    static int unset(sensor_h sensor) { return sensor_motion_shake_unset_cb(sensor); }
+};
+
+struct motion_doubletap
+{
+    static constexpr sensor_type_e type = SENSOR_MOTION_DOUBLETAP;
+    template <typename F>
+    static int set(sensor_h sensor, int, F *f) { return sensor_motion_doubletap_set_cb(sensor, detail::gesture_trampoline<F>, f); }
+    static int unset(sensor_h sensor) { return sensor_motion_doubletap_unset_cb(sensor); }
+};
+
+struct motion_panning
+{
+    static constexpr sensor_type_e type = SENSOR_MOTION_PANNING;
+    template <typename F>
+    static int set(sensor_h sensor, int, F *f) { return sensor_motion_panning_set_cb(sensor, detail::panning_trampoline<F>, f); }
+    static int unset(sensor_h sensor) { return sensor_motion_panning_unset_cb(sensor); }
+};
+
+struct motion_facedown
+{
+    static constexpr sensor_type_e type = SENSOR_MOTION_FACEDOWN;
+    template <typename F>
+    static int set(sensor_h sensor, int, F *f) { return sensor_motion_facedown_set_cb(sensor, detail::gesture_trampoline<F>, f); }
+    static int unset(sensor_h sensor) { return sensor_motion_facedown_unset_cb(sensor); }
+};
+
+/**
+ * @brief A sensor handle, destroyed with the object.
+ */
+class handle
+{
+public:
+    handle() { detail::check(sensor_create(&handle_)); }
+    ~handle() { if(handle_ != nullptr) sensor_destroy(handle_); }
+
+    handle(const handle &) = delete;
+    handle &operator=(const handle &) = delete;
+
+    handle(handle &&other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+    handle &operator=(handle &&other) noexcept
+    {
+        if(this != &other){
+            if(handle_ != nullptr)
+                sensor_destroy(handle_);
+            handle_ = std::exchange(other.handle_, nullptr);
+        }
+        return *this;
+    }
+
+    sensor_h get() const noexcept { return handle_; }
+    operator sensor_h() const noexcept { return handle_; }
+
+private:
+    sensor_h handle_ = nullptr;
+};
+
+/**
+ * @brief The callback of a sensor type on a handle, started on construction, stopped and unset on destruction.
+ * @details
+ * A handle has a single callback per type: a second subscription to the same type of a handle throws an error of
+ * #SENSOR_ERROR_INVALID_PARAMETER while the first one holds it. Setting the callback of that type with the C API
+ * replaces the one of the subscription.
+ * The callable is moved to the heap, a subscription can be moved while its callable is called.
+ *
+ * @remark Destroy a subscription on the thread the callbacks are called on, or once they can no longer run:
+ * the callable is deleted as soon as the callback is unset.
+ */
+template <typename Sensor>
+class subscription
+{
+public:
+    template <typename F>
+    subscription(sensor_h sensor, int interval_ms, F &&f)
+    {
+        using callable = std::decay_t<F>;
+
+        callable *c;
+        int err;
+
+        if(!detail::claim(sensor, Sensor::type, true))
+            throw error(SENSOR_ERROR_INVALID_PARAMETER);
+
+        try{
+            c = new callable(std::forward<F>(f));
+        }catch(...){
+            detail::claim(sensor, Sensor::type, false);
+            throw;
+        }
+
+        if constexpr (std::is_invocable_v<callable &, span<const sensor_sample_s>>){
+            static_assert(Sensor::type <= SENSOR_PROXIMITY, "samples are delivered by span for the data types only");
+            err = sensor_batch_set_cb(sensor, Sensor::type, interval_ms, detail::batch_trampoline<callable>, c);
+        }else{
+            err = Sensor::set(sensor, interval_ms, c);
+        }
+
+        if(err == SENSOR_ERROR_NONE && (err = sensor_start(sensor, Sensor::type)) != SENSOR_ERROR_NONE)
+            Sensor::unset(sensor);
+
+        if(err != SENSOR_ERROR_NONE){
+            delete c;
+            detail::claim(sensor, Sensor::type, false);
+            throw error(err);
+        }
+
+        sensor_ = sensor;
+        callable_ = c;
+        delete_ = [](void *p) { delete static_cast<callable *>(p); };
+    }
+
+    template <typename F>
+    subscription(sensor_h sensor, F &&f) : subscription(sensor, 0, std::forward<F>(f)) {}
+
+    ~subscription() { reset(); }
+
+    subscription(const subscription &) = delete;
+    subscription &operator=(const subscription &) = delete;
+
+    subscription(subscription &&other) noexcept
+        : sensor_(std::exchange(other.sensor_, nullptr)),
+          callable_(std::exchange(other.callable_, nullptr)),
+          delete_(std::exchange(other.delete_, nullptr))
+    {
+    }
+
+    subscription &operator=(subscription &&other) noexcept
+    {
+        if(this != &other){
+            reset();
+            sensor_ = std::exchange(other.sensor_, nullptr);
+            callable_ = std::exchange(other.callable_, nullptr);
+            delete_ = std::exchange(other.delete_, nullptr);
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Stops the sensor and unsets the callback, the subscription is then empty.
+     */
+    void reset() noexcept
+    {
+        if(sensor_ == nullptr)
+            return;
+
+        sensor_stop(sensor_, Sensor::type);
+        Sensor::unset(sensor_);
+        delete_(callable_);
+        detail::claim(sensor_, Sensor::type, false);
+
+        sensor_ = nullptr;
+        callable_ = nullptr;
+        delete_ = nullptr;
+    }
+
+    explicit operator bool() const noexcept { return sensor_ != nullptr; }
+
+private:
+    sensor_h sensor_ = nullptr;
+    void *callable_ = nullptr;
+    void (*delete_)(void *) = nullptr;
+};
+
+} // namespace sensor
+
+#endif
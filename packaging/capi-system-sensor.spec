@@ -12,6 +12,9 @@ BuildRequires:  pkgconfig(capi-base-common)
 Requires(post): /sbin/ldconfig  
 Requires(postun): /sbin/ldconfig
 
+# build with the profiles of a replayed capture, --with pgo
+%bcond_with pgo
+
 %description
 
 
@@ -30,7 +33,13 @@ Requires: %{name} = %{version}-%{release}
 
 %build
 MAJORVER=`echo %{version} | awk 'BEGIN {FS="."}{print $1}'`
-cmake . -DCMAKE_INSTALL_PREFIX=/usr -DFULLVER=%{version} -DMAJORVER=${MAJORVER}
+%if %{with pgo}
+cmake . -DCMAKE_INSTALL_PREFIX=/usr -DFULLVER=%{version} -DMAJORVER=${MAJORVER} -DCMAKE_BUILD_TYPE=Release -DSENSOR_PGO=generate
+make %{?jobs:-j%jobs}
+make pgo-train
+make clean
+%endif
+cmake . -DCMAKE_INSTALL_PREFIX=/usr -DFULLVER=%{version} -DMAJORVER=${MAJORVER} -DCMAKE_BUILD_TYPE=Release %{?with_pgo:-DSENSOR_PGO=use}
 
 
 make %{?jobs:-j%jobs}
@@ -49,6 +58,7 @@ rm -rf %{buildroot}
 
 %files devel
 %{_includedir}/system/sensors.h
+%{_includedir}/system/sensors.hpp
 %{_libdir}/pkgconfig/*.pc
 %{_libdir}/libcapi-system-sensor.so
 
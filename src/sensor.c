@@ -20,23 +20,13 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/time.h>
+#include <time.h>
 
-#include <sensor.h>
-#include <sensor_accel.h>
-#include <sensor_geomag.h>
-#include <sensor_light.h>
-#include <sensor_proxi.h>
-#include <sensor_motion.h>
-#include <sensor_gyro.h>
+#include <sensor_framework_private.h>
 #include <sensors.h>
 #include <sensor_private.h>
-#include <dlog.h>
-
-#define _DEBUG 1
 
 #ifdef _DEBUG
-#undef LOG_TAG
-#define LOG_TAG "TIZEN_SYSTEM_SENSOR"
 #include <stdio.h>
 #include <libgen.h>
 static char* _DONT_USE_THIS_ARRAY_DIRECTLY[] = {
@@ -50,58 +40,15 @@ static char* _DONT_USE_THIS_ARRAY_DIRECTLY[] = {
 	"MOTION_SHAKE",
 	"MOTION_DOUBLETAP",
     "MOTION_PANNING",
-    "MOTION_FACEDOWN"
+    "MOTION_FACEDOWN",
+    "DEVICE_ORIENTATION",
+    "PEDOMETER"
 };
 
-#define _MSG_SENSOR_ERROR_IO_ERROR "Io Error"
-#define _MSG_SENSOR_ERROR_INVALID_PARAMETER "Invalid Parameter"
-#define _MSG_SENSOR_ERROR_OUT_OF_MEMORY "Out of Memory"
-#define _MSG_SENSOR_ERROR_NOT_NEED_CALIBRATION "Not need calibration"
-#define _MSG_SENSOR_ERROR_NOT_SUPPORTED "Not supported"
-#define _MSG_SENSOR_ERROR_OPERATION_FAILED "Operation failed"
-
 #define TYPE_NAME(type) _DONT_USE_THIS_ARRAY_DIRECTLY[type]
-
-#define DEBUG_PRINT(txt) LOGD("%s : " txt, __FUNCTION__)
-#define DEBUG_PRINTF(fmt, ...) LOGD("%s : " fmt, __FUNCTION__, __VA_ARGS__)
-#define ERROR_PRINT(err) LOGD("[%s]" _MSG_##err "(0x%08x)", __FUNCTION__, err)
-#define ERROR_PRINTF(err, fmt, ...) LOGD("[%s]" _MSG_##err "(0x%08x) : " fmt, __FUNCTION__, err, __VA_ARGS__)
 #else
 #define TYPE_NAME(type) ""
-#define DEBUG_PRINT(txt)
-#define DEBUG_PRINTF(fmt, ...)
-#define ERROR_PRINT(err)
-#define ERROR_PRINTF(err)
 #endif
-	
-#define RETURN_VAL_IF(expr, err) \
-	do { \
-		if (expr) { \
-            ERROR_PRINT(err); \
-			return (err); \
-		} \
-	} while(0)
-
-#define RETURN_ERROR(err) \
-    do { \
-        ERROR_PRINT(err); \
-        return err; \
-    } while(0)
-
-
-#define RETURN_IF_NOT_HANDLE(handle) \
-	RETURN_VAL_IF(handle == NULL, SENSOR_ERROR_INVALID_PARAMETER)
-
-#define RETURN_IF_NOT_TYPE(type) \
-	RETURN_VAL_IF(type > SENSOR_MOTION_FACEDOWN || type < 0, SENSOR_ERROR_INVALID_PARAMETER)
-
-#define RETURN_IF_MOTION_TYPE(type) \
-	RETURN_VAL_IF(type > SENSOR_PROXIMITY && type <= SENSOR_MOTION_FACEDOWN, SENSOR_ERROR_INVALID_PARAMETER)
-
-#define RETURN_IF_ERROR(val) \
-	RETURN_VAL_IF(val < 0, val)
-
-#define MICROSECONDS(tv)        ((tv.tv_sec * 1000000ll) + tv.tv_usec)
 
 sensor_data_accuracy_e _accu_table[] = {
 	SENSOR_ACCURACY_UNDEFINED,
@@ -123,6 +70,8 @@ sensor_type_t _TYPE[] = {
 	MOTION_SENSOR,
 	MOTION_SENSOR,
 	MOTION_SENSOR,
+	ACCELEROMETER_SENSOR,
+	ACCELEROMETER_SENSOR,
 };
 
 int _DTYPE[] = {
@@ -137,6 +86,8 @@ int _DTYPE[] = {
 	MOTION_SENSOR,
 	MOTION_SENSOR,
 	MOTION_SENSOR,
+	ACCELEROMETER_BASE_DATA_SET,
+	ACCELEROMETER_BASE_DATA_SET,
 };
 
 int _EVENT[] = {
@@ -151,6 +102,8 @@ int _EVENT[] = {
 	MOTION_ENGINE_EVENT_DOUBLETAP,
 	MOTION_ENGINE_EVENT_PANNING,
 	MOTION_ENGINE_EVENT_TOP_TO_BOTTOM,
+	ACCELEROMETER_EVENT_RAW_DATA_REPORT_ON_TIME,
+	ACCELEROMETER_EVENT_RAW_DATA_REPORT_ON_TIME,
 };
 
 int _CALIBRATION[] = {
@@ -170,15 +123,21 @@ int _sensor_ids[] = {
     ID_MOTION,
     ID_MOTION,
     ID_MOTION,
-    ID_MOTION
+    ID_MOTION,
+    ID_ACCELEOMETER,
+    ID_ACCELEOMETER
 };
 
 #define _SID(id) (_sensor_ids[id])
+
+// motion types detected in the library run on the accelerometer connection
+#define _SOURCE(handle, type) ((handle)->fallback[type] ? SENSOR_ACCELEROMETER : (type))
 #define _ACCU(accuracy) (_accu_table[accuracy + 1])
 
 static int _sensor_connect(sensor_h handle, sensor_type_e type)
 {
     int id = 0;
+    unsigned long long begin;
     bool support = true;
 
 	RETURN_IF_NOT_TYPE(type);
@@ -188,7 +147,10 @@ static int _sensor_connect(sensor_h handle, sensor_type_e type)
         if(!support)
             return SENSOR_ERROR_NOT_SUPPORTED;
 
-        id = sf_connect(_TYPE[type]);
+        _COUNT(handle->counters[type].connect_calls, 1);
+        begin = _TRACE_BEGIN();
+        id = _sensor_backend()->connect(_TYPE[type]);
+        _TRACE_END(TRACE_CONNECT, type, begin);
 
         DEBUG_PRINTF("%s sensor connect legacy=[%d] type=[%d]", TYPE_NAME(type), type, _TYPE[type]);
         if(id < 0){
@@ -200,7 +162,43 @@ static int _sensor_connect(sensor_h handle, sensor_type_e type)
     return SENSOR_ERROR_NONE;
 }
 
-static void _sensor_callback (unsigned int event_type, sensor_event_data_t* event, void* udata)
+// histogram bucket of a callback time, under 1 us then one per power of 2 us
+static int _sensor_callback_bucket(const struct timespec* begin, const struct timespec* end)
+{
+    long long us = ((end->tv_sec - begin->tv_sec) * 1000000000ll + end->tv_nsec - begin->tv_nsec) / 1000;
+    int bucket;
+
+    if(us <= 0)
+        return 0;
+    bucket = 64 - __builtin_clzll(us);
+    return bucket < SENSOR_STATS_CALLBACK_BUCKETS ? bucket : SENSOR_STATS_CALLBACK_BUCKETS - 1;
+}
+
+// the samples of an event in chunks of the stack array, most events fit in one
+#define BATCH_CHUNK 64
+
+static void _sensor_batch_deliver(sensor_h handle, sensor_batch_cb cb, void* user_data, sensor_type_e type, sensor_data_t* data, int data_num)
+{
+    sensor_sample_s samples[BATCH_CHUNK];
+    int i, n;
+
+    while(data_num > 0 && !handle->destroyed){
+        n = data_num < BATCH_CHUNK ? data_num : BATCH_CHUNK;
+        for(i=0; i<n; i++){
+            samples[i].timestamp = data[i].time_stamp;
+            samples[i].accuracy = _ACCU(data[i].data_accuracy);
+            samples[i].values[0] = data[i].values[0];
+            samples[i].values[1] = data[i].values[1];
+            samples[i].values[2] = data[i].values[2];
+        }
+        cb(type, samples, n, user_data);
+
+        data += n;
+        data_num -= n;
+    }
+}
+
+static void _sensor_dispatch (unsigned int event_type, sensor_event_data_t* event, void* udata, int* type)
 {
 	int i = 0;
 	int data_num = 0;
@@ -208,9 +206,13 @@ static void _sensor_callback (unsigned int event_type, sensor_event_data_t* even
     sensor_panning_data_t *panning_data = NULL;
 	int motion = 0;
     int nid = 0;
+    void* cb;
+    void* user_data;
+    int batch;
 
 	struct timeval sv;
 	unsigned long long motion_time_stamp = 0;
+    struct timespec begin, end;
 //    bool proximity = 0;
 
 	sensor_h sensor = (sensor_h)udata;
@@ -250,11 +252,15 @@ static void _sensor_callback (unsigned int event_type, sensor_event_data_t* even
 		case PROXIMITY_EVENT_DISTANCE_DATA_REPORT_ON_TIME :
             nid = SENSOR_PROXIMITY;
             break;
+		default:
+            _COUNT(sensor->unknown_events, 1);
+			DEBUG_PRINTF("unknown typed sensor happen!! event=%d\n", event_type);
+			return;
 	}
 
-    if(sensor->cb_func[nid] == NULL || sensor->started[nid] == 0)
-        return;
-	
+    *type = nid;
+    _COUNT(sensor->counters[nid].events, 1);
+
 	switch(event_type)
 	{
 		case MOTION_ENGINE_EVENT_SNAP:
@@ -266,13 +272,17 @@ static void _sensor_callback (unsigned int event_type, sensor_event_data_t* even
             break;
 		case MOTION_ENGINE_EVENT_DOUBLETAP:
 			motion = *(int*)event->event_data;
-            if(motion != MOTION_ENGIEN_DOUBLTAP_DETECTION)
+            if(motion != MOTION_ENGIEN_DOUBLTAP_DETECTION){
+                _COUNT(sensor->counters[nid].samples_dropped, 1);
                 return;
+            }
             break;
 		case MOTION_ENGINE_EVENT_TOP_TO_BOTTOM:
 			motion = *(int*)event->event_data;
-            if(motion != MOTION_ENGIEN_TOP_TO_BOTTOM_DETECTION)
+            if(motion != MOTION_ENGIEN_TOP_TO_BOTTOM_DETECTION){
+                _COUNT(sensor->counters[nid].samples_dropped, 1);
                 return;
+            }
             break;
 
 		case ACCELEROMETER_EVENT_RAW_DATA_REPORT_ON_TIME :
@@ -289,88 +299,197 @@ static void _sensor_callback (unsigned int event_type, sensor_event_data_t* even
             proximity = *(int*)(event->event_data) == PROXIMITY_STATE_FAR ? 0 : 1;
             break;
             */
-		default:
-			DEBUG_PRINTF("unknown typed sensor happen!! event=%d\n", event_type);
-			return;
-
 	}
 
+    // recorded and shared raw, a replay with the calibrations enabled corrects them once
+    if(data != NULL && sensor->record != NULL)
+        _sensor_record_feed(sensor->record, nid, data, data_num);
+    if(data != NULL && sensor->share != NULL)
+        _sensor_share_feed(sensor->share, nid, data, data_num);
+
+    // corrected before any other consumer sees the samples
+    if(nid == SENSOR_MAGNETIC && data != NULL && sensor->magnetic_calibration != NULL)
+        _sensor_magnetic_calibration_feed(sensor, data, data_num);
+    if((nid == SENSOR_ACCELEROMETER || nid == SENSOR_GYROSCOPE) && data != NULL && sensor->gyroscope_bias != NULL)
+        _sensor_gyroscope_bias_feed(sensor, nid, data, data_num);
+
+    if(data != NULL && sensor->started[nid]){
+        if(sensor->stats[nid] != NULL)
+            _sensor_stats_feed(sensor->stats[nid], data, data_num);
+        if(sensor->spectrum[nid] != NULL)
+            _sensor_spectrum_feed(sensor->spectrum[nid], data, data_num);
+        if(sensor->sync != NULL)
+            _sensor_sync_feed(sensor->sync, nid, data, data_num);
+        if(sensor->adaptive_rate[nid] != NULL)
+            _sensor_adaptive_rate_feed(sensor, nid, data, data_num);
+        if(nid == SENSOR_GYROSCOPE && sensor->gyro_integrator != NULL)
+            _sensor_gyro_integrator_feed(sensor->gyro_integrator, data, data_num);
+        if(sensor->jitter[nid] != NULL)
+            _sensor_jitter_feed(sensor, nid, data, data_num);
+    }
+
+    if(nid == SENSOR_ACCELEROMETER && sensor->device_orientation != NULL && sensor->started[SENSOR_DEVICE_ORIENTATION])
+        _sensor_device_orientation_feed(sensor, data, data_num);
+    if(nid == SENSOR_ACCELEROMETER && sensor->pedometer != NULL && sensor->started[SENSOR_PEDOMETER])
+        _sensor_pedometer_feed(sensor, data, data_num);
+    if(nid == SENSOR_ACCELEROMETER && sensor->motion_fallback != NULL)
+        _sensor_motion_fallback_feed(sensor, data, data_num);
+
+    if(data_num > 0 && sensor->state != NULL)
+        _sensor_state_feed(sensor, data[data_num - 1].time_stamp);
+
+    // stored together under the handle lock, held by the dispatch
+    cb = sensor->cb_func[nid];
+    batch = sensor->batch[nid];
+    user_data = sensor->cb_user_data[nid];
+
+    if(cb == NULL || sensor->started[nid] == 0){
+        _COUNT(sensor->counters[nid].samples_dropped, data != NULL ? data_num : 1);
+        return;
+    }
+
+    _COUNT(sensor->counters[nid].samples_delivered, data != NULL ? data_num : 1);
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    if(data != NULL && sensor->latency[nid] != NULL)
+        _sensor_latency_feed(sensor->latency[nid], nid, &begin, data, data_num);
+
+    if(data != NULL && batch)
+        _sensor_batch_deliver(sensor, (sensor_batch_cb)cb, user_data, nid, data, data_num);
+    else
 	switch(event_type)
 	{
 		case MOTION_ENGINE_EVENT_SNAP:
 			gettimeofday(&sv, NULL);
 			motion_time_stamp = MICROSECONDS(sv);
-			((sensor_motion_snap_event_cb)sensor->cb_func[nid])(motion_time_stamp, motion, sensor->cb_user_data[nid]);
+			((sensor_motion_snap_event_cb)cb)(motion_time_stamp, motion, user_data);
 			break;
 		case MOTION_ENGINE_EVENT_SHAKE:
 			gettimeofday(&sv, NULL);
 			motion_time_stamp = MICROSECONDS(sv);
-			((sensor_motion_shake_event_cb)sensor->cb_func[nid])(motion_time_stamp,motion, sensor->cb_user_data[nid]);
+			((sensor_motion_shake_event_cb)cb)(motion_time_stamp,motion, user_data);
 			break;
 		case MOTION_ENGINE_EVENT_DOUBLETAP:
 			gettimeofday(&sv, NULL);
 			motion_time_stamp = MICROSECONDS(sv);
-			((sensor_motion_doubletap_event_cb)sensor->cb_func[nid])(motion_time_stamp,sensor->cb_user_data[nid]);
+			((sensor_motion_doubletap_event_cb)cb)(motion_time_stamp,user_data);
 			break;
 		case MOTION_ENGINE_EVENT_TOP_TO_BOTTOM:
 			gettimeofday(&sv, NULL);
 			motion_time_stamp = MICROSECONDS(sv);
-			((sensor_motion_facedown_event_cb)sensor->cb_func[nid])(motion_time_stamp,sensor->cb_user_data[nid]);
+			((sensor_motion_facedown_event_cb)cb)(motion_time_stamp,user_data);
 			break;
 		case MOTION_ENGINE_EVENT_PANNING:
 			gettimeofday(&sv, NULL);
 			motion_time_stamp = MICROSECONDS(sv);
-			((sensor_motion_panning_event_cb)sensor->cb_func[nid])(motion_time_stamp,panning_data->x, panning_data->y, sensor->cb_user_data[nid]);
+			((sensor_motion_panning_event_cb)cb)(motion_time_stamp,panning_data->x, panning_data->y, user_data);
             break;
 		case ACCELEROMETER_EVENT_RAW_DATA_REPORT_ON_TIME :
-			for(i=0; i<data_num; i++){
-				((sensor_accelerometer_event_cb)sensor->cb_func[nid])
+			for(i=0; i<data_num && !sensor->destroyed; i++){
+				((sensor_accelerometer_event_cb)cb)
 					(data[i].time_stamp, _ACCU(data[i].data_accuracy), 
 					 data[i].values[0],  data[i].values[1], data[i].values[2], 
-					 sensor->cb_user_data[nid]);
+					 user_data);
 			}
 			break;
 		case GEOMAGNETIC_EVENT_RAW_DATA_REPORT_ON_TIME :
-			for(i=0; i<data_num; i++){
-				((sensor_magnetic_event_cb)sensor->cb_func[nid])
+			for(i=0; i<data_num && !sensor->destroyed; i++){
+				((sensor_magnetic_event_cb)cb)
 					(data[i].time_stamp,_ACCU(data[i].data_accuracy), 
 					 data[i].values[0],  data[i].values[1], data[i].values[2], 
-					 sensor->cb_user_data[nid]);
+					 user_data);
 			}
 			break;
 		case GEOMAGNETIC_EVENT_ATTITUDE_DATA_REPORT_ON_TIME :
-			for(i=0; i<data_num; i++){
-				((sensor_orientation_event_cb)sensor->cb_func[nid])
+			for(i=0; i<data_num && !sensor->destroyed; i++){
+				((sensor_orientation_event_cb)cb)
 					(data[i].time_stamp,_ACCU(data[i].data_accuracy), 
 					 data[i].values[0],  data[i].values[1], data[i].values[2], 
-					 sensor->cb_user_data[nid]);
+					 user_data);
 			}
 			break;
 		case GYROSCOPE_EVENT_RAW_DATA_REPORT_ON_TIME :
-			for(i=0; i<data_num; i++){
-				((sensor_gyroscope_event_cb)sensor->cb_func[nid])
+			for(i=0; i<data_num && !sensor->destroyed; i++){
+				((sensor_gyroscope_event_cb)cb)
 					(data[i].time_stamp,_ACCU(data[i].data_accuracy), 
 					 data[i].values[0],  data[i].values[1], data[i].values[2], 
-					 sensor->cb_user_data[nid]);
+					 user_data);
 			}
 			break;
 		case LIGHT_EVENT_LUX_DATA_REPORT_ON_TIME :
-			for(i=0; i<data_num; i++){
-				((sensor_light_event_cb)sensor->cb_func[nid])
+			for(i=0; i<data_num && !sensor->destroyed; i++){
+				((sensor_light_event_cb)cb)
 					(data[i].time_stamp, 
 					 data[i].values[0], 
-					 sensor->cb_user_data[nid]);
+					 user_data);
 			}
 			break;
 		case PROXIMITY_EVENT_DISTANCE_DATA_REPORT_ON_TIME :
-			for(i=0; i<data_num; i++){
-				((sensor_proximity_event_cb)sensor->cb_func[nid])
+			for(i=0; i<data_num && !sensor->destroyed; i++){
+				((sensor_proximity_event_cb)cb)
 					(data[i].time_stamp, 
 					 data[i].values[0], 
-					 sensor->cb_user_data[nid]);
+					 user_data);
 			}
 			break;
 	}
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    _COUNT(sensor->counters[nid].callback_time[_sensor_callback_bucket(&begin, &end)], 1);
+
+    if(_sensor_trace_on)
+        _sensor_trace_add(TRACE_USER_CALLBACK, nid, begin.tv_sec * 1000000000ull + begin.tv_nsec, end.tv_sec * 1000000000ull + end.tv_nsec);
+}
+
+static void _sensor_free(sensor_h handle)
+{
+    pthread_mutex_destroy(&handle->lock);
+    free(handle);
+    _sensor_backend_hold(-1);
+}
+
+static void _sensor_callback (unsigned int event_type, sensor_event_data_t* event, void* udata)
+{
+    int type = -1;
+    sensor_h sensor = (sensor_h)udata;
+    unsigned long long begin = _TRACE_BEGIN();
+
+    pthread_mutex_lock(&sensor->lock);
+    sensor->dispatching++;
+    _sensor_dispatch(event_type, event, udata, &type);
+    if(--sensor->dispatching == 0 && sensor->destroyed){
+        pthread_mutex_unlock(&sensor->lock);
+        _sensor_free(sensor);
+    }
+    else
+        pthread_mutex_unlock(&sensor->lock);
+    _TRACE_END(TRACE_DISPATCH, type, begin);
+}
+
+// the backend delivers on its own thread, the state fed by the dispatch is not released under it
+void _sensor_release(sensor_h handle, void (*release)(sensor_h handle))
+{
+    pthread_mutex_lock(&handle->lock);
+    release(handle);
+    pthread_mutex_unlock(&handle->lock);
+}
+
+// snap, shake, double tap and face down are detected in the library when the device has no motion engine
+static bool _sensor_motion_fallback(sensor_type_e type)
+{
+    switch(type){
+        case SENSOR_MOTION_SNAP:
+        case SENSOR_MOTION_SHAKE:
+        case SENSOR_MOTION_DOUBLETAP:
+        case SENSOR_MOTION_FACEDOWN:
+            break;
+        default:
+            return false;
+    }
+
+    if(_sensor_backend()->is_sensor_event_available(_TYPE[type], _EVENT[type]) >= 0)
+        return false;
+
+    return _sensor_backend()->is_sensor_event_available(_TYPE[SENSOR_ACCELEROMETER], _EVENT[SENSOR_ACCELEROMETER]) >= 0;
 }
 
 int sensor_is_supported(sensor_type_e type, bool* supported)
@@ -382,7 +501,7 @@ int sensor_is_supported(sensor_type_e type, bool* supported)
     if(supported == NULL)
         RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
 
-    *supported = !(sf_is_sensor_event_available(_TYPE[type], _EVENT[type]) < 0);
+    *supported = !(_sensor_backend()->is_sensor_event_available(_TYPE[type], _EVENT[type]) < 0) || _sensor_motion_fallback(type);
     DEBUG_PRINTF("%s sensor available function return [%d]", TYPE_NAME(type), *supported);
 
     return SENSOR_ERROR_NONE;
@@ -399,10 +518,10 @@ int sensor_get_spec(sensor_type_e type, char** vendor, char** model, float* max,
 
 	RETURN_IF_NOT_TYPE(type);
 
-    if(sf_get_data_properties(_DTYPE[type], &data_properties) < 0)
+    if(_sensor_backend()->get_data_properties(_DTYPE[type], &data_properties) < 0)
         RETURN_ERROR(SENSOR_ERROR_NOT_SUPPORTED);
 
-	if(sf_get_properties(_TYPE[type], &properties) < 0)
+	if(_sensor_backend()->get_properties(_TYPE[type], &properties) < 0)
         RETURN_ERROR(SENSOR_ERROR_NOT_SUPPORTED);
 
 	if(vendor != NULL)
@@ -423,6 +542,7 @@ int sensor_get_spec(sensor_type_e type, char** vendor, char** model, float* max,
 int sensor_create(sensor_h* handle)
 {
 	struct sensor_handle_s* sensor = NULL;
+    pthread_mutexattr_t attr;
 
     DEBUG_PRINT("sensor_create");
 
@@ -436,6 +556,13 @@ int sensor_create(sensor_h* handle)
 	{
         SENSOR_INIT(sensor);
 
+        // a callback may release a feature of its own handle
+        pthread_mutexattr_init(&attr);
+        pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+        pthread_mutex_init(&sensor->lock, &attr);
+        pthread_mutexattr_destroy(&attr);
+        _sensor_backend_hold(1);
+
 		*handle = (sensor_h)sensor;
 
 		return SENSOR_ERROR_NONE;
@@ -451,21 +578,62 @@ int sensor_destroy(sensor_h handle)
 
     DEBUG_PRINT("sensor_destroy");
 
+    pthread_mutex_lock(&handle->lock);
+
+    // snapshot of the features before they are released
+    _sensor_state_release(handle);
+    _sensor_record_release(handle);
+    _sensor_share_release(handle);
+    _sensor_stats_release(handle);
+    _sensor_gyro_integrator_release(handle);
+    _sensor_device_orientation_release(handle);
+    _sensor_pedometer_release(handle);
+    _sensor_spectrum_release(handle);
+    _sensor_sync_release(handle);
+    _sensor_motion_fallback_release(handle);
+    _sensor_adaptive_rate_release(handle);
+    _sensor_magnetic_calibration_release(handle);
+    _sensor_gyroscope_bias_release(handle);
+    _sensor_latency_release(handle);
+    _sensor_jitter_release(handle);
+
+    pthread_mutex_unlock(&handle->lock);
+
     for(i=0; i<ID_NUMBERS; i++){
         if( handle->ids[i] >= 0 ){
-            if(sf_disconnect(handle->ids[i]) < 0)
+            if(_sensor_backend()->disconnect(handle->ids[i]) < 0)
                 failed = true;
             else
                 handle->ids[i] = -1;
         }
     }
 
-    free(handle);
+    // destroyed from one of its callbacks, the dispatch frees it on its return
+    pthread_mutex_lock(&handle->lock);
+    if(handle->dispatching > 0){
+        handle->destroyed = 1;
+        pthread_mutex_unlock(&handle->lock);
+        return SENSOR_ERROR_NONE;
+    }
+    pthread_mutex_unlock(&handle->lock);
+
+    _sensor_free(handle);
     handle = NULL;
 
     return SENSOR_ERROR_NONE;
 }
 
+static bool _sensor_id_started(sensor_h handle, sensor_type_e type)
+{
+    int i;
+
+    for(i=0; i<CB_NUMBERS; i++){
+        if(i != type && _SID(_SOURCE(handle, i)) == _SID(_SOURCE(handle, type)) && handle->started[i])
+            return true;
+    }
+    return false;
+}
+
 int sensor_start(sensor_h handle, sensor_type_e type)
 {
     int err;
@@ -473,14 +641,22 @@ int sensor_start(sensor_h handle, sensor_type_e type)
 	RETURN_IF_NOT_HANDLE(handle);
     RETURN_IF_NOT_TYPE(type);
 
-    if( (err = _sensor_connect(handle, type)) != SENSOR_ERROR_NONE){
+    if( (err = _sensor_connect(handle, _SOURCE(handle, type))) != SENSOR_ERROR_NONE){
         return err;
     }
 
-	if (sf_start(handle->ids[_SID(type)], 0) < 0) {
+    if(_sensor_id_started(handle, type)){
+        handle->started[type] = 1;
+        return SENSOR_ERROR_NONE;
+    }
+
+    // a backend delivering from its own thread may call back before start returns
+    handle->started[type] = 1;
+
+	if (_sensor_backend()->start(handle->ids[_SID(_SOURCE(handle, type))], 0) < 0) {
+        handle->started[type] = 0;
         RETURN_ERROR(SENSOR_ERROR_IO_ERROR);
     } else {
-        handle->started[type] = 1;
         return SENSOR_ERROR_NONE;
     }
 }
@@ -490,7 +666,14 @@ int sensor_stop(sensor_h handle, sensor_type_e type)
     DEBUG_PRINT("sensor_stop");
 	RETURN_IF_NOT_HANDLE(handle);
     RETURN_IF_NOT_TYPE(type);
-	if (sf_stop(handle->ids[_SID(type)]) < 0) {
+
+    // another type still uses the same sensor connection
+    if(_sensor_id_started(handle, type)){
+        handle->started[type] = 0;
+        return SENSOR_ERROR_NONE;
+    }
+
+	if (_sensor_backend()->stop(handle->ids[_SID(_SOURCE(handle, type))]) < 0) {
         RETURN_ERROR(SENSOR_ERROR_IO_ERROR);
     } else {
         handle->started[type] = 0;
@@ -525,6 +708,7 @@ static void _sensor_calibration (unsigned int event_type, sensor_event_data_t* e
 static int _sensor_set_calibration_cb(sensor_h handle, sensor_type_e type, sensor_calibration_cb callback, void *user_data)
 {
 	int ret, err;
+    unsigned long long begin;
 
     DEBUG_PRINTF("%s sensor register calibration callback", TYPE_NAME(type));
 
@@ -538,7 +722,7 @@ static int _sensor_set_calibration_cb(sensor_h handle, sensor_type_e type, senso
             RETURN_ERROR(SENSOR_ERROR_NOT_NEED_CALIBRATION);
     }
 
-    ret = sf_is_sensor_event_available( _TYPE[type], _CALIBRATION[type] );
+    ret = _sensor_backend()->is_sensor_event_available( _TYPE[type], _CALIBRATION[type] );
     if (ret != 0 ){
         DEBUG_PRINTF("Unsupported calibration ret=[%d] error=[%d] legacy=[%d] type=[%d] cal_id=[%d]", ret, SENSOR_ERROR_NOT_NEED_CALIBRATION, type, _TYPE[type], _CALIBRATION[type]);
         RETURN_ERROR(SENSOR_ERROR_NOT_NEED_CALIBRATION);
@@ -553,7 +737,10 @@ static int _sensor_set_calibration_cb(sensor_h handle, sensor_type_e type, senso
 
     DEBUG_PRINTF("type : %s / id : %d / event : %x ", TYPE_NAME(type), handle->ids[_SID(type)], _CALIBRATION[type]);
 
-	ret = sf_register_event(handle->ids[_SID(type)], _CALIBRATION[type], NULL, _sensor_calibration, handle);
+    _COUNT(handle->counters[type].register_calls, 1);
+    begin = _TRACE_BEGIN();
+	ret = _sensor_backend()->register_event(handle->ids[_SID(type)], _CALIBRATION[type], NULL, _sensor_calibration, handle);
+    _TRACE_END(TRACE_REGISTER, type, begin);
 	if(ret < 0){
 		handle->calib_func[type] = NULL;
 		handle->calib_user_data[type] = NULL;
@@ -569,6 +756,7 @@ static int _sensor_set_calibration_cb(sensor_h handle, sensor_type_e type, senso
 static int _sensor_unset_calibration_cb(sensor_h handle, sensor_type_e type)
 {
 	int ret;
+    unsigned long long begin;
 
     DEBUG_PRINTF("%s sensor register calibration callback", TYPE_NAME(type));
 
@@ -585,7 +773,10 @@ static int _sensor_unset_calibration_cb(sensor_h handle, sensor_type_e type)
     if(handle->calib_func[type] == NULL)
         return SENSOR_ERROR_NONE;
 
-	ret = sf_unregister_event(handle->ids[_SID(type)], _CALIBRATION[type]);
+    _COUNT(handle->counters[type].register_calls, 1);
+    begin = _TRACE_BEGIN();
+	ret = _sensor_backend()->unregister_event(handle->ids[_SID(type)], _CALIBRATION[type]);
+    _TRACE_END(TRACE_UNREGISTER, type, begin);
 
     if (ret < 0){
         if(ret == -2)
@@ -601,59 +792,64 @@ static int _sensor_unset_calibration_cb(sensor_h handle, sensor_type_e type)
 }
 
 
-static int _sensor_set_data_cb (sensor_h handle, sensor_type_e type, int rate, void* cb, void* user_data)
+static int _sensor_register_event(sensor_h handle, sensor_type_e type, int rate)
 {
     int err = 0;
+    unsigned long long begin;
 	event_condition_t condition;
 
-	RETURN_IF_NOT_HANDLE(handle);
-    RETURN_IF_NOT_TYPE(type);
-
-    DEBUG_PRINTF("sensor register callback %s", TYPE_NAME(type));
+    if( (err = _sensor_connect(handle, type)) != SENSOR_ERROR_NONE){
+        DEBUG_PRINTF("%s sensor connect error legacy=[%d] err=[%d]", TYPE_NAME(type), type, err);
+        return err;
+    }
 
-    if(rate < 0){
-        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+    if(handle->registered[type]){
+        if(handle->rate[type] == rate)
+            return SENSOR_ERROR_NONE;
+        _COUNT(handle->counters[type].register_calls, 1);
+        begin = _TRACE_BEGIN();
+        _sensor_backend()->unregister_event(handle->ids[_SID(type)], _EVENT[type]);
+        _TRACE_END(TRACE_UNREGISTER, type, begin);
+        handle->registered[type] = 0;
     }
-	
+
 	if(rate > 0){
 		condition.cond_op = CONDITION_EQUAL;
 		condition.cond_value1 = rate;
 	}
 
-	handle->cb_func[type] = cb; 
-	handle->cb_user_data[type] = user_data;
-
-    if( (err = _sensor_connect(handle, type)) != SENSOR_ERROR_NONE){
-        DEBUG_PRINTF("%s sensor connect error handle=[%d] legacy=[%d] err=[%d]", TYPE_NAME(type), handle, type, err);
-        return err;
-    }
-
-    err = sf_register_event(handle->ids[_SID(type)], _EVENT[type],
+    _COUNT(handle->counters[type].register_calls, 1);
+    begin = _TRACE_BEGIN();
+    err = _sensor_backend()->register_event(handle->ids[_SID(type)], _EVENT[type],
 				(rate > 0 ? &condition : NULL), _sensor_callback, handle);
+    _TRACE_END(TRACE_REGISTER, type, begin);
 
     DEBUG_PRINTF("%s sensor register function return [%d] event=[%d]", TYPE_NAME(type), err, _EVENT[type]);
 
     if(err < 0){
-        handle->cb_func[type] = NULL;
-        handle->cb_user_data[type] = NULL;
         if(err == -2)
             RETURN_ERROR(SENSOR_ERROR_IO_ERROR);
         else
             RETURN_ERROR(SENSOR_ERROR_OPERATION_FAILED);
     }
 
+    handle->registered[type] = 1;
+    handle->rate[type] = rate;
     return SENSOR_ERROR_NONE;
 }
 
-static int _sensor_unset_data_cb (sensor_h handle, sensor_type_e type)
+static int _sensor_unregister_event(sensor_h handle, sensor_type_e type)
 {
     int error;
-    DEBUG_PRINTF("sensor unregister callback %s", TYPE_NAME(type));
-	RETURN_IF_NOT_HANDLE(handle);
-    if (handle->ids[_SID(type)] < 0 )
-        return SENSOR_ERROR_INVALID_PARAMETER;
+    unsigned long long begin;
+
+    if(!handle->registered[type])
+        return SENSOR_ERROR_NONE;
 
-    error = sf_unregister_event(handle->ids[_SID(type)], _EVENT[type]);
+    _COUNT(handle->counters[type].register_calls, 1);
+    begin = _TRACE_BEGIN();
+    error = _sensor_backend()->unregister_event(handle->ids[_SID(type)], _EVENT[type]);
+    _TRACE_END(TRACE_UNREGISTER, type, begin);
 
     if (error < 0){
         if(error == -2)
@@ -662,8 +858,175 @@ static int _sensor_unset_data_cb (sensor_h handle, sensor_type_e type)
             RETURN_ERROR(SENSOR_ERROR_OPERATION_FAILED);
     }
 
-    handle->cb_func[type] = NULL;
-    handle->cb_user_data[type] = NULL;
+    handle->registered[type] = 0;
+    handle->rate[type] = 0;
+    return SENSOR_ERROR_NONE;
+}
+
+// the fastest of the intervals asked for the stream, 0 when nobody asks for one
+static int _sensor_listen_rate(sensor_h handle, sensor_type_e type)
+{
+    int i, rate = handle->user_rate[type];
+
+    if(handle->adaptive_rate[type] != NULL)
+        rate = _sensor_adaptive_rate_interval(handle, type, rate);
+
+    for(i=0; i<handle->listeners[type]; i++){
+        int r = handle->listener_rate[type][i];
+        if(r > 0 && (rate == 0 || r < rate))
+            rate = r;
+    }
+    return rate;
+}
+
+int _sensor_listen(sensor_h handle, sensor_type_e type, int rate)
+{
+    int err;
+
+	RETURN_IF_NOT_HANDLE(handle);
+    RETURN_IF_NOT_TYPE(type);
+
+    if(handle->listeners[type] >= LISTENER_NUMBERS)
+        RETURN_ERROR(SENSOR_ERROR_OPERATION_FAILED);
+
+    handle->listener_rate[type][handle->listeners[type]++] = rate;
+
+    if(!handle->registered[type])
+        err = _sensor_register_event(handle, type, _sensor_listen_rate(handle, type));
+    else
+        err = _sensor_update_rate(handle, type);
+
+    if(err != SENSOR_ERROR_NONE){
+        handle->listeners[type]--;
+        return err;
+    }
+    return SENSOR_ERROR_NONE;
+}
+
+int _sensor_unlisten(sensor_h handle, sensor_type_e type, int rate)
+{
+    int i;
+
+	RETURN_IF_NOT_HANDLE(handle);
+    RETURN_IF_NOT_TYPE(type);
+
+    for(i=0; i<handle->listeners[type]; i++){
+        if(handle->listener_rate[type][i] == rate)
+            break;
+    }
+    if(i == handle->listeners[type])
+        return SENSOR_ERROR_NONE;
+
+    handle->listeners[type]--;
+    handle->listener_rate[type][i] = handle->listener_rate[type][handle->listeners[type]];
+
+    if(handle->listeners[type] == 0 && handle->cb_func[type] == NULL)
+        return _sensor_unregister_event(handle, type);
+
+    return _sensor_update_rate(handle, type);
+}
+
+// changes the interval of a registered event, a failed change keeps the previous one
+int _sensor_update_rate(sensor_h handle, sensor_type_e type)
+{
+    int err;
+    int previous = handle->rate[type];
+    int rate = _sensor_listen_rate(handle, type);
+
+    if(!handle->registered[type] || previous == rate)
+        return SENSOR_ERROR_NONE;
+
+    if( (err = _sensor_register_event(handle, type, rate)) != SENSOR_ERROR_NONE){
+        _sensor_register_event(handle, type, previous);
+        return err;
+    }
+    return SENSOR_ERROR_NONE;
+}
+
+// a callback is delivered with its own user data and kind, the three change together
+static void _sensor_store_cb(sensor_h handle, sensor_type_e type, void* cb, void* user_data, int batch)
+{
+    pthread_mutex_lock(&handle->lock);
+    handle->cb_func[type] = cb;
+    handle->cb_user_data[type] = user_data;
+    handle->batch[type] = batch;
+    pthread_mutex_unlock(&handle->lock);
+}
+
+static int _sensor_set_cb (sensor_h handle, sensor_type_e type, int rate, void* cb, void* user_data, int batch)
+{
+    int err = 0;
+
+	RETURN_IF_NOT_HANDLE(handle);
+    RETURN_IF_NOT_TYPE(type);
+
+    DEBUG_PRINTF("sensor register callback %s", TYPE_NAME(type));
+
+    if(rate < 0){
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+    }
+
+    // ages of the delivered samples, from the first callback on
+    if(type <= SENSOR_PROXIMITY && (err = _sensor_latency_create(handle, type)) != SENSOR_ERROR_NONE)
+        return err;
+
+    if(handle->fallback[type] || _sensor_motion_fallback(type)){
+        if( (err = _sensor_motion_fallback_enable(handle, type)) != SENSOR_ERROR_NONE)
+            return err;
+
+        _sensor_store_cb(handle, type, cb, user_data, batch);
+        return SENSOR_ERROR_NONE;
+    }
+
+    _sensor_store_cb(handle, type, cb, user_data, batch);
+    handle->user_rate[type] = rate;
+
+    if(handle->adaptive_rate[type] != NULL)
+        _sensor_adaptive_rate_reset(handle, type, rate);
+
+    err = _sensor_register_event(handle, type, _sensor_listen_rate(handle, type));
+    if(err != SENSOR_ERROR_NONE){
+        _sensor_store_cb(handle, type, NULL, NULL, 0);
+        handle->user_rate[type] = 0;
+        if(handle->listeners[type] > 0)
+            _sensor_register_event(handle, type, _sensor_listen_rate(handle, type));
+        return err;
+    }
+
+    return SENSOR_ERROR_NONE;
+}
+
+static int _sensor_set_data_cb (sensor_h handle, sensor_type_e type, int rate, void* cb, void* user_data)
+{
+    return _sensor_set_cb(handle, type, rate, cb, user_data, 0);
+}
+
+static int _sensor_unset_data_cb (sensor_h handle, sensor_type_e type)
+{
+    int error;
+    DEBUG_PRINTF("sensor unregister callback %s", TYPE_NAME(type));
+	RETURN_IF_NOT_HANDLE(handle);
+
+    if(handle->fallback[type]){
+        _sensor_store_cb(handle, type, NULL, NULL, 0);
+        return _sensor_motion_fallback_disable(handle, type);
+    }
+
+    if (handle->ids[_SID(type)] < 0 )
+        return SENSOR_ERROR_INVALID_PARAMETER;
+
+    if(handle->listeners[type] == 0){
+        error = _sensor_unregister_event(handle, type);
+        if(error != SENSOR_ERROR_NONE)
+            return error;
+    }
+
+    _sensor_store_cb(handle, type, NULL, NULL, 0);
+    handle->user_rate[type] = 0;
+
+    // in-library consumers still need the event stream, at their own rates
+    if(handle->listeners[type] > 0)
+        return _sensor_update_rate(handle, type);
     return SENSOR_ERROR_NONE;
 }
 
@@ -749,10 +1112,29 @@ int sensor_proximity_unset_cb                  (sensor_h handle)
     return _sensor_unset_data_cb(handle, SENSOR_PROXIMITY);
 }
 
+int sensor_batch_set_cb(sensor_h handle, sensor_type_e type, int interval_ms, sensor_batch_cb callback, void *user_data)
+{
+    RETURN_IF_NOT_TYPE(type);
+    if(type > SENSOR_PROXIMITY || callback == NULL)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    return _sensor_set_cb(handle, type, interval_ms, (void*) callback, user_data, 1);
+}
+
+int sensor_batch_unset_cb(sensor_h handle, sensor_type_e type)
+{
+    RETURN_IF_NOT_TYPE(type);
+    if(type > SENSOR_PROXIMITY)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    return _sensor_unset_data_cb(handle, type);
+}
+
 static int _sensor_read_data(sensor_h handle, sensor_type_e type, 
 		sensor_data_accuracy_e* accuracy, float* values, int values_size)
 {
     int err = 0;
+    unsigned long long begin;
 	sensor_data_t data;
 
 	RETURN_IF_NOT_HANDLE(handle);
@@ -764,11 +1146,23 @@ static int _sensor_read_data(sensor_h handle, sensor_type_e type,
 
     if( (err = _sensor_connect(handle, type)) != SENSOR_ERROR_NONE)
         return err;
-	if ( sf_get_data(handle->ids[_SID(type)], _DTYPE[type], &data) < 0 )
+    _COUNT(handle->counters[type].read_calls, 1);
+    begin = _TRACE_BEGIN();
+    err = _sensor_backend()->get_data(handle->ids[_SID(type)], _DTYPE[type], &data);
+    _TRACE_END(TRACE_GET_DATA, type, begin);
+	if ( err < 0 )
     {
         RETURN_ERROR(SENSOR_ERROR_IO_ERROR);
     }
 
+    // the correction the samples of the stream get
+    pthread_mutex_lock(&handle->lock);
+    if(type == SENSOR_MAGNETIC && handle->magnetic_calibration != NULL)
+        _sensor_magnetic_calibration_correct(handle, &data);
+    if(type == SENSOR_GYROSCOPE && handle->gyroscope_bias != NULL)
+        _sensor_gyroscope_bias_correct(handle, &data);
+    pthread_mutex_unlock(&handle->lock);
+
 	// this error will never happen. but it exist for more safe code.. 
 	if(values_size > 12 || values_size < 0)
         RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
@@ -923,3 +1317,27 @@ int sensor_motion_facedown_unset_cb (sensor_h handle)
 {
     return _sensor_unset_data_cb(handle, SENSOR_MOTION_FACEDOWN);
 }
+
+int sensor_get_stats(sensor_h sensor, sensor_type_e type, sensor_runtime_stats_s *stats)
+{
+    struct sensor_counters_s* c;
+    int i;
+
+    RETURN_IF_NOT_HANDLE(sensor);
+    RETURN_IF_NOT_TYPE(type);
+    if(stats == NULL)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    c = &sensor->counters[type];
+    stats->events = __atomic_load_n(&c->events, __ATOMIC_RELAXED);
+    stats->samples_delivered = __atomic_load_n(&c->samples_delivered, __ATOMIC_RELAXED);
+    stats->samples_dropped = __atomic_load_n(&c->samples_dropped, __ATOMIC_RELAXED);
+    stats->unknown_events = __atomic_load_n(&sensor->unknown_events, __ATOMIC_RELAXED);
+    stats->connect_calls = __atomic_load_n(&c->connect_calls, __ATOMIC_RELAXED);
+    stats->read_calls = __atomic_load_n(&c->read_calls, __ATOMIC_RELAXED);
+    stats->register_calls = __atomic_load_n(&c->register_calls, __ATOMIC_RELAXED);
+    for(i=0; i<SENSOR_STATS_CALLBACK_BUCKETS; i++)
+        stats->callback_time[i] = __atomic_load_n(&c->callback_time[i], __ATOMIC_RELAXED);
+
+    return SENSOR_ERROR_NONE;
+}
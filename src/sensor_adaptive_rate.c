@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) 2011 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <sensor_framework_private.h>
+#include <sensors.h>
+#include <sensor_private.h>
+
+// the device has to stay still this long before the rate is lowered
+#define STILL_US                2000000ull
+
+#define ACCEL_STILL             0.4f    // m/s^2 away from the first still sample
+#define GYRO_STILL              3.0f    // degrees/s
+
+// a longer silence is a stopped stream, it is not accounted to any rate
+#define MAX_DELTA_US            2000000ull
+
+struct sensor_adaptive_rate_s {
+    int full_interval;
+    int floor_interval;
+    int lowered;
+
+    float reference[3];
+    unsigned long long still_since;
+    unsigned long long last_time_stamp;
+    unsigned long long retry_at;
+
+    unsigned int seq;
+    sensor_adaptive_rate_stats_s stats;
+};
+
+static bool _sensor_adaptive_rate_still(sensor_type_e type, struct sensor_adaptive_rate_s* a, const float* v)
+{
+    int k;
+
+    for(k=0; k<3; k++){
+        if(type == SENSOR_GYROSCOPE){
+            if(v[k] > GYRO_STILL || v[k] < -GYRO_STILL)
+                return false;
+        }else{
+            float d = v[k] - a->reference[k];
+            if(d > ACCEL_STILL || d < -ACCEL_STILL)
+                return false;
+        }
+    }
+    return true;
+}
+
+// the floor only slows the stream down as far as the listeners of the stream let it
+static void _sensor_adaptive_rate_switch(sensor_h handle, sensor_type_e type, struct sensor_adaptive_rate_s* a, int lowered, unsigned long long ts)
+{
+    if(ts < a->retry_at)
+        return;
+
+    a->lowered = lowered;
+    if(_sensor_update_rate(handle, type) != SENSOR_ERROR_NONE){
+        // a failed switch is tried again after a still period, not on every batch
+        a->lowered = !lowered;
+        a->retry_at = ts + STILL_US;
+        return;
+    }
+
+    _sensor_seq_write_begin(&a->seq);
+    a->stats.current_interval_ms = handle->rate[type];
+    a->stats.switches++;
+    _sensor_seq_write_end(&a->seq);
+}
+
+// the interval asked by the user callback, or the floor while the device is still
+int _sensor_adaptive_rate_interval(sensor_h handle, sensor_type_e type, int interval)
+{
+    struct sensor_adaptive_rate_s* a = handle->adaptive_rate[type];
+
+    return a->lowered ? a->floor_interval : interval;
+}
+
+void _sensor_adaptive_rate_feed(sensor_h handle, sensor_type_e type, sensor_data_t* data, int data_num)
+{
+    int i;
+    struct sensor_adaptive_rate_s* a = handle->adaptive_rate[type];
+    unsigned long long full_time = 0, floor_time = 0;
+
+    for(i=0; i<data_num; i++){
+        unsigned long long ts = data[i].time_stamp;
+
+        if(a->last_time_stamp != 0 && ts > a->last_time_stamp && ts - a->last_time_stamp <= MAX_DELTA_US){
+            if(a->lowered)
+                floor_time += ts - a->last_time_stamp;
+            else
+                full_time += ts - a->last_time_stamp;
+        }
+        a->last_time_stamp = ts;
+
+        if(a->still_since != 0 && _sensor_adaptive_rate_still(type, a, data[i].values))
+            continue;
+
+        // moving, or the first sample of a still period
+        memcpy(a->reference, data[i].values, sizeof(a->reference));
+        a->still_since = ts;
+
+        if(a->lowered)
+            _sensor_adaptive_rate_switch(handle, type, a, 0, ts);
+    }
+
+    if(!a->lowered && a->still_since != 0 && a->last_time_stamp - a->still_since >= STILL_US)
+        _sensor_adaptive_rate_switch(handle, type, a, 1, a->last_time_stamp);
+
+    _sensor_seq_write_begin(&a->seq);
+    a->stats.full_time_us += full_time;
+    a->stats.floor_time_us += floor_time;
+    _sensor_seq_write_end(&a->seq);
+}
+
+// the interval of the stream was set by the user, it is the new full rate
+void _sensor_adaptive_rate_reset(sensor_h handle, sensor_type_e type, int interval)
+{
+    struct sensor_adaptive_rate_s* a = handle->adaptive_rate[type];
+
+    a->full_interval = interval;
+    a->lowered = 0;
+    a->still_since = 0;
+    a->retry_at = 0;
+
+    _sensor_seq_write_begin(&a->seq);
+    a->stats.full_interval_ms = interval;
+    a->stats.current_interval_ms = interval;
+    _sensor_seq_write_end(&a->seq);
+}
+
+void _sensor_adaptive_rate_release(sensor_h handle)
+{
+    int i;
+
+    for(i=0; i<CB_NUMBERS; i++){
+        free(handle->adaptive_rate[i]);
+        handle->adaptive_rate[i] = NULL;
+    }
+}
+
+int sensor_adaptive_rate_set(sensor_h sensor, sensor_type_e type, int floor_interval_ms)
+{
+    int err;
+    struct sensor_adaptive_rate_s* a;
+
+    DEBUG_PRINT("sensor_adaptive_rate_set");
+
+    RETURN_IF_NOT_HANDLE(sensor);
+    if(type != SENSOR_ACCELEROMETER && type != SENSOR_GYROSCOPE)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+    if(floor_interval_ms <= 0 || !sensor->registered[type])
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    a = sensor->adaptive_rate[type];
+    if(a == NULL){
+        a = (struct sensor_adaptive_rate_s*)calloc(1, sizeof(struct sensor_adaptive_rate_s));
+        if(a == NULL)
+            RETURN_ERROR(SENSOR_ERROR_OUT_OF_MEMORY);
+        sensor->adaptive_rate[type] = a;
+    }
+
+    _sensor_adaptive_rate_reset(sensor, type, sensor->user_rate[type]);
+    a->floor_interval = floor_interval_ms;
+
+    err = _sensor_update_rate(sensor, type);
+
+    _sensor_seq_write_begin(&a->seq);
+    a->stats.floor_interval_ms = floor_interval_ms;
+    a->stats.current_interval_ms = sensor->rate[type];
+    _sensor_seq_write_end(&a->seq);
+
+    return err;
+}
+
+int sensor_adaptive_rate_unset(sensor_h sensor, sensor_type_e type)
+{
+    struct sensor_adaptive_rate_s* a;
+
+    DEBUG_PRINT("sensor_adaptive_rate_unset");
+
+    RETURN_IF_NOT_HANDLE(sensor);
+    RETURN_IF_NOT_TYPE(type);
+
+    a = sensor->adaptive_rate[type];
+    if(a == NULL)
+        return SENSOR_ERROR_NONE;
+
+    pthread_mutex_lock(&sensor->lock);
+    sensor->adaptive_rate[type] = NULL;
+    pthread_mutex_unlock(&sensor->lock);
+    free(a);
+
+    return _sensor_update_rate(sensor, type);
+}
+
+int sensor_adaptive_rate_get_stats(sensor_h sensor, sensor_type_e type, sensor_adaptive_rate_stats_s *stats)
+{
+    unsigned int seq;
+    struct sensor_adaptive_rate_s* a;
+
+    RETURN_IF_NOT_HANDLE(sensor);
+    RETURN_IF_NOT_TYPE(type);
+
+    a = sensor->adaptive_rate[type];
+    if(a == NULL || stats == NULL)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    do {
+        seq = _sensor_seq_read_begin(&a->seq);
+        memcpy(stats, &a->stats, sizeof(*stats));
+    } while(_sensor_seq_read_retry(&a->seq, seq));
+
+    return SENSOR_ERROR_NONE;
+}
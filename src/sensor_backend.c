@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2011 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include <sensor_framework_private.h>
+#include <sensors.h>
+#include <sensor_private.h>
+
+#define MOCK_ENV            "CAPI_SENSOR_MOCK"
+#define REPLAY_ENV          "CAPI_SENSOR_REPLAY"
+#define REPLAY_SPEED_ENV    "CAPI_SENSOR_REPLAY_SPEED"
+
+#ifndef SENSOR_WITHOUT_FRAMEWORK
+static const struct sensor_backend_s _sensor_framework_backend = {
+    sf_connect,
+    sf_disconnect,
+    sf_start,
+    sf_stop,
+    sf_register_event,
+    sf_unregister_event,
+    sf_get_data,
+    sf_get_properties,
+    sf_get_data_properties,
+    sf_is_sensor_event_available,
+};
+
+#define DEFAULT_BACKEND     (&_sensor_framework_backend)
+#else
+#define DEFAULT_BACKEND     (&_sensor_mock_backend)
+#endif
+
+// the backend used when no replay is set
+static const struct sensor_backend_s* _default = DEFAULT_BACKEND;
+static const struct sensor_backend_s* _backend = DEFAULT_BACKEND;
+static pthread_once_t _backend_once = PTHREAD_ONCE_INIT;
+
+// the handles alive hold connections of the backend, it is not switched under them
+static int _handles = 0;
+
+static void _sensor_backend_init(void)
+{
+    const char* mock = getenv(MOCK_ENV);
+    const char* path = getenv(REPLAY_ENV);
+    const char* speed = getenv(REPLAY_SPEED_ENV);
+
+    if(mock != NULL && *mock != '\0' && strcmp(mock, "0") != 0)
+        _backend = _default = &_sensor_mock_backend;
+
+    if(path == NULL || *path == '\0')
+        return;
+
+    if(_sensor_replay_open(path, speed != NULL ? atof(speed) : 1.0f) == SENSOR_ERROR_NONE)
+        _backend = &_sensor_replay_backend;
+    else
+        DEBUG_PRINTF("cannot replay %s, the default backend is used", path);
+}
+
+const struct sensor_backend_s* _sensor_backend(void)
+{
+    pthread_once(&_backend_once, _sensor_backend_init);
+    return _backend;
+}
+
+void _sensor_backend_hold(int count)
+{
+    __atomic_add_fetch(&_handles, count, __ATOMIC_RELAXED);
+}
+
+int sensor_replay_set(const char *path, float speed)
+{
+    int err;
+
+    DEBUG_PRINT("sensor_replay_set");
+
+    if(speed < 0 || __atomic_load_n(&_handles, __ATOMIC_RELAXED) > 0)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    // the environment is not looked at once a backend is chosen here
+    pthread_once(&_backend_once, _sensor_backend_init);
+
+    _sensor_replay_close();
+    _backend = _default;
+
+    if(path == NULL)
+        return SENSOR_ERROR_NONE;
+
+    if( (err = _sensor_replay_open(path, speed)) != SENSOR_ERROR_NONE )
+        return err;
+
+    _backend = &_sensor_replay_backend;
+    return SENSOR_ERROR_NONE;
+}
+
+int sensor_mock_set(bool enable)
+{
+    DEBUG_PRINT("sensor_mock_set");
+
+    if(__atomic_load_n(&_handles, __ATOMIC_RELAXED) > 0)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    pthread_once(&_backend_once, _sensor_backend_init);
+
+    if(enable){
+        _default = &_sensor_mock_backend;
+    }else{
+#ifdef SENSOR_WITHOUT_FRAMEWORK
+        RETURN_ERROR(SENSOR_ERROR_NOT_SUPPORTED);
+#else
+        _default = &_sensor_framework_backend;
+#endif
+    }
+
+    _sensor_replay_close();
+    _backend = _default;
+    return SENSOR_ERROR_NONE;
+}
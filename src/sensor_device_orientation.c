@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2011 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+
+#include <stdlib.h>
+
+#include <sensor_framework_private.h>
+#include <sensors.h>
+#include <sensor_private.h>
+
+/*
+ * Accelerations are compared in Q8 fixed point (1/256 m/s^2), so every
+ * threshold below is a squared magnitude or a ratio of integers instead of
+ * an angle.
+ */
+#define Q8(v)               ((long long)((v) * 256.0f))
+#define GRAVITY_Q8          2510ll                      // 9.80665 m/s^2
+
+// |a| must stay within [0.5g, 1.5g], otherwise the device is shaken or falling
+#define MIN_NORM2           ((GRAVITY_Q8 / 2) * (GRAVITY_Q8 / 2))
+#define MAX_NORM2           ((GRAVITY_Q8 * 3 / 2) * (GRAVITY_Q8 * 3 / 2))
+
+// lying flat when tilted less than 35 degrees: z^2 > cos^2(35) * |a|^2, cos^2(35) ~ 687/1024
+#define FLAT_COS2_Q10       687ll
+
+// leaving the current rotation needs the new axis to be 10 degrees past the diagonal: tan(55) ~ 10/7
+#define HYSTERESIS_NUM      10ll
+#define HYSTERESIS_DEN      7ll
+
+#define DEBOUNCE_US         200000ull
+
+struct sensor_device_orientation_s {
+    int current;
+    int pending;
+    unsigned long long pending_since;
+};
+
+static int _sensor_device_orientation_candidate(struct sensor_device_orientation_s* o, long long x, long long y, long long z)
+{
+    long long norm2 = x*x + y*y + z*z;
+    long long ax = x < 0 ? -x : x;
+    long long ay = y < 0 ? -y : y;
+    long long major, minor;
+    int candidate;
+
+    if(norm2 < MIN_NORM2 || norm2 > MAX_NORM2)
+        return -1;
+
+    if(z*z*1024 > FLAT_COS2_Q10 * norm2)
+        return -1;
+
+    if(ay >= ax){
+        candidate = y > 0 ? SENSOR_DEVICE_ORIENTATION_0 : SENSOR_DEVICE_ORIENTATION_180;
+        major = ay;
+        minor = ax;
+    }else{
+        candidate = x < 0 ? SENSOR_DEVICE_ORIENTATION_90 : SENSOR_DEVICE_ORIENTATION_270;
+        major = ax;
+        minor = ay;
+    }
+
+    if(o->current >= 0 && candidate != o->current && major * HYSTERESIS_DEN <= minor * HYSTERESIS_NUM)
+        return o->current;
+
+    return candidate;
+}
+
+void _sensor_device_orientation_feed(sensor_h handle, sensor_data_t* data, int data_num)
+{
+    int i;
+    int candidate;
+    struct sensor_device_orientation_s* o = handle->device_orientation;
+
+    for(i=0; i<data_num; i++){
+        candidate = _sensor_device_orientation_candidate(o,
+                Q8(data[i].values[0]), Q8(data[i].values[1]), Q8(data[i].values[2]));
+
+        if(candidate < 0 || candidate == o->current){
+            o->pending = -1;
+            continue;
+        }
+
+        if(candidate != o->pending){
+            o->pending = candidate;
+            o->pending_since = data[i].time_stamp;
+            continue;
+        }
+
+        if(data[i].time_stamp - o->pending_since < DEBOUNCE_US)
+            continue;
+
+        o->current = candidate;
+        o->pending = -1;
+
+        ((sensor_device_orientation_event_cb)handle->cb_func[SENSOR_DEVICE_ORIENTATION])
+            (data[i].time_stamp, o->current, handle->cb_user_data[SENSOR_DEVICE_ORIENTATION]);
+    }
+}
+
+void _sensor_device_orientation_release(sensor_h handle)
+{
+    free(handle->device_orientation);
+    handle->device_orientation = NULL;
+}
+
+int sensor_device_orientation_set_cb(sensor_h handle, sensor_device_orientation_event_cb callback, void *user_data)
+{
+    int err;
+    struct sensor_device_orientation_s* o;
+
+    DEBUG_PRINT("sensor_device_orientation_set_cb");
+
+    RETURN_IF_NOT_HANDLE(handle);
+    if(callback == NULL)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    o = handle->device_orientation;
+    if(o == NULL){
+        o = (struct sensor_device_orientation_s*)malloc(sizeof(struct sensor_device_orientation_s));
+        if(o == NULL)
+            RETURN_ERROR(SENSOR_ERROR_OUT_OF_MEMORY);
+
+        o->current = -1;
+        o->pending = -1;
+        o->pending_since = 0;
+
+        if( (err = _sensor_listen(handle, SENSOR_ACCELEROMETER, 0)) != SENSOR_ERROR_NONE ){
+            free(o);
+            return err;
+        }
+    }
+
+    // stored with the state, the dispatch of the accelerometer feeds under the handle lock
+    pthread_mutex_lock(&handle->lock);
+    handle->device_orientation = o;
+    handle->cb_user_data[SENSOR_DEVICE_ORIENTATION] = user_data;
+    handle->cb_func[SENSOR_DEVICE_ORIENTATION] = callback;
+    pthread_mutex_unlock(&handle->lock);
+
+    return SENSOR_ERROR_NONE;
+}
+
+int sensor_device_orientation_unset_cb(sensor_h handle)
+{
+    DEBUG_PRINT("sensor_device_orientation_unset_cb");
+
+    RETURN_IF_NOT_HANDLE(handle);
+
+    if(handle->device_orientation == NULL)
+        return SENSOR_ERROR_NONE;
+
+    _sensor_release(handle, _sensor_device_orientation_release);
+    handle->cb_func[SENSOR_DEVICE_ORIENTATION] = NULL;
+    handle->cb_user_data[SENSOR_DEVICE_ORIENTATION] = NULL;
+
+    return _sensor_unlisten(handle, SENSOR_ACCELEROMETER, 0);
+}
@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2011 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <sensor_framework_private.h>
+#include <sensors.h>
+#include <sensor_private.h>
+
+#define DEG2RAD         (M_PI / 180.0)
+
+// a gap longer than this is a stop/start of the stream, not a sample period
+#define MAX_DELTA_US    1000000ull
+
+struct sensor_gyro_integrator_s {
+    sensor_h sensor;
+    struct sensor_gyro_integrator_s* next;
+
+    int reset_pending;
+    unsigned long long last_time_stamp;
+    double q[4];    // x, y, z, w
+
+    unsigned int seq;
+    float published[4];
+};
+
+static void _sensor_gyro_integrator_identity(struct sensor_gyro_integrator_s* g)
+{
+    g->last_time_stamp = 0;
+    g->q[0] = g->q[1] = g->q[2] = 0;
+    g->q[3] = 1;
+
+    _sensor_seq_write_begin(&g->seq);
+    g->published[0] = g->published[1] = g->published[2] = 0;
+    g->published[3] = 1;
+    _sensor_seq_write_end(&g->seq);
+}
+
+static void _sensor_gyro_integrator_step(struct sensor_gyro_integrator_s* g, const float* rate, double dt)
+{
+    double wx = rate[0] * DEG2RAD;
+    double wy = rate[1] * DEG2RAD;
+    double wz = rate[2] * DEG2RAD;
+    double omega = sqrt(wx*wx + wy*wy + wz*wz);
+    double half = omega * dt * 0.5;
+    double s, dx, dy, dz, dw;
+    double x = g->q[0], y = g->q[1], z = g->q[2], w = g->q[3];
+    double norm;
+
+    if(omega < 1e-12)
+        return;
+
+    // rotation of the body frame during dt, applied on the right
+    s = sin(half) / omega;
+    dx = wx * s;
+    dy = wy * s;
+    dz = wz * s;
+    dw = cos(half);
+
+    g->q[0] = w*dx + x*dw + y*dz - z*dy;
+    g->q[1] = w*dy - x*dz + y*dw + z*dx;
+    g->q[2] = w*dz + x*dy - y*dx + z*dw;
+    g->q[3] = w*dw - x*dx - y*dy - z*dz;
+
+    norm = sqrt(g->q[0]*g->q[0] + g->q[1]*g->q[1] + g->q[2]*g->q[2] + g->q[3]*g->q[3]);
+    g->q[0] /= norm;
+    g->q[1] /= norm;
+    g->q[2] /= norm;
+    g->q[3] /= norm;
+}
+
+void _sensor_gyro_integrator_feed(struct sensor_gyro_integrator_s* g, sensor_data_t* data, int data_num)
+{
+    int i;
+
+    for(; g != NULL; g = g->next){
+        if(__atomic_exchange_n(&g->reset_pending, 0, __ATOMIC_ACQUIRE))
+            _sensor_gyro_integrator_identity(g);
+
+        for(i=0; i<data_num; i++){
+            unsigned long long ts = data[i].time_stamp;
+
+            if(g->last_time_stamp != 0 && ts > g->last_time_stamp && ts - g->last_time_stamp <= MAX_DELTA_US)
+                _sensor_gyro_integrator_step(g, data[i].values, (ts - g->last_time_stamp) / 1000000.0);
+
+            g->last_time_stamp = ts;
+        }
+
+        _sensor_seq_write_begin(&g->seq);
+        g->published[0] = g->q[0];
+        g->published[1] = g->q[1];
+        g->published[2] = g->q[2];
+        g->published[3] = g->q[3];
+        _sensor_seq_write_end(&g->seq);
+    }
+}
+
+void _sensor_gyro_integrator_release(sensor_h handle)
+{
+    struct sensor_gyro_integrator_s* g;
+
+    while( (g = handle->gyro_integrator) != NULL ){
+        handle->gyro_integrator = g->next;
+        free(g);
+    }
+}
+
+int sensor_gyro_integrator_create(sensor_h sensor, sensor_gyro_integrator_h *integrator)
+{
+    int err;
+    struct sensor_gyro_integrator_s* g;
+
+    DEBUG_PRINT("sensor_gyro_integrator_create");
+
+    RETURN_IF_NOT_HANDLE(sensor);
+    if(integrator == NULL)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    g = (struct sensor_gyro_integrator_s*)calloc(1, sizeof(struct sensor_gyro_integrator_s));
+    if(g == NULL)
+        RETURN_ERROR(SENSOR_ERROR_OUT_OF_MEMORY);
+
+    g->sensor = sensor;
+    _sensor_gyro_integrator_identity(g);
+
+    if( (err = _sensor_listen(sensor, SENSOR_GYROSCOPE, 0)) != SENSOR_ERROR_NONE ){
+        free(g);
+        return err;
+    }
+
+    g->next = sensor->gyro_integrator;
+    sensor->gyro_integrator = g;
+
+    *integrator = g;
+    return SENSOR_ERROR_NONE;
+}
+
+int sensor_gyro_integrator_destroy(sensor_gyro_integrator_h integrator)
+{
+    struct sensor_gyro_integrator_s** link;
+
+    DEBUG_PRINT("sensor_gyro_integrator_destroy");
+
+    if(integrator == NULL)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    pthread_mutex_lock(&integrator->sensor->lock);
+    for(link = &integrator->sensor->gyro_integrator; *link != NULL; link = &(*link)->next){
+        if(*link == integrator){
+            *link = integrator->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&integrator->sensor->lock);
+
+    _sensor_unlisten(integrator->sensor, SENSOR_GYROSCOPE, 0);
+    free(integrator);
+
+    return SENSOR_ERROR_NONE;
+}
+
+int sensor_gyro_integrator_reset(sensor_gyro_integrator_h integrator)
+{
+    if(integrator == NULL)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    // applied by the dispatch path, which is the only writer of the state
+    __atomic_store_n(&integrator->reset_pending, 1, __ATOMIC_RELEASE);
+
+    return SENSOR_ERROR_NONE;
+}
+
+int sensor_gyro_integrator_get(sensor_gyro_integrator_h integrator, float q[4])
+{
+    unsigned int seq;
+
+    if(integrator == NULL || q == NULL)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    do {
+        seq = _sensor_seq_read_begin(&integrator->seq);
+        memcpy(q, integrator->published, sizeof(integrator->published));
+    } while(_sensor_seq_read_retry(&integrator->seq, seq));
+
+    return SENSOR_ERROR_NONE;
+}
@@ -0,0 +1,249 @@
+/*
+ * Copyright (c) 2011 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <sensor_framework_private.h>
+#include <sensors.h>
+#include <sensor_private.h>
+
+/*
+ * Both streams keep an exponentially weighted mean and variance. The device
+ * rests when the two variances stay low for REST_US, the bias then follows
+ * the gyroscope rate. A slow steady rotation has a low gyroscope variance
+ * too, rates above MAX_BIAS are never taken for a bias.
+ */
+#define BIAS_ACCEL_INTERVAL_MS  20
+
+#define VARIANCE_RC             0.2f        // s
+#define BIAS_RC                 2.0f        // s
+
+#define ACCEL_REST_VARIANCE     0.05f       // (m/s^2)^2, sum of the axes
+#define GYRO_REST_VARIANCE      0.5f        // (degrees/s)^2, sum of the axes
+#define MAX_BIAS                5.0f        // degrees/s
+#define REST_US                 1000000ull
+
+// accelerometer samples older than this are not used, rest is then detected on the gyroscope alone
+#define ACCEL_RECENT_US         500000ull
+
+// a gap longer than this restarts the variance
+#define MAX_DELTA_US            1000000ull
+
+struct sensor_gyroscope_bias_variance_s {
+    unsigned long long last_time_stamp;
+    float dt;
+    float mean[3];
+    float variance;
+};
+
+struct sensor_gyroscope_bias_estimator_s {
+    struct sensor_gyroscope_bias_variance_s accel;
+    struct sensor_gyroscope_bias_variance_s gyro;
+    unsigned long long rest_since;
+
+    int valid;
+    float bias[3];
+};
+
+static void _sensor_gyroscope_bias_variance(struct sensor_gyroscope_bias_variance_s* s, const float* v, unsigned long long ts)
+{
+    int k;
+    float alpha, d2 = 0;
+
+    if(s->last_time_stamp == 0 || ts <= s->last_time_stamp || ts - s->last_time_stamp > MAX_DELTA_US){
+        s->last_time_stamp = ts;
+        s->dt = 0;
+        memcpy(s->mean, v, sizeof(s->mean));
+        s->variance = 0;
+        return;
+    }
+
+    s->dt = (ts - s->last_time_stamp) / 1000000.0f;
+    s->last_time_stamp = ts;
+    alpha = s->dt / (VARIANCE_RC + s->dt);
+
+    for(k=0; k<3; k++){
+        float d = v[k] - s->mean[k];
+        s->mean[k] += alpha * d;
+        d2 += d * d;
+    }
+    s->variance = (1 - alpha) * (s->variance + alpha * d2);
+}
+
+static int _sensor_gyroscope_bias_rest(struct sensor_gyroscope_bias_estimator_s* b, unsigned long long ts)
+{
+    int k;
+    unsigned long long accel_ts = b->accel.last_time_stamp;
+
+    if(b->gyro.variance > GYRO_REST_VARIANCE)
+        return 0;
+
+    for(k=0; k<3; k++){
+        if(b->gyro.mean[k] > MAX_BIAS || b->gyro.mean[k] < -MAX_BIAS)
+            return 0;
+    }
+
+    if(accel_ts != 0 && (ts > accel_ts ? ts - accel_ts : accel_ts - ts) <= ACCEL_RECENT_US)
+        return b->accel.variance <= ACCEL_REST_VARIANCE;
+    return 1;
+}
+
+void _sensor_gyroscope_bias_feed(sensor_h handle, sensor_type_e type, sensor_data_t* data, int data_num)
+{
+    int i, k;
+    struct sensor_gyroscope_bias_estimator_s* b = handle->gyroscope_bias;
+
+    for(i=0; i<data_num; i++){
+        float* v = data[i].values;
+        unsigned long long ts = data[i].time_stamp;
+
+        if(type == SENSOR_ACCELEROMETER){
+            _sensor_gyroscope_bias_variance(&b->accel, v, ts);
+            continue;
+        }
+
+        _sensor_gyroscope_bias_variance(&b->gyro, v, ts);
+
+        // the variance of a restarted stream is not known before REST_US
+        if(b->gyro.dt == 0 || !_sensor_gyroscope_bias_rest(b, ts)){
+            b->rest_since = 0;
+        }else if(b->rest_since == 0){
+            b->rest_since = ts;
+        }else if(ts - b->rest_since >= REST_US){
+            if(!b->valid){
+                memcpy(b->bias, b->gyro.mean, sizeof(b->bias));
+                b->valid = 1;
+            }else{
+                float beta = b->gyro.dt / (BIAS_RC + b->gyro.dt);
+                for(k=0; k<3; k++)
+                    b->bias[k] += (v[k] - b->bias[k]) * beta;
+            }
+        }
+
+        if(b->valid){
+            for(k=0; k<3; k++)
+                v[k] -= b->bias[k];
+        }
+    }
+}
+
+// a sample read outside of the stream, the rest detection does not see it
+void _sensor_gyroscope_bias_correct(sensor_h handle, sensor_data_t* data)
+{
+    int k;
+    struct sensor_gyroscope_bias_estimator_s* b = handle->gyroscope_bias;
+
+    if(!b->valid)
+        return;
+
+    for(k=0; k<3; k++)
+        data->values[k] -= b->bias[k];
+}
+
+void _sensor_gyroscope_bias_save(sensor_h handle, struct sensor_state_gyroscope_s* state)
+{
+    memcpy(state->bias, handle->gyroscope_bias->bias, sizeof(state->bias));
+    state->valid = handle->gyroscope_bias->valid;
+}
+
+void _sensor_gyroscope_bias_load(sensor_h handle, const struct sensor_state_gyroscope_s* state)
+{
+    if(!state->valid)
+        return;
+
+    memcpy(handle->gyroscope_bias->bias, state->bias, sizeof(state->bias));
+    handle->gyroscope_bias->valid = 1;
+}
+
+void _sensor_gyroscope_bias_release(sensor_h handle)
+{
+    free(handle->gyroscope_bias);
+    handle->gyroscope_bias = NULL;
+}
+
+int sensor_gyroscope_bias_compensation_set(sensor_h sensor, bool enable)
+{
+    int err;
+    struct sensor_gyroscope_bias_estimator_s* b;
+
+    DEBUG_PRINT("sensor_gyroscope_bias_compensation_set");
+
+    RETURN_IF_NOT_HANDLE(sensor);
+
+    if(!enable){
+        if(sensor->gyroscope_bias == NULL)
+            return SENSOR_ERROR_NONE;
+        _sensor_release(sensor, _sensor_gyroscope_bias_release);
+        return _sensor_unlisten(sensor, SENSOR_ACCELEROMETER, BIAS_ACCEL_INTERVAL_MS);
+    }
+
+    if(sensor->gyroscope_bias != NULL)
+        return SENSOR_ERROR_NONE;
+
+    b = (struct sensor_gyroscope_bias_estimator_s*)calloc(1, sizeof(struct sensor_gyroscope_bias_estimator_s));
+    if(b == NULL)
+        RETURN_ERROR(SENSOR_ERROR_OUT_OF_MEMORY);
+
+    if( (err = _sensor_listen(sensor, SENSOR_ACCELEROMETER, BIAS_ACCEL_INTERVAL_MS)) != SENSOR_ERROR_NONE ){
+        free(b);
+        return err;
+    }
+
+    sensor->gyroscope_bias = b;
+    _sensor_state_restore(sensor, SENSOR_STATE_GYROSCOPE);
+    return SENSOR_ERROR_NONE;
+}
+
+int sensor_gyroscope_bias_get(sensor_h sensor, sensor_gyroscope_bias_s *bias)
+{
+    struct sensor_gyroscope_bias_estimator_s* b;
+
+    RETURN_IF_NOT_HANDLE(sensor);
+
+    b = sensor->gyroscope_bias;
+    if(b == NULL || bias == NULL)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    memcpy(bias->bias, b->bias, sizeof(bias->bias));
+    bias->valid = b->valid;
+
+    return SENSOR_ERROR_NONE;
+}
+
+int sensor_gyroscope_bias_restore(sensor_h sensor, const sensor_gyroscope_bias_s *bias)
+{
+    struct sensor_gyroscope_bias_estimator_s* b;
+
+    DEBUG_PRINT("sensor_gyroscope_bias_restore");
+
+    RETURN_IF_NOT_HANDLE(sensor);
+
+    b = sensor->gyroscope_bias;
+    if(b == NULL || bias == NULL)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    if(!bias->valid)
+        return SENSOR_ERROR_NONE;
+
+    memcpy(b->bias, bias->bias, sizeof(b->bias));
+    b->valid = 1;
+
+    return SENSOR_ERROR_NONE;
+}
@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2011 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <sensor_framework_private.h>
+#include <sensors.h>
+#include <sensor_private.h>
+
+// the running moments of the intervals, everything derived is computed on read
+struct sensor_jitter_s {
+    unsigned int seq;
+
+    unsigned long long samples;
+    unsigned long long events;
+    unsigned long long first;
+    unsigned long long last;
+
+    unsigned long long intervals;
+    double mean;                // microseconds
+    double m2;
+    unsigned long long max_gap;
+    unsigned long long short_intervals;
+    unsigned long long missed_in_gaps;
+    double expected;            // samples the span should hold, each interval at the interval requested then
+    unsigned long long requested;   // microseconds, of the previous event
+};
+
+void _sensor_jitter_feed(sensor_h handle, sensor_type_e type, sensor_data_t* data, int data_num)
+{
+    struct sensor_jitter_s* j = handle->jitter[type];
+    unsigned long long requested = handle->rate[type] * 1000ull;
+    // the interval across a change of the requested one is counted as a single sample
+    int changed = j->samples > 0 && requested != j->requested;
+    int i;
+
+    _sensor_seq_write_begin(&j->seq);
+    j->events++;
+    j->requested = requested;
+
+    for(i=0; i<data_num; i++){
+        unsigned long long ts = data[i].time_stamp;
+        unsigned long long delta;
+        double d;
+
+        j->samples++;
+        if(j->samples == 1){
+            j->first = j->last = ts;
+            j->expected = 1;
+            continue;
+        }
+
+        // a repeated or older time stamp is counted as short, it has no interval
+        if(ts <= j->last){
+            j->short_intervals++;
+            continue;
+        }
+
+        delta = ts - j->last;
+        j->last = ts;
+
+        // Welford's update of the mean and the squared deviations
+        j->intervals++;
+        d = delta - j->mean;
+        j->mean += d / j->intervals;
+        j->m2 += d * (delta - j->mean);
+
+        if(delta > j->max_gap)
+            j->max_gap = delta;
+
+        // the interval changes with the adaptive rate, the expected count follows it
+        if(changed){
+            changed = 0;
+            j->expected += 1;
+            continue;
+        }
+        j->expected += requested > 0 ? (double)delta / requested : 1;
+
+        if(requested > 0){
+            if(delta * 2 < requested)
+                j->short_intervals++;
+            else if(delta >= requested + requested / 2)
+                j->missed_in_gaps += (delta + requested / 2) / requested - 1;
+        }
+    }
+
+    _sensor_seq_write_end(&j->seq);
+}
+
+void _sensor_jitter_release(sensor_h handle)
+{
+    int i;
+
+    for(i=0; i<CB_NUMBERS; i++){
+        free(handle->jitter[i]);
+        handle->jitter[i] = NULL;
+    }
+}
+
+int sensor_jitter_enable(sensor_h sensor, sensor_type_e type)
+{
+    struct sensor_jitter_s* j;
+
+    DEBUG_PRINT("sensor_jitter_enable");
+
+    RETURN_IF_NOT_HANDLE(sensor);
+    RETURN_IF_NOT_TYPE(type);
+    if(type > SENSOR_PROXIMITY)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    j = (struct sensor_jitter_s*)calloc(1, sizeof(struct sensor_jitter_s));
+    if(j == NULL)
+        RETURN_ERROR(SENSOR_ERROR_OUT_OF_MEMORY);
+
+    // enabling again starts over
+    pthread_mutex_lock(&sensor->lock);
+    free(sensor->jitter[type]);
+    sensor->jitter[type] = j;
+    pthread_mutex_unlock(&sensor->lock);
+
+    return SENSOR_ERROR_NONE;
+}
+
+int sensor_jitter_disable(sensor_h sensor, sensor_type_e type)
+{
+    struct sensor_jitter_s* j;
+
+    DEBUG_PRINT("sensor_jitter_disable");
+
+    RETURN_IF_NOT_HANDLE(sensor);
+    RETURN_IF_NOT_TYPE(type);
+
+    pthread_mutex_lock(&sensor->lock);
+    j = sensor->jitter[type];
+    sensor->jitter[type] = NULL;
+    pthread_mutex_unlock(&sensor->lock);
+    free(j);
+
+    return SENSOR_ERROR_NONE;
+}
+
+int sensor_jitter_get_stats(sensor_h sensor, sensor_type_e type, sensor_jitter_stats_s *stats)
+{
+    unsigned int seq;
+    struct sensor_jitter_s* j;
+    struct sensor_jitter_s copy;
+    double stddev;
+
+    RETURN_IF_NOT_HANDLE(sensor);
+    RETURN_IF_NOT_TYPE(type);
+
+    j = sensor->jitter[type];
+    if(j == NULL || stats == NULL)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    do {
+        seq = _sensor_seq_read_begin(&j->seq);
+        memcpy(&copy, j, sizeof(copy));
+    } while(_sensor_seq_read_retry(&j->seq, seq));
+
+    memset(stats, 0, sizeof(*stats));
+    stats->requested_interval_ms = sensor->rate[type];
+    stats->samples = copy.samples;
+    stats->events = copy.events;
+    stats->short_intervals = copy.short_intervals;
+    stats->missed_in_gaps = copy.missed_in_gaps;
+
+    if(copy.intervals == 0)
+        return SENSOR_ERROR_NONE;
+
+    stddev = copy.intervals > 1 ? sqrt(copy.m2 / (copy.intervals - 1)) : 0;
+    stats->mean_rate_hz = (copy.samples - 1) * 1e6 / (copy.last - copy.first);
+    stats->mean_interval_ms = copy.mean / 1000;
+    stats->stddev_interval_ms = stddev / 1000;
+    stats->max_gap_ms = copy.max_gap / 1000.0;
+    stats->burstiness = (stddev - copy.mean) / (stddev + copy.mean);
+
+    if(copy.expected > copy.samples)
+        stats->missed = (unsigned long long)(copy.expected - copy.samples + 0.5);
+
+    return SENSOR_ERROR_NONE;
+}
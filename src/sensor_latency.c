@@ -0,0 +1,262 @@
+/*
+ * Copyright (c) 2011 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <sensor_framework_private.h>
+#include <sensors.h>
+#include <sensor_private.h>
+
+/*
+ * Log-linear histogram of the sample ages in microseconds, as in HdrHistogram:
+ * the ages under 16 us have a bucket each, above every power of 2 is split in
+ * 8 buckets, so a bucket is never wider than 1/8 of its lower bound. Ages are
+ * clamped to 32 bits, a bit more than an hour.
+ */
+#define LATENCY_SUB_BITS    4
+#define LATENCY_SUB         (1 << LATENCY_SUB_BITS)
+#define LATENCY_HALF        (LATENCY_SUB / 2)
+#define LATENCY_BUCKETS     (LATENCY_SUB + (32 - LATENCY_SUB_BITS) * LATENCY_HALF)
+#define LATENCY_MAX_US      0xffffffffull
+
+struct sensor_latency_s {
+    // the clock the time stamps of the stream were taken on, found on its first sample
+    int clock_known;
+    clockid_t clock;
+
+    // since the histogram was created, added to with relaxed atomics
+    unsigned long long count[LATENCY_BUCKETS];
+
+    // budget window, only touched on the dispatch path
+    sensor_latency_budget_cb budget_cb;
+    void* budget_user_data;
+    unsigned int budget_us;
+    unsigned long long window_ns;
+    unsigned long long window_begin;
+    unsigned long long window[LATENCY_BUCKETS];
+    int window_reset;
+};
+
+static int _sensor_latency_bucket(unsigned long long us)
+{
+    int shift;
+
+    if(us < LATENCY_SUB)
+        return us;
+    if(us > LATENCY_MAX_US)
+        us = LATENCY_MAX_US;
+
+    shift = 63 - __builtin_clzll(us) - (LATENCY_SUB_BITS - 1);
+    return LATENCY_SUB + (shift - 1) * LATENCY_HALF + (int)(us >> shift) - LATENCY_HALF;
+}
+
+// highest age of a bucket, a percentile is never under the real one
+static unsigned int _sensor_latency_upper(int bucket)
+{
+    int shift, top;
+
+    if(bucket < LATENCY_SUB)
+        return bucket;
+
+    shift = (bucket - LATENCY_SUB) / LATENCY_HALF + 1;
+    top = (bucket - LATENCY_SUB) % LATENCY_HALF + LATENCY_HALF;
+    return (((unsigned long long)top + 1) << shift) - 1;
+}
+
+static unsigned int _sensor_latency_percentile(const unsigned long long* count, double percentile)
+{
+    unsigned long long total = 0, rank, seen = 0;
+    int i;
+
+    for(i=0; i<LATENCY_BUCKETS; i++)
+        total += count[i];
+    if(total == 0)
+        return 0;
+
+    rank = (unsigned long long)(percentile / 100.0 * total + 0.999999);
+    if(rank == 0)
+        rank = 1;
+
+    for(i=0; i<LATENCY_BUCKETS; i++){
+        seen += count[i];
+        if(seen >= rank)
+            break;
+    }
+    return _sensor_latency_upper(i < LATENCY_BUCKETS ? i : LATENCY_BUCKETS - 1);
+}
+
+static unsigned long long _sensor_latency_us(const struct timespec* t)
+{
+    return t->tv_sec * 1000000ull + t->tv_nsec / 1000;
+}
+
+static unsigned long long _sensor_latency_distance(unsigned long long a, unsigned long long b)
+{
+    return a > b ? a - b : b - a;
+}
+
+// the nearer of the monotonic and the wall clock, the sensor server has used both
+static void _sensor_latency_find_clock(struct sensor_latency_s* latency, const struct timespec* now, unsigned long long time_stamp)
+{
+    struct timespec real;
+    unsigned long long mono_us, real_us;
+
+    clock_gettime(CLOCK_REALTIME, &real);
+    mono_us = _sensor_latency_us(now);
+    real_us = _sensor_latency_us(&real);
+
+    latency->clock = _sensor_latency_distance(real_us, time_stamp) < _sensor_latency_distance(mono_us, time_stamp) ? CLOCK_REALTIME : CLOCK_MONOTONIC;
+    latency->clock_known = 1;
+}
+
+static void _sensor_latency_check_budget(struct sensor_latency_s* latency, sensor_type_e type, const struct timespec* now)
+{
+    unsigned long long now_ns = now->tv_sec * 1000000000ull + now->tv_nsec;
+    unsigned int p99;
+
+    if(latency->window_reset){
+        memset(latency->window, 0, sizeof(latency->window));
+        latency->window_begin = now_ns;
+        latency->window_reset = 0;
+        return;
+    }
+
+    if(now_ns - latency->window_begin < latency->window_ns)
+        return;
+
+    p99 = _sensor_latency_percentile(latency->window, 99.0);
+    memset(latency->window, 0, sizeof(latency->window));
+    latency->window_begin = now_ns;
+
+    if(p99 > latency->budget_us)
+        latency->budget_cb(type, p99, latency->budget_user_data);
+}
+
+void _sensor_latency_feed(struct sensor_latency_s* latency, sensor_type_e type, const struct timespec* now, sensor_data_t* data, int data_num)
+{
+    struct timespec real;
+    unsigned long long now_us;
+    int i, bucket;
+
+    if(data_num <= 0)
+        return;
+
+    if(!latency->clock_known)
+        _sensor_latency_find_clock(latency, now, data[0].time_stamp);
+
+    if(latency->clock == CLOCK_REALTIME){
+        clock_gettime(CLOCK_REALTIME, &real);
+        now_us = _sensor_latency_us(&real);
+    }else{
+        now_us = _sensor_latency_us(now);
+    }
+
+    for(i=0; i<data_num; i++){
+        // a time stamp ahead of the clock is a fresh sample
+        bucket = _sensor_latency_bucket(now_us > data[i].time_stamp ? now_us - data[i].time_stamp : 0);
+        _COUNT(latency->count[bucket], 1);
+        latency->window[bucket]++;
+    }
+
+    if(latency->budget_cb != NULL)
+        _sensor_latency_check_budget(latency, type, now);
+}
+
+int _sensor_latency_create(sensor_h handle, sensor_type_e type)
+{
+    if(handle->latency[type] != NULL)
+        return SENSOR_ERROR_NONE;
+
+    handle->latency[type] = (struct sensor_latency_s*)calloc(1, sizeof(struct sensor_latency_s));
+    if(handle->latency[type] == NULL)
+        RETURN_ERROR(SENSOR_ERROR_OUT_OF_MEMORY);
+
+    handle->latency[type]->window_reset = 1;
+    return SENSOR_ERROR_NONE;
+}
+
+void _sensor_latency_release(sensor_h handle)
+{
+    int i;
+
+    for(i=0; i<CB_NUMBERS; i++){
+        free(handle->latency[i]);
+        handle->latency[i] = NULL;
+    }
+}
+
+int sensor_latency_get_percentile(sensor_h sensor, sensor_type_e type, double percentile, unsigned int *latency_us)
+{
+    unsigned long long count[LATENCY_BUCKETS];
+    int i;
+
+    RETURN_IF_NOT_HANDLE(sensor);
+    RETURN_IF_NOT_TYPE(type);
+    if(percentile < 0 || percentile > 100 || latency_us == NULL || sensor->latency[type] == NULL)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    for(i=0; i<LATENCY_BUCKETS; i++)
+        count[i] = __atomic_load_n(&sensor->latency[type]->count[i], __ATOMIC_RELAXED);
+
+    *latency_us = _sensor_latency_percentile(count, percentile);
+    return SENSOR_ERROR_NONE;
+}
+
+int sensor_latency_set_budget_cb(sensor_h sensor, sensor_type_e type, unsigned int budget_us, int window_ms, sensor_latency_budget_cb callback, void *user_data)
+{
+    int err;
+    struct sensor_latency_s* latency;
+
+    DEBUG_PRINT("sensor_latency_set_budget_cb");
+
+    RETURN_IF_NOT_HANDLE(sensor);
+    RETURN_IF_NOT_TYPE(type);
+    if(type > SENSOR_PROXIMITY || window_ms <= 0 || callback == NULL)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    if( (err = _sensor_latency_create(sensor, type)) != SENSOR_ERROR_NONE)
+        return err;
+
+    latency = sensor->latency[type];
+    latency->budget_cb = NULL;
+    __sync_synchronize();
+    latency->budget_us = budget_us;
+    latency->window_ns = window_ms * 1000000ull;
+    latency->budget_user_data = user_data;
+    latency->window_reset = 1;
+    __sync_synchronize();
+    latency->budget_cb = callback;
+
+    return SENSOR_ERROR_NONE;
+}
+
+int sensor_latency_unset_budget_cb(sensor_h sensor, sensor_type_e type)
+{
+    DEBUG_PRINT("sensor_latency_unset_budget_cb");
+
+    RETURN_IF_NOT_HANDLE(sensor);
+    RETURN_IF_NOT_TYPE(type);
+
+    if(sensor->latency[type] != NULL)
+        sensor->latency[type]->budget_cb = NULL;
+
+    return SENSOR_ERROR_NONE;
+}
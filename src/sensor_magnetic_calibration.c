@@ -0,0 +1,366 @@
+/*
+ * Copyright (c) 2011 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <sensor_framework_private.h>
+#include <sensors.h>
+#include <sensor_private.h>
+
+/*
+ * The raw field m lies on an ellipsoid m'Mm + 2g'm = 1. Its 9 parameters
+ * (a, b, c, d, e, f of M and g) are tracked by recursive least squares on
+ * u = (x^2, y^2, z^2, 2xy, 2xz, 2yz, 2x, 2y, 2z), which costs a constant
+ * 9x9 update per sample. The hard-iron offset is the center of the
+ * ellipsoid and the soft-iron correction the square root of its shape,
+ * scaled to keep the mean field strength.
+ */
+#define PARAMS              9
+
+// fields are fitted in units of 50uT, so that every term of u is close to 1
+#define SCALE               50.0
+
+#define INITIAL_COVARIANCE  100.0
+#define FORGETTING          0.998
+
+// only samples this far from the previous one are fitted, a still device would wind the fit up
+#define MIN_DISTANCE        4.0f        // uT
+
+#define MIN_SAMPLES         30
+#define MIN_FIELD           15.0f       // uT
+#define MAX_FIELD           100.0f
+#define ERROR_WEIGHT        0.05f
+
+struct sensor_magnetic_calibration_s {
+    double theta[PARAMS];
+    double p[PARAMS][PARAMS];
+    int samples;
+    float last[3];
+
+    int valid;
+    float offset[3];
+    float matrix[3][3];
+    float field;
+    float error2;       // mean square relative error of |corrected| against field
+};
+
+static void _sensor_magnetic_calibration_init(struct sensor_magnetic_calibration_s* c)
+{
+    int i;
+
+    memset(c, 0, sizeof(*c));
+    for(i=0; i<PARAMS; i++)
+        c->p[i][i] = INITIAL_COVARIANCE;
+    c->theta[0] = c->theta[1] = c->theta[2] = 1;
+    c->matrix[0][0] = c->matrix[1][1] = c->matrix[2][2] = 1;
+    c->error2 = 1;
+}
+
+static void _sensor_magnetic_calibration_rls(struct sensor_magnetic_calibration_s* c, const float* m)
+{
+    int i, j;
+    double x = m[0] / SCALE, y = m[1] / SCALE, z = m[2] / SCALE;
+    double u[PARAMS] = { x*x, y*y, z*z, 2*x*y, 2*x*z, 2*y*z, 2*x, 2*y, 2*z };
+    double pu[PARAMS];
+    double denominator = FORGETTING, error = 1;
+
+    for(i=0; i<PARAMS; i++){
+        pu[i] = 0;
+        for(j=0; j<PARAMS; j++)
+            pu[i] += c->p[i][j] * u[j];
+        denominator += u[i] * pu[i];
+        error -= u[i] * c->theta[i];
+    }
+
+    for(i=0; i<PARAMS; i++)
+        c->theta[i] += pu[i] / denominator * error;
+
+    for(i=0; i<PARAMS; i++){
+        for(j=0; j<PARAMS; j++)
+            c->p[i][j] = (c->p[i][j] - pu[i] * pu[j] / denominator) / FORGETTING;
+    }
+}
+
+// eigen decomposition of a symmetric 3x3 matrix by Jacobi rotations, a = v diag(w) v'
+static void _sensor_magnetic_calibration_eigen(double a[3][3], double v[3][3], double w[3])
+{
+    int sweep, p, q, k;
+
+    memset(v, 0, 9 * sizeof(double));
+    v[0][0] = v[1][1] = v[2][2] = 1;
+
+    for(sweep=0; sweep<16; sweep++){
+        double off = a[0][1]*a[0][1] + a[0][2]*a[0][2] + a[1][2]*a[1][2];
+        if(off < 1e-24)
+            break;
+
+        for(p=0; p<2; p++){
+            for(q=p+1; q<3; q++){
+                double theta, t, cs, sn;
+
+                if(fabs(a[p][q]) < 1e-30)
+                    continue;
+
+                theta = (a[q][q] - a[p][p]) / (2 * a[p][q]);
+                t = (theta >= 0 ? 1 : -1) / (fabs(theta) + sqrt(theta*theta + 1));
+                cs = 1 / sqrt(t*t + 1);
+                sn = t * cs;
+
+                for(k=0; k<3; k++){
+                    double akp = a[k][p], akq = a[k][q];
+                    a[k][p] = cs * akp - sn * akq;
+                    a[k][q] = sn * akp + cs * akq;
+                }
+                for(k=0; k<3; k++){
+                    double apk = a[p][k], aqk = a[q][k];
+                    a[p][k] = cs * apk - sn * aqk;
+                    a[q][k] = sn * apk + cs * aqk;
+                }
+                for(k=0; k<3; k++){
+                    double vkp = v[k][p], vkq = v[k][q];
+                    v[k][p] = cs * vkp - sn * vkq;
+                    v[k][q] = sn * vkp + cs * vkq;
+                }
+            }
+        }
+    }
+
+    for(k=0; k<3; k++)
+        w[k] = a[k][k];
+}
+
+// offset and soft-iron matrix from the ellipsoid parameters, returns 0 if the fit is not an ellipsoid
+static int _sensor_magnetic_calibration_solve(struct sensor_magnetic_calibration_s* c)
+{
+    const double* t = c->theta;
+    double m[3][3] = {
+        { t[0], t[3], t[4] },
+        { t[3], t[1], t[5] },
+        { t[4], t[5], t[2] },
+    };
+    double inv[3][3], v[3][3], w[3];
+    double center[3], r, det, radius;
+    int i, j, k;
+
+    inv[0][0] = m[1][1]*m[2][2] - m[1][2]*m[2][1];
+    inv[0][1] = m[0][2]*m[2][1] - m[0][1]*m[2][2];
+    inv[0][2] = m[0][1]*m[1][2] - m[0][2]*m[1][1];
+    inv[1][0] = inv[0][1];
+    inv[1][1] = m[0][0]*m[2][2] - m[0][2]*m[2][0];
+    inv[1][2] = m[0][2]*m[1][0] - m[0][0]*m[1][2];
+    inv[2][0] = inv[0][2];
+    inv[2][1] = inv[1][2];
+    inv[2][2] = m[0][0]*m[1][1] - m[0][1]*m[1][0];
+    det = m[0][0]*inv[0][0] + m[0][1]*inv[1][0] + m[0][2]*inv[2][0];
+
+    if(fabs(det) < 1e-12)
+        return 0;
+
+    for(i=0; i<3; i++)
+        center[i] = -(inv[i][0]*t[6] + inv[i][1]*t[7] + inv[i][2]*t[8]) / det;
+
+    // M is negative definite when the offset is larger than the field, r then is negative too
+    r = 1;
+    for(i=0; i<3; i++){
+        for(j=0; j<3; j++)
+            r += center[i] * m[i][j] * center[j];
+    }
+    if(fabs(r) < 1e-12)
+        return 0;
+
+    for(i=0; i<3; i++){
+        for(j=0; j<3; j++)
+            m[i][j] /= r;
+    }
+
+    _sensor_magnetic_calibration_eigen(m, v, w);
+    if(w[0] <= 0 || w[1] <= 0 || w[2] <= 0)
+        return 0;
+
+    radius = pow(w[0] * w[1] * w[2], -1.0 / 6);
+    if(radius * SCALE < MIN_FIELD || radius * SCALE > MAX_FIELD)
+        return 0;
+
+    for(i=0; i<3; i++){
+        c->offset[i] = center[i] * SCALE;
+        for(j=0; j<3; j++){
+            double s = 0;
+            for(k=0; k<3; k++)
+                s += v[i][k] * sqrt(w[k]) * v[j][k];
+            c->matrix[i][j] = s * radius;
+        }
+    }
+    c->field = radius * SCALE;
+
+    return 1;
+}
+
+static void _sensor_magnetic_calibration_apply(struct sensor_magnetic_calibration_s* c, float* m)
+{
+    float d[3] = { m[0] - c->offset[0], m[1] - c->offset[1], m[2] - c->offset[2] };
+    int i;
+
+    for(i=0; i<3; i++)
+        m[i] = c->matrix[i][0] * d[0] + c->matrix[i][1] * d[1] + c->matrix[i][2] * d[2];
+}
+
+static int _sensor_magnetic_calibration_accuracy(struct sensor_magnetic_calibration_s* c)
+{
+    if(!c->valid)
+        return SENSOR_DATA_ACCURACY_BAD;
+    if(c->error2 < 0.02f * 0.02f)
+        return SENSOR_DATA_ACCURACY_VERYGOOD;
+    if(c->error2 < 0.05f * 0.05f)
+        return SENSOR_DATA_ACCURACY_GOOD;
+    if(c->error2 < 0.10f * 0.10f)
+        return SENSOR_DATA_ACCURACY_NORMAL;
+    return SENSOR_DATA_ACCURACY_BAD;
+}
+
+void _sensor_magnetic_calibration_feed(sensor_h handle, sensor_data_t* data, int data_num)
+{
+    int i, fitted = 0;
+    int accuracy;
+    struct sensor_magnetic_calibration_s* c = handle->magnetic_calibration;
+
+    for(i=0; i<data_num; i++){
+        float* m = data[i].values;
+        float dx = m[0] - c->last[0], dy = m[1] - c->last[1], dz = m[2] - c->last[2];
+
+        if(c->samples == 0 || dx*dx + dy*dy + dz*dz >= MIN_DISTANCE * MIN_DISTANCE){
+            if(c->valid){
+                float corrected[3] = { m[0], m[1], m[2] };
+                float e;
+
+                _sensor_magnetic_calibration_apply(c, corrected);
+                e = sqrtf(corrected[0]*corrected[0] + corrected[1]*corrected[1] + corrected[2]*corrected[2]) / c->field - 1;
+                c->error2 += (e * e - c->error2) * ERROR_WEIGHT;
+            }
+
+            _sensor_magnetic_calibration_rls(c, m);
+            memcpy(c->last, m, sizeof(c->last));
+            c->samples++;
+            fitted = 1;
+        }
+    }
+
+    if(fitted && c->samples >= MIN_SAMPLES){
+        if(_sensor_magnetic_calibration_solve(c)){
+            c->valid = 1;
+        }else{
+            c->valid = 0;
+            c->error2 = 1;
+        }
+    }
+
+    accuracy = _sensor_magnetic_calibration_accuracy(c);
+    for(i=0; i<data_num; i++){
+        if(c->valid)
+            _sensor_magnetic_calibration_apply(c, data[i].values);
+        data[i].data_accuracy = accuracy;
+    }
+}
+
+// a sample read outside of the stream, corrected by the current fit without feeding it
+void _sensor_magnetic_calibration_correct(sensor_h handle, sensor_data_t* data)
+{
+    struct sensor_magnetic_calibration_s* c = handle->magnetic_calibration;
+
+    if(c->valid)
+        _sensor_magnetic_calibration_apply(c, data->values);
+    data->data_accuracy = _sensor_magnetic_calibration_accuracy(c);
+}
+
+void _sensor_magnetic_calibration_save(sensor_h handle, struct sensor_state_magnetic_s* state)
+{
+    struct sensor_magnetic_calibration_s* c = handle->magnetic_calibration;
+
+    memcpy(state->theta, c->theta, sizeof(state->theta));
+    memcpy(state->p, c->p, sizeof(state->p));
+    state->samples = c->samples;
+    memcpy(state->last, c->last, sizeof(state->last));
+    state->error2 = c->error2;
+}
+
+// the fit goes on from the saved one, a valid fit calibrates from the first sample
+void _sensor_magnetic_calibration_load(sensor_h handle, const struct sensor_state_magnetic_s* state)
+{
+    struct sensor_magnetic_calibration_s* c = handle->magnetic_calibration;
+
+    _sensor_magnetic_calibration_init(c);
+    memcpy(c->theta, state->theta, sizeof(c->theta));
+    memcpy(c->p, state->p, sizeof(c->p));
+    c->samples = state->samples;
+    memcpy(c->last, state->last, sizeof(c->last));
+
+    if(c->samples >= MIN_SAMPLES && _sensor_magnetic_calibration_solve(c)){
+        c->valid = 1;
+        c->error2 = state->error2;
+    }
+}
+
+void _sensor_magnetic_calibration_release(sensor_h handle)
+{
+    free(handle->magnetic_calibration);
+    handle->magnetic_calibration = NULL;
+}
+
+int sensor_magnetic_auto_calibration_set(sensor_h sensor, bool enable)
+{
+    DEBUG_PRINT("sensor_magnetic_auto_calibration_set");
+
+    RETURN_IF_NOT_HANDLE(sensor);
+
+    if(!enable){
+        _sensor_release(sensor, _sensor_magnetic_calibration_release);
+        return SENSOR_ERROR_NONE;
+    }
+
+    if(sensor->magnetic_calibration != NULL)
+        return SENSOR_ERROR_NONE;
+
+    sensor->magnetic_calibration = (struct sensor_magnetic_calibration_s*)malloc(sizeof(struct sensor_magnetic_calibration_s));
+    if(sensor->magnetic_calibration == NULL)
+        RETURN_ERROR(SENSOR_ERROR_OUT_OF_MEMORY);
+
+    _sensor_magnetic_calibration_init(sensor->magnetic_calibration);
+    _sensor_state_restore(sensor, SENSOR_STATE_MAGNETIC);
+    return SENSOR_ERROR_NONE;
+}
+
+int sensor_magnetic_auto_calibration_get(sensor_h sensor, sensor_magnetic_calibration_s *calibration)
+{
+    struct sensor_magnetic_calibration_s* c;
+
+    RETURN_IF_NOT_HANDLE(sensor);
+
+    c = sensor->magnetic_calibration;
+    if(c == NULL || calibration == NULL)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    memcpy(calibration->offset, c->offset, sizeof(calibration->offset));
+    memcpy(calibration->matrix, c->matrix, sizeof(calibration->matrix));
+    calibration->field = c->valid ? c->field : 0;
+    calibration->error = c->valid ? sqrtf(c->error2) : 1;
+    calibration->accuracy = _sensor_magnetic_calibration_accuracy(c);
+
+    return SENSOR_ERROR_NONE;
+}
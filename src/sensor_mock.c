@@ -0,0 +1,554 @@
+/*
+ * Copyright (c) 2011 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include <sensor_framework_private.h>
+#include <sensors.h>
+#include <sensor_private.h>
+
+/*
+ * Serves the sf_* calls from tables of the process, in place of the sensor
+ * server. The sensors are the types added with sensor_mock_add(), samples
+ * are pushed with sensor_mock_emit() and reach the started registrations on
+ * the calling thread. A call can be made to fail with the code the sensor
+ * framework would return, and every call can be delayed like a round trip
+ * to the server.
+ */
+#define MOCK_CONNECTIONS        4096
+#define MOCK_REGISTRATIONS      4096
+#define MOCK_BATCH_MAX          128
+
+struct sensor_mock_sensor_s {
+    int used;
+    char vendor[64];
+    char model[64];
+    float min_range;
+    float max_range;
+    float resolution;
+    int min_interval_ms;
+};
+
+struct sensor_mock_connection_s {
+    int used;
+    int started;
+    sensor_type_t type;
+};
+
+struct sensor_mock_registration_s {
+    int used;
+    int handle;
+    unsigned int event_type;
+    int interval_ms;
+    sensor_callback_func_t cb;
+    void* cb_data;
+};
+
+struct sensor_mock_failure_s {
+    int code;
+    int count;              // negative fails every call
+};
+
+static struct {
+    pthread_mutex_t lock;
+
+    struct sensor_mock_sensor_s sensors[CB_NUMBERS];
+    struct sensor_mock_connection_s connections[MOCK_CONNECTIONS];
+    struct sensor_mock_registration_s registrations[MOCK_REGISTRATIONS];
+    int registrations_top;              // the scans stop past the last used registration
+    struct sensor_mock_failure_s failures[SENSOR_MOCK_CALL_READ+1];
+    unsigned int latency_us;
+
+    int has_last[CB_NUMBERS];
+    sensor_data_t last[CB_NUMBERS];
+} _mock = { .lock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP };
+
+static void _sensor_mock_delay(void)
+{
+    struct timespec t;
+
+    if(_mock.latency_us == 0)
+        return;
+
+    t.tv_sec = _mock.latency_us / 1000000;
+    t.tv_nsec = (_mock.latency_us % 1000000) * 1000;
+    while(nanosleep(&t, &t) != 0)
+        ;
+}
+
+// the delay of the call, then the injected failure if one is pending
+static int _sensor_mock_call(sensor_mock_call_e call)
+{
+    struct sensor_mock_failure_s* f = &_mock.failures[call];
+    int err = 0;
+
+    _sensor_mock_delay();
+
+    pthread_mutex_lock(&_mock.lock);
+    if(f->count != 0){
+        err = f->code;
+        if(f->count > 0)
+            f->count--;
+    }
+    pthread_mutex_unlock(&_mock.lock);
+
+    return err;
+}
+
+static bool _sensor_mock_connected(int handle)
+{
+    return handle >= 0 && handle < MOCK_CONNECTIONS && _mock.connections[handle].used;
+}
+
+static void _sensor_mock_trim(void)
+{
+    while(_mock.registrations_top > 0 && !_mock.registrations[_mock.registrations_top - 1].used)
+        _mock.registrations_top--;
+}
+
+static int _sensor_mock_connect(sensor_type_t sensor_type)
+{
+    int i, id = -1;
+    int err;
+
+    if( (err = _sensor_mock_call(SENSOR_MOCK_CALL_CONNECT)) < 0 )
+        return err;
+
+    pthread_mutex_lock(&_mock.lock);
+    for(i=0; i<MOCK_CONNECTIONS; i++){
+        if(!_mock.connections[i].used){
+            _mock.connections[i].used = 1;
+            _mock.connections[i].started = 0;
+            _mock.connections[i].type = sensor_type;
+            id = i;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&_mock.lock);
+
+    return id;
+}
+
+static int _sensor_mock_disconnect(int handle)
+{
+    int i;
+
+    pthread_mutex_lock(&_mock.lock);
+    if(!_sensor_mock_connected(handle)){
+        pthread_mutex_unlock(&_mock.lock);
+        return -1;
+    }
+    for(i=0; i<_mock.registrations_top; i++){
+        if(_mock.registrations[i].handle == handle)
+            _mock.registrations[i].used = 0;
+    }
+    _sensor_mock_trim();
+    _mock.connections[handle].used = 0;
+    _mock.connections[handle].started = 0;
+    pthread_mutex_unlock(&_mock.lock);
+
+    return 0;
+}
+
+static int _sensor_mock_set_started(int handle, sensor_mock_call_e call, int started)
+{
+    int err;
+
+    if( (err = _sensor_mock_call(call)) < 0 )
+        return err;
+
+    pthread_mutex_lock(&_mock.lock);
+    if(_sensor_mock_connected(handle))
+        _mock.connections[handle].started = started;
+    else
+        err = -1;
+    pthread_mutex_unlock(&_mock.lock);
+
+    return err;
+}
+
+static int _sensor_mock_start(int handle, int option)
+{
+    return _sensor_mock_set_started(handle, SENSOR_MOCK_CALL_START, 1);
+}
+
+static int _sensor_mock_stop(int handle)
+{
+    return _sensor_mock_set_started(handle, SENSOR_MOCK_CALL_STOP, 0);
+}
+
+static int _sensor_mock_register_event(int handle, unsigned int event_type, event_condition_t *event_condition, sensor_callback_func_t cb, void *cb_data)
+{
+    int i, err;
+    int min_interval = 0;
+
+    if( (err = _sensor_mock_call(SENSOR_MOCK_CALL_REGISTER)) < 0 )
+        return err;
+
+    pthread_mutex_lock(&_mock.lock);
+
+    if(!_sensor_mock_connected(handle)){
+        pthread_mutex_unlock(&_mock.lock);
+        return -1;
+    }
+
+    // the server runs a sensor no faster than it can
+    for(i=0; i<CB_NUMBERS; i++){
+        if(_mock.sensors[i].used && _TYPE[i] == _mock.connections[handle].type && (unsigned int)_EVENT[i] == event_type)
+            min_interval = _mock.sensors[i].min_interval_ms;
+    }
+
+    err = -1;
+    for(i=0; i<MOCK_REGISTRATIONS; i++){
+        struct sensor_mock_registration_s* r = &_mock.registrations[i];
+
+        if(!r->used){
+            r->used = 1;
+            r->handle = handle;
+            r->event_type = event_type;
+            r->interval_ms = event_condition != NULL ? (int)event_condition->cond_value1 : 0;
+            if(r->interval_ms < min_interval)
+                r->interval_ms = min_interval;
+            r->cb = cb;
+            r->cb_data = cb_data;
+            if(i >= _mock.registrations_top)
+                _mock.registrations_top = i + 1;
+            err = 0;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&_mock.lock);
+
+    return err;
+}
+
+static int _sensor_mock_unregister_event(int handle, unsigned int event_type)
+{
+    int i, err;
+
+    if( (err = _sensor_mock_call(SENSOR_MOCK_CALL_UNREGISTER)) < 0 )
+        return err;
+
+    err = -1;
+    pthread_mutex_lock(&_mock.lock);
+    for(i=0; i<_mock.registrations_top; i++){
+        struct sensor_mock_registration_s* r = &_mock.registrations[i];
+
+        if(r->used && r->handle == handle && r->event_type == event_type){
+            r->used = 0;
+            err = 0;
+        }
+    }
+    _sensor_mock_trim();
+    pthread_mutex_unlock(&_mock.lock);
+
+    return err;
+}
+
+static int _sensor_mock_get_data(int handle, unsigned int data_id, sensor_data_t* values)
+{
+    int i, err;
+
+    if( (err = _sensor_mock_call(SENSOR_MOCK_CALL_READ)) < 0 )
+        return err;
+
+    err = -1;
+    pthread_mutex_lock(&_mock.lock);
+    for(i=0; i<CB_NUMBERS; i++){
+        if((unsigned int)_DTYPE[i] == data_id && _mock.has_last[i]){
+            *values = _mock.last[i];
+            err = 0;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&_mock.lock);
+
+    return err;
+}
+
+static int _sensor_mock_get_properties(sensor_type_t sensor_type, sensor_properties_t *return_properties)
+{
+    int i, err = -1;
+
+    pthread_mutex_lock(&_mock.lock);
+    for(i=0; i<CB_NUMBERS; i++){
+        struct sensor_mock_sensor_s* s = &_mock.sensors[i];
+
+        if(s->used && _TYPE[i] == sensor_type){
+            memset(return_properties, 0, sizeof(*return_properties));
+            return_properties->sensor_min_range = s->min_range;
+            return_properties->sensor_max_range = s->max_range;
+            return_properties->sensor_resolution = s->resolution;
+            strncpy(return_properties->sensor_name, s->model, sizeof(return_properties->sensor_name) - 1);
+            strncpy(return_properties->sensor_vendor, s->vendor, sizeof(return_properties->sensor_vendor) - 1);
+            err = 0;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&_mock.lock);
+
+    return err;
+}
+
+static int _sensor_mock_get_data_properties(unsigned int data_id, sensor_data_properties_t *return_data_properties)
+{
+    int i, err = -1;
+
+    pthread_mutex_lock(&_mock.lock);
+    for(i=0; i<CB_NUMBERS; i++){
+        struct sensor_mock_sensor_s* s = &_mock.sensors[i];
+
+        if(s->used && (unsigned int)_DTYPE[i] == data_id){
+            memset(return_data_properties, 0, sizeof(*return_data_properties));
+            return_data_properties->sensor_min_range = s->min_range;
+            return_data_properties->sensor_max_range = s->max_range;
+            return_data_properties->sensor_resolution = s->resolution;
+            err = 0;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&_mock.lock);
+
+    return err;
+}
+
+static int _sensor_mock_is_sensor_event_available(sensor_type_t sensor_type, unsigned int event_type)
+{
+    int i, err = -1;
+
+    pthread_mutex_lock(&_mock.lock);
+    for(i=0; i<CB_NUMBERS; i++){
+        if(!_mock.sensors[i].used || _TYPE[i] != sensor_type)
+            continue;
+        if((unsigned int)_EVENT[i] == event_type || (i < CALIB_CB_NUMBERS && (unsigned int)_CALIBRATION[i] == event_type)){
+            err = 0;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&_mock.lock);
+
+    return err;
+}
+
+const struct sensor_backend_s _sensor_mock_backend = {
+    _sensor_mock_connect,
+    _sensor_mock_disconnect,
+    _sensor_mock_start,
+    _sensor_mock_stop,
+    _sensor_mock_register_event,
+    _sensor_mock_unregister_event,
+    _sensor_mock_get_data,
+    _sensor_mock_get_properties,
+    _sensor_mock_get_data_properties,
+    _sensor_mock_is_sensor_event_available,
+};
+
+int sensor_mock_add(sensor_type_e type, const sensor_mock_spec_s *spec)
+{
+    struct sensor_mock_sensor_s* s;
+
+    DEBUG_PRINT("sensor_mock_add");
+
+    RETURN_IF_NOT_TYPE(type);
+    RETURN_IF_VIRTUAL_TYPE(type);
+    if(spec == NULL || spec->min_interval_ms < 0)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    pthread_mutex_lock(&_mock.lock);
+
+    s = &_mock.sensors[type];
+    memset(s, 0, sizeof(*s));
+    s->used = 1;
+    strncpy(s->vendor, spec->vendor != NULL ? spec->vendor : "mock", sizeof(s->vendor) - 1);
+    strncpy(s->model, spec->model != NULL ? spec->model : "mock", sizeof(s->model) - 1);
+    s->min_range = spec->min_range;
+    s->max_range = spec->max_range;
+    s->resolution = spec->resolution;
+    s->min_interval_ms = spec->min_interval_ms;
+
+    pthread_mutex_unlock(&_mock.lock);
+
+    return SENSOR_ERROR_NONE;
+}
+
+int sensor_mock_fail(sensor_mock_call_e call, int code, int count)
+{
+    DEBUG_PRINT("sensor_mock_fail");
+
+    if(call < SENSOR_MOCK_CALL_CONNECT || call > SENSOR_MOCK_CALL_READ || (count != 0 && code >= 0))
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    pthread_mutex_lock(&_mock.lock);
+    _mock.failures[call].code = code;
+    _mock.failures[call].count = count;
+    pthread_mutex_unlock(&_mock.lock);
+
+    return SENSOR_ERROR_NONE;
+}
+
+int sensor_mock_set_latency(unsigned int latency_us)
+{
+    DEBUG_PRINT("sensor_mock_set_latency");
+
+    _mock.latency_us = latency_us;
+    return SENSOR_ERROR_NONE;
+}
+
+int sensor_mock_get_interval(sensor_type_e type, int *interval_ms)
+{
+    int i;
+
+    DEBUG_PRINT("sensor_mock_get_interval");
+
+    RETURN_IF_NOT_TYPE(type);
+    if(interval_ms == NULL)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    *interval_ms = 0;
+
+    // the fastest started registration sets the rate of the sensor
+    pthread_mutex_lock(&_mock.lock);
+    for(i=0; i<_mock.registrations_top; i++){
+        struct sensor_mock_registration_s* r = &_mock.registrations[i];
+
+        if(!r->used || r->event_type != (unsigned int)_EVENT[type] || !_mock.connections[r->handle].started
+                || _mock.connections[r->handle].type != _TYPE[type])
+            continue;
+        if(*interval_ms == 0 || (r->interval_ms > 0 && r->interval_ms < *interval_ms))
+            *interval_ms = r->interval_ms;
+    }
+    pthread_mutex_unlock(&_mock.lock);
+
+    return SENSOR_ERROR_NONE;
+}
+
+// the samples of a data type are copied for every callback, the library corrects them in place
+static int _sensor_mock_deliver(sensor_type_e type, void* event_data, int event_data_size)
+{
+    int i;
+    bool samples = type <= SENSOR_PROXIMITY;
+    sensor_data_t copy[MOCK_BATCH_MAX];
+    sensor_event_data_t event;
+
+    _sensor_mock_delay();
+
+    pthread_mutex_lock(&_mock.lock);
+
+    if(!_mock.sensors[type].used){
+        pthread_mutex_unlock(&_mock.lock);
+        RETURN_ERROR(SENSOR_ERROR_NOT_SUPPORTED);
+    }
+
+    if(samples){
+        _mock.last[type] = ((sensor_data_t*)event_data)[event_data_size / sizeof(sensor_data_t) - 1];
+        _mock.has_last[type] = 1;
+    }
+
+    for(i=0; i<_mock.registrations_top; i++){
+        struct sensor_mock_registration_s* r = &_mock.registrations[i];
+
+        if(!r->used || r->event_type != (unsigned int)_EVENT[type] || !_mock.connections[r->handle].started
+                || _mock.connections[r->handle].type != _TYPE[type])
+            continue;
+
+        event.event_type = r->event_type;
+        event.event_data = samples ? memcpy(copy, event_data, event_data_size) : event_data;
+        event.event_data_size = event_data_size;
+
+        r->cb(r->event_type, &event, r->cb_data);
+    }
+
+    pthread_mutex_unlock(&_mock.lock);
+
+    return SENSOR_ERROR_NONE;
+}
+
+int sensor_mock_emit(sensor_type_e type, unsigned long long timestamp, sensor_data_accuracy_e accuracy, const float values[], int values_num)
+{
+    int motion;
+    sensor_panning_data_t panning;
+    sensor_data_t data;
+
+    RETURN_IF_NOT_TYPE(type);
+    RETURN_IF_VIRTUAL_TYPE(type);
+    if(values_num < 0 || values_num > 12 || (values_num > 0 && values == NULL))
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    if(type == SENSOR_MOTION_PANNING){
+        panning.x = values_num > 0 ? (int)values[0] : 0;
+        panning.y = values_num > 1 ? (int)values[1] : 0;
+        return _sensor_mock_deliver(type, &panning, sizeof(panning));
+    }
+
+    if(type > SENSOR_PROXIMITY){
+        motion = values_num > 0 ? (int)values[0] : 0;
+        return _sensor_mock_deliver(type, &motion, sizeof(motion));
+    }
+
+    memset(&data, 0, sizeof(data));
+    data.data_accuracy = accuracy;
+    data.time_stamp = timestamp;
+    data.values_num = values_num;
+    if(values_num > 0)
+        memcpy(data.values, values, values_num * sizeof(float));
+
+    return _sensor_mock_deliver(type, &data, sizeof(data));
+}
+
+int sensor_mock_emit_batch(sensor_type_e type, const sensor_mock_sample_s *samples, int count)
+{
+    int i;
+    sensor_data_t data[MOCK_BATCH_MAX];
+
+    RETURN_IF_NOT_TYPE(type);
+    if(type > SENSOR_PROXIMITY || samples == NULL || count <= 0 || count > MOCK_BATCH_MAX)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    for(i=0; i<count; i++){
+        if(samples[i].values_num < 0 || samples[i].values_num > 12)
+            RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+        memset(&data[i], 0, sizeof(data[i]));
+        data[i].data_accuracy = samples[i].accuracy;
+        data[i].time_stamp = samples[i].timestamp;
+        data[i].values_num = samples[i].values_num;
+        memcpy(data[i].values, samples[i].values, samples[i].values_num * sizeof(float));
+    }
+
+    return _sensor_mock_deliver(type, data, count * sizeof(sensor_data_t));
+}
+
+int sensor_mock_reset(void)
+{
+    DEBUG_PRINT("sensor_mock_reset");
+
+    pthread_mutex_lock(&_mock.lock);
+    memset(_mock.sensors, 0, sizeof(_mock.sensors));
+    memset(_mock.failures, 0, sizeof(_mock.failures));
+    memset(_mock.has_last, 0, sizeof(_mock.has_last));
+    _mock.latency_us = 0;
+    pthread_mutex_unlock(&_mock.lock);
+
+    return SENSOR_ERROR_NONE;
+}
@@ -0,0 +1,295 @@
+/*
+ * Copyright (c) 2011 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include <sensor_framework_private.h>
+#include <sensors.h>
+#include <sensor_private.h>
+
+/*
+ * Gestures of devices without a motion engine, detected on the
+ * accelerometer stream. Gravity is tracked with a low-pass filter, what is
+ * left is the linear acceleration of the hand:
+ *
+ *  - a swing is a strong linear acceleration on one axis followed by the
+ *    opposite one within SWING_US, it is the building block of snap and shake
+ *  - a snap is a single swing with no other swing around it
+ *  - a shake is SHAKE_SWINGS swings spaced by less than SHAKE_GAP_US
+ *  - a tap is a jump between two consecutive samples while the device is
+ *    otherwise still, a double tap is two taps within DOUBLETAP_US
+ *  - face down is the screen turning from up to down within FACEDOWN_US
+ */
+
+// double taps are a few samples long, 100Hz is the slowest rate that sees them
+#define FALLBACK_INTERVAL_MS    10
+
+#define GRAVITY                 9.80665f
+#define GRAVITY_RC              0.25f
+
+#define SWING_THRESHOLD         10.0f       // m/s^2
+#define SWING_US                300000ull
+
+#define SNAP_QUIET_US           400000ull
+
+#define SHAKE_SWINGS            3
+#define SHAKE_GAP_US            500000ull
+
+#define TAP_THRESHOLD           3.0f        // m/s^2 between two samples
+#define TAP_STILL_THRESHOLD     2.0f        // m/s^2 of linear acceleration before the tap
+#define TAP_DEADTIME_US         80000ull
+#define DOUBLETAP_MIN_US        120000ull
+#define DOUBLETAP_US            500000ull
+
+#define FACE_THRESHOLD          (GRAVITY * 0.8f)
+#define FACEDOWN_US             2000000ull
+#define FACEDOWN_HOLD_US        300000ull
+
+// a gap longer than this restarts the filters
+#define MAX_DELTA_US            1000000ull
+
+struct sensor_motion_fallback_s {
+    int listening[CB_NUMBERS];
+
+    unsigned long long last_time_stamp;
+    float gravity[3];
+    float prev[3];
+
+    int axis_sign[3];
+    unsigned long long axis_time[3];
+
+    int swings;
+    unsigned long long last_swing;
+    int shaking;
+
+    int snap;
+    unsigned long long snap_time;
+
+    unsigned long long last_tap;
+    unsigned long long tap_deadtime;
+    unsigned long long moving_until;
+
+    unsigned long long face_up;
+    unsigned long long face_down;
+    int face_down_sent;
+};
+
+static const int _snap_directions[3][2] = {
+    { SENSOR_MOTION_SNAP_X_NEGATIVE, SENSOR_MOTION_SNAP_X_POSITIVE },
+    { SENSOR_MOTION_SNAP_Y_NEGATIVE, SENSOR_MOTION_SNAP_Y_POSITIVE },
+    { SENSOR_MOTION_SNAP_Z_NEGATIVE, SENSOR_MOTION_SNAP_Z_POSITIVE },
+};
+
+static bool _sensor_motion_fallback_active(sensor_h handle, sensor_type_e type)
+{
+    return handle->fallback[type] && handle->started[type] && handle->cb_func[type] != NULL;
+}
+
+static unsigned long long _sensor_motion_fallback_now(void)
+{
+    struct timeval sv;
+
+    // same clock as the events of the motion engine
+    gettimeofday(&sv, NULL);
+    return MICROSECONDS(sv);
+}
+
+static void _sensor_motion_fallback_shake(sensor_h handle, sensor_motion_shake_e shake)
+{
+    if(_sensor_motion_fallback_active(handle, SENSOR_MOTION_SHAKE)){
+        ((sensor_motion_shake_event_cb)handle->cb_func[SENSOR_MOTION_SHAKE])
+            (_sensor_motion_fallback_now(), shake, handle->cb_user_data[SENSOR_MOTION_SHAKE]);
+    }
+}
+
+static void _sensor_motion_fallback_swing(sensor_h handle, struct sensor_motion_fallback_s* m, int axis, int sign, unsigned long long ts)
+{
+    if(m->swings > 0 && ts - m->last_swing < SHAKE_GAP_US)
+        m->swings++;
+    else
+        m->swings = 1;
+    m->last_swing = ts;
+
+    if(m->swings == 1){
+        m->snap = _snap_directions[axis][sign > 0];
+        m->snap_time = ts;
+    }else{
+        m->snap = SENSOR_MOTION_SNAP_NONE;
+    }
+
+    if(m->swings == SHAKE_SWINGS){
+        m->shaking = 1;
+        _sensor_motion_fallback_shake(handle, SENSOR_MOTION_SHAKE_DETECTED);
+    }else if(m->shaking){
+        _sensor_motion_fallback_shake(handle, SENSOR_MOTION_SHAKE_CONTINUING);
+    }
+}
+
+static void _sensor_motion_fallback_sample(sensor_h handle, struct sensor_motion_fallback_s* m, const float* a, unsigned long long ts)
+{
+    int k;
+    float dt, alpha;
+    float linear[3];
+    float jump = 0, still = 0;
+
+    if(m->last_time_stamp == 0 || ts <= m->last_time_stamp || ts - m->last_time_stamp > MAX_DELTA_US){
+        memset(&m->last_time_stamp, 0, sizeof(*m) - offsetof(struct sensor_motion_fallback_s, last_time_stamp));
+        m->last_time_stamp = ts;
+        memcpy(m->gravity, a, sizeof(m->gravity));
+        memcpy(m->prev, a, sizeof(m->prev));
+        return;
+    }
+
+    dt = (ts - m->last_time_stamp) / 1000000.0f;
+    m->last_time_stamp = ts;
+    alpha = dt / (GRAVITY_RC + dt);
+
+    for(k=0; k<3; k++){
+        float d = a[k] - m->prev[k];
+
+        m->gravity[k] += (a[k] - m->gravity[k]) * alpha;
+        linear[k] = a[k] - m->gravity[k];
+        jump += d * d;
+        m->prev[k] = a[k];
+    }
+
+    // swings, snap and shake
+    for(k=0; k<3; k++){
+        int sign;
+
+        if(linear[k] > SWING_THRESHOLD)
+            sign = 1;
+        else if(linear[k] < -SWING_THRESHOLD)
+            sign = -1;
+        else
+            continue;
+
+        if(m->axis_sign[k] == -sign && ts - m->axis_time[k] < SWING_US)
+            _sensor_motion_fallback_swing(handle, m, k, m->axis_sign[k], ts);
+
+        m->axis_sign[k] = sign;
+        m->axis_time[k] = ts;
+    }
+
+    if(m->snap != SENSOR_MOTION_SNAP_NONE && ts - m->snap_time > SNAP_QUIET_US){
+        if(_sensor_motion_fallback_active(handle, SENSOR_MOTION_SNAP)){
+            ((sensor_motion_snap_event_cb)handle->cb_func[SENSOR_MOTION_SNAP])
+                (_sensor_motion_fallback_now(), m->snap, handle->cb_user_data[SENSOR_MOTION_SNAP]);
+        }
+        m->snap = SENSOR_MOTION_SNAP_NONE;
+    }
+
+    if(m->swings > 0 && ts - m->last_swing > SHAKE_GAP_US){
+        if(m->shaking)
+            _sensor_motion_fallback_shake(handle, SENSOR_MOTION_SHAKE_FINISHED);
+        m->shaking = 0;
+        m->swings = 0;
+    }
+
+    // taps, only while the hand is not moving the device
+    for(k=0; k<3; k++)
+        still += linear[k] * linear[k];
+    if(still > TAP_STILL_THRESHOLD * TAP_STILL_THRESHOLD && jump <= TAP_THRESHOLD * TAP_THRESHOLD)
+        m->moving_until = ts + SHAKE_GAP_US;
+
+    if(jump > TAP_THRESHOLD * TAP_THRESHOLD && ts >= m->tap_deadtime && ts >= m->moving_until && m->swings == 0){
+        m->tap_deadtime = ts + TAP_DEADTIME_US;
+
+        if(m->last_tap != 0 && ts - m->last_tap >= DOUBLETAP_MIN_US && ts - m->last_tap <= DOUBLETAP_US){
+            m->last_tap = 0;
+            if(_sensor_motion_fallback_active(handle, SENSOR_MOTION_DOUBLETAP)){
+                ((sensor_motion_doubletap_event_cb)handle->cb_func[SENSOR_MOTION_DOUBLETAP])
+                    (_sensor_motion_fallback_now(), handle->cb_user_data[SENSOR_MOTION_DOUBLETAP]);
+            }
+        }else{
+            m->last_tap = ts;
+        }
+    }
+
+    // face down
+    if(m->gravity[2] > FACE_THRESHOLD){
+        m->face_up = ts;
+        m->face_down = 0;
+        m->face_down_sent = 0;
+    }else if(m->gravity[2] < -FACE_THRESHOLD){
+        if(m->face_down == 0)
+            m->face_down = ts;
+
+        if(!m->face_down_sent && m->face_up != 0 && m->face_down - m->face_up < FACEDOWN_US && ts - m->face_down >= FACEDOWN_HOLD_US){
+            m->face_down_sent = 1;
+            if(_sensor_motion_fallback_active(handle, SENSOR_MOTION_FACEDOWN)){
+                ((sensor_motion_facedown_event_cb)handle->cb_func[SENSOR_MOTION_FACEDOWN])
+                    (_sensor_motion_fallback_now(), handle->cb_user_data[SENSOR_MOTION_FACEDOWN]);
+            }
+        }
+    }else{
+        m->face_down = 0;
+    }
+}
+
+void _sensor_motion_fallback_feed(sensor_h handle, sensor_data_t* data, int data_num)
+{
+    int i;
+
+    if(!_sensor_motion_fallback_active(handle, SENSOR_MOTION_SNAP) && !_sensor_motion_fallback_active(handle, SENSOR_MOTION_SHAKE)
+            && !_sensor_motion_fallback_active(handle, SENSOR_MOTION_DOUBLETAP) && !_sensor_motion_fallback_active(handle, SENSOR_MOTION_FACEDOWN))
+        return;
+
+    for(i=0; i<data_num; i++)
+        _sensor_motion_fallback_sample(handle, handle->motion_fallback, data[i].values, data[i].time_stamp);
+}
+
+void _sensor_motion_fallback_release(sensor_h handle)
+{
+    free(handle->motion_fallback);
+    handle->motion_fallback = NULL;
+}
+
+// the type stays routed to the accelerometer connection for the life of the handle, so that start and stop keep working after unset
+int _sensor_motion_fallback_enable(sensor_h handle, sensor_type_e type)
+{
+    int err;
+
+    if(handle->motion_fallback == NULL){
+        handle->motion_fallback = (struct sensor_motion_fallback_s*)calloc(1, sizeof(struct sensor_motion_fallback_s));
+        if(handle->motion_fallback == NULL)
+            RETURN_ERROR(SENSOR_ERROR_OUT_OF_MEMORY);
+    }
+
+    if(!handle->motion_fallback->listening[type]){
+        if( (err = _sensor_listen(handle, SENSOR_ACCELEROMETER, FALLBACK_INTERVAL_MS)) != SENSOR_ERROR_NONE )
+            return err;
+        handle->motion_fallback->listening[type] = 1;
+    }
+
+    handle->fallback[type] = 1;
+    return SENSOR_ERROR_NONE;
+}
+
+int _sensor_motion_fallback_disable(sensor_h handle, sensor_type_e type)
+{
+    if(handle->motion_fallback == NULL || !handle->motion_fallback->listening[type])
+        return SENSOR_ERROR_NONE;
+
+    handle->motion_fallback->listening[type] = 0;
+    return _sensor_unlisten(handle, SENSOR_ACCELEROMETER, FALLBACK_INTERVAL_MS);
+}
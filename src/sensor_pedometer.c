@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) 2011 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+
+#include <stdlib.h>
+#include <math.h>
+
+#include <sensor_framework_private.h>
+#include <sensors.h>
+#include <sensor_private.h>
+
+// 50Hz is enough for walking and running cadences
+#define PEDOMETER_INTERVAL_MS   20
+
+// band-pass of the acceleration magnitude: 0.5Hz high-pass, 3Hz low-pass
+#define LOW_PASS_RC             (1.0f / (2 * M_PI * 3.0f))
+#define HIGH_PASS_RC            (1.0f / (2 * M_PI * 0.5f))
+
+#define MIN_THRESHOLD           0.6f    // m/s^2
+#define THRESHOLD_RATIO         0.5f    // of the running peak amplitude
+#define PEAK_DECAY              0.2f
+
+#define MIN_STEP_US             250000ull
+#define MAX_STEP_US             2000000ull
+
+// steps are only reported after this many regular steps in a row
+#define WALKING_STEPS           4
+
+struct sensor_pedometer_s {
+    unsigned long long last_time_stamp;
+    float low;
+    float base;
+    float prev;
+    int rising;
+    int armed;
+
+    float amplitude;
+    unsigned long long last_step;
+    int pending;
+    int walking;
+};
+
+static void _sensor_pedometer_reset(struct sensor_pedometer_s* p)
+{
+    p->last_time_stamp = 0;
+    p->low = 0;
+    p->base = 0;
+    p->prev = 0;
+    p->rising = 0;
+    p->armed = 1;
+    p->amplitude = MIN_THRESHOLD / THRESHOLD_RATIO;
+    p->last_step = 0;
+    p->pending = 0;
+    p->walking = 0;
+}
+
+// returns the number of steps to report for this peak
+static int _sensor_pedometer_step(struct sensor_pedometer_s* p, unsigned long long ts)
+{
+    int steps = 0;
+
+    if(p->last_step != 0 && ts - p->last_step < MIN_STEP_US)
+        return 0;
+
+    if(p->last_step == 0 || ts - p->last_step > MAX_STEP_US){
+        p->walking = 0;
+        p->pending = 0;
+    }
+    p->last_step = ts;
+
+    if(p->walking)
+        return 1;
+
+    if(++p->pending >= WALKING_STEPS){
+        p->walking = 1;
+        steps = p->pending;
+        p->pending = 0;
+    }
+    return steps;
+}
+
+void _sensor_pedometer_feed(sensor_h handle, sensor_data_t* data, int data_num)
+{
+    int i;
+    int steps = 0;
+    unsigned long long ts = 0;
+    struct sensor_pedometer_s* p = handle->pedometer;
+
+    for(i=0; i<data_num; i++){
+        float x = data[i].values[0];
+        float y = data[i].values[1];
+        float z = data[i].values[2];
+        float magnitude = sqrtf(x*x + y*y + z*z);
+        float dt, signal, threshold;
+
+        ts = data[i].time_stamp;
+        if(p->last_time_stamp == 0 || ts <= p->last_time_stamp || ts - p->last_time_stamp > MAX_STEP_US){
+            p->last_time_stamp = ts;
+            p->low = magnitude;
+            p->base = magnitude;
+            p->prev = 0;
+            continue;
+        }
+
+        dt = (ts - p->last_time_stamp) / 1000000.0f;
+        p->last_time_stamp = ts;
+
+        p->low += (magnitude - p->low) * dt / (LOW_PASS_RC + dt);
+        p->base += (p->low - p->base) * dt / (HIGH_PASS_RC + dt);
+        signal = p->low - p->base;
+
+        threshold = p->amplitude * THRESHOLD_RATIO;
+        if(threshold < MIN_THRESHOLD)
+            threshold = MIN_THRESHOLD;
+
+        // every local maximum adapts the amplitude, a peak counts as a step once
+        // it is above the threshold, the detector re-arms when the signal falls back below zero
+        if(signal < p->prev && p->rising && p->prev > MIN_THRESHOLD){
+            p->amplitude += (p->prev - p->amplitude) * PEAK_DECAY;
+            if(p->armed && p->prev > threshold){
+                p->armed = 0;
+                steps += _sensor_pedometer_step(p, ts);
+            }
+        }
+        if(signal < 0)
+            p->armed = 1;
+
+        p->rising = signal > p->prev;
+        p->prev = signal;
+    }
+
+    if(steps > 0){
+        ((sensor_pedometer_event_cb)handle->cb_func[SENSOR_PEDOMETER])
+            (ts, steps, handle->cb_user_data[SENSOR_PEDOMETER]);
+    }
+}
+
+void _sensor_pedometer_release(sensor_h handle)
+{
+    free(handle->pedometer);
+    handle->pedometer = NULL;
+}
+
+int sensor_pedometer_set_cb(sensor_h handle, sensor_pedometer_event_cb callback, void *user_data)
+{
+    int err;
+    struct sensor_pedometer_s* p;
+
+    DEBUG_PRINT("sensor_pedometer_set_cb");
+
+    RETURN_IF_NOT_HANDLE(handle);
+    if(callback == NULL)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    p = handle->pedometer;
+    if(p == NULL){
+        p = (struct sensor_pedometer_s*)malloc(sizeof(struct sensor_pedometer_s));
+        if(p == NULL)
+            RETURN_ERROR(SENSOR_ERROR_OUT_OF_MEMORY);
+
+        _sensor_pedometer_reset(p);
+
+        if( (err = _sensor_listen(handle, SENSOR_ACCELEROMETER, PEDOMETER_INTERVAL_MS)) != SENSOR_ERROR_NONE ){
+            free(p);
+            return err;
+        }
+    }
+
+    // stored with the state, the dispatch of the accelerometer feeds under the handle lock
+    pthread_mutex_lock(&handle->lock);
+    handle->pedometer = p;
+    handle->cb_user_data[SENSOR_PEDOMETER] = user_data;
+    handle->cb_func[SENSOR_PEDOMETER] = callback;
+    pthread_mutex_unlock(&handle->lock);
+
+    return SENSOR_ERROR_NONE;
+}
+
+int sensor_pedometer_unset_cb(sensor_h handle)
+{
+    DEBUG_PRINT("sensor_pedometer_unset_cb");
+
+    RETURN_IF_NOT_HANDLE(handle);
+
+    if(handle->pedometer == NULL)
+        return SENSOR_ERROR_NONE;
+
+    _sensor_release(handle, _sensor_pedometer_release);
+    handle->cb_func[SENSOR_PEDOMETER] = NULL;
+    handle->cb_user_data[SENSOR_PEDOMETER] = NULL;
+
+    return _sensor_unlisten(handle, SENSOR_ACCELEROMETER, PEDOMETER_INTERVAL_MS);
+}
@@ -0,0 +1,430 @@
+/*
+ * Copyright (c) 2011 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <sensor_framework_private.h>
+#include <sensors.h>
+#include <sensor_private.h>
+
+/*
+ * The file is allocated to its full size on start and mapped shared, a
+ * sample is then a copy into the mapping. It is cut into chunks of
+ * RECORD_CHUNK_SIZE bytes, the first one holds the header, every other one
+ * the records of a single stream. A stream takes the next free chunk when
+ * its current one is full. The record count of a chunk is published after
+ * the record, a reader of a live recording never sees a partial one.
+ *
+ * A compressed record holds deltas to the previous record of its chunk,
+ * every chunk starts from zero so that it decodes without the others.
+ */
+#define RECORD_ENCODED_MAX      24      // varint of 10, accuracy, width and 3 values of 32 bits
+#define RECORD_DEFAULT_RESOLUTION   0.0001f
+#define RECORD_QUANTUM_MAX      (1 << 29)    // a delta still fits in an int
+
+struct sensor_record_stream_s {
+    struct sensor_record_chunk_s* chunk;
+    unsigned int used;          // bytes of the chunk in use
+    unsigned long long time_stamp;
+    int accuracy;
+    int q[3];
+};
+
+struct sensor_record_s {
+    int fd;
+    char* map;
+    unsigned int capacity;      // chunks after the header
+    struct sensor_record_file_s* file;
+    struct sensor_record_stream_s streams[CB_NUMBERS];
+};
+
+static unsigned char* _sensor_record_put_varint(unsigned char* p, unsigned long long v)
+{
+    while(v >= 0x80){
+        *p++ = (unsigned char)(v | 0x80);
+        v >>= 7;
+    }
+    *p++ = (unsigned char)v;
+    return p;
+}
+
+static int _sensor_record_quantize(float value, float resolution)
+{
+    float q = value / resolution;
+
+    if(!(q > -RECORD_QUANTUM_MAX))     // NaN too
+        return -RECORD_QUANTUM_MAX;
+    if(q > RECORD_QUANTUM_MAX)
+        return RECORD_QUANTUM_MAX;
+    return (int)lrintf(q);
+}
+
+static unsigned char* _sensor_record_encode(struct sensor_record_stream_s* s, float resolution, unsigned char* p, sensor_data_t* data)
+{
+    int i;
+    unsigned int z[3], all = 0;
+    int width = 0, bits = 0;
+    unsigned long long acc = 0;
+    long long dt = (long long)(data->time_stamp - s->time_stamp);
+    bool accuracy = s->used == sizeof(struct sensor_record_chunk_s) || data->data_accuracy != s->accuracy;
+
+    // zigzag, a time stamp going back costs a few bytes instead of ten
+    p = _sensor_record_put_varint(p, (((unsigned long long)dt << 1) ^ (unsigned long long)(dt >> 63)) << 1 | accuracy);
+    if(accuracy)
+        *p++ = (unsigned char)(data->data_accuracy + 1);
+
+    for(i=0; i<3; i++){
+        int q = _sensor_record_quantize(data->values[i], resolution);
+        int d = q - s->q[i];
+
+        z[i] = ((unsigned int)d << 1) ^ (unsigned int)(d >> 31);
+        all |= z[i];
+        s->q[i] = q;
+    }
+    while(width < 32 && (all >> width) != 0)
+        width++;
+    *p++ = (unsigned char)width;
+
+    // at most 7 bits are pending before a value is added, 39 fit in the accumulator
+    for(i=0; i<3; i++){
+        acc |= (unsigned long long)z[i] << bits;
+        bits += width;
+        while(bits >= 8){
+            *p++ = (unsigned char)acc;
+            acc >>= 8;
+            bits -= 8;
+        }
+    }
+    if(bits > 0)
+        *p++ = (unsigned char)acc;
+
+    s->time_stamp = data->time_stamp;
+    s->accuracy = data->data_accuracy;
+    return p;
+}
+
+void _sensor_record_feed(struct sensor_record_s* r, sensor_type_e type, sensor_data_t* data, int data_num)
+{
+    int i;
+    struct sensor_record_stream_s* s = &r->streams[type];
+    unsigned int record_max = r->file->encoding == RECORD_ENCODING_DELTA ? RECORD_ENCODED_MAX : sizeof(struct sensor_record_sample_s);
+
+    if(!(r->file->types & (1u << type)))
+        return;
+
+    for(i=0; i<data_num; i++){
+        unsigned char* p;
+
+        if(s->chunk == NULL || s->used + record_max > RECORD_CHUNK_SIZE){
+            if(r->file->chunks == r->capacity){
+                r->file->dropped += data_num - i;
+                break;
+            }
+            memset(s, 0, sizeof(*s));
+            s->chunk = (struct sensor_record_chunk_s*)(r->map + ++r->file->chunks * RECORD_CHUNK_SIZE);
+            s->chunk->type = type;
+            s->chunk->count = 0;
+            s->used = sizeof(struct sensor_record_chunk_s);
+        }
+
+        p = (unsigned char*)s->chunk + s->used;
+        if(r->file->encoding == RECORD_ENCODING_DELTA){
+            s->used = _sensor_record_encode(s, r->file->resolution[type], p, &data[i]) - (unsigned char*)s->chunk;
+        }else{
+            struct sensor_record_sample_s* sample = (struct sensor_record_sample_s*)p;
+
+            sample->time_stamp = data[i].time_stamp;
+            sample->accuracy = data[i].data_accuracy;
+            memcpy(sample->values, data[i].values, sizeof(sample->values));
+            s->used += sizeof(struct sensor_record_sample_s);
+        }
+
+        __sync_synchronize();
+        s->chunk->count++;
+    }
+}
+
+void _sensor_record_cursor_init(struct sensor_record_cursor_s* c, const struct sensor_record_file_s* file, const struct sensor_record_chunk_s* chunk)
+{
+    memset(c, 0, sizeof(*c));
+    c->p = (const unsigned char*)(chunk + 1);
+    c->end = (const unsigned char*)chunk + RECORD_CHUNK_SIZE;
+    c->left = chunk->count;
+    c->encoding = file->encoding;
+    c->resolution = chunk->type < CB_NUMBERS ? file->resolution[chunk->type] : 0;
+}
+
+static int _sensor_record_get_varint(struct sensor_record_cursor_s* c, unsigned long long* v)
+{
+    int shift;
+
+    *v = 0;
+    for(shift=0; shift<64 && c->p < c->end; shift+=7){
+        unsigned char b = *c->p++;
+
+        *v |= (unsigned long long)(b & 0x7f) << shift;
+        if(!(b & 0x80))
+            return 0;
+    }
+    return -1;
+}
+
+// -1 at the end of the chunk, or on a record running past it
+int _sensor_record_cursor_next(struct sensor_record_cursor_s* c, struct sensor_record_sample_s* sample)
+{
+    int i, width, bits = 0;
+    unsigned long long v, acc = 0;
+
+    if(c->left == 0)
+        return -1;
+
+    if(c->encoding != RECORD_ENCODING_DELTA){
+        if(c->p + sizeof(*sample) > c->end)
+            goto corrupt;
+        memcpy(sample, c->p, sizeof(*sample));
+        c->p += sizeof(*sample);
+        c->left--;
+        return 0;
+    }
+
+    if(_sensor_record_get_varint(c, &v) < 0)
+        goto corrupt;
+    c->time_stamp += (v >> 2) ^ -((v >> 1) & 1);
+    if(v & 1){
+        if(c->p >= c->end)
+            goto corrupt;
+        c->accuracy = (int)*c->p++ - 1;
+    }
+
+    if(c->p >= c->end || (width = *c->p++) > 32 || c->p + (3 * width + 7) / 8 > c->end)
+        goto corrupt;
+
+    for(i=0; i<3; i++){
+        unsigned int z;
+
+        while(bits < width){
+            acc |= (unsigned long long)*c->p++ << bits;
+            bits += 8;
+        }
+        z = (unsigned int)(acc & ((1ull << width) - 1));
+        acc >>= width;
+        bits -= width;
+
+        c->q[i] += (int)(z >> 1) ^ -(int)(z & 1);
+        sample->values[i] = c->q[i] * c->resolution;
+    }
+
+    sample->time_stamp = c->time_stamp;
+    sample->accuracy = c->accuracy;
+    c->left--;
+    return 0;
+
+corrupt:
+    c->left = 0;
+    return -1;
+}
+
+void _sensor_record_release(sensor_h handle)
+{
+    struct sensor_record_s* r = handle->record;
+    size_t size;
+
+    if(r == NULL)
+        return;
+
+    r->file->closed = 1;
+    size = (r->file->chunks + 1) * (size_t)RECORD_CHUNK_SIZE;
+
+    msync(r->map, size, MS_SYNC);
+    munmap(r->map, (r->capacity + 1) * (size_t)RECORD_CHUNK_SIZE);
+    if(ftruncate(r->fd, size) < 0)
+        DEBUG_PRINT("sensor_record_stop cannot truncate the file");
+    close(r->fd);
+
+    free(r);
+    handle->record = NULL;
+}
+
+int sensor_record_start(sensor_h sensor, const char *path, const sensor_type_e *types, int type_count, unsigned int max_size_kb)
+{
+    int i;
+    unsigned int mask = 0;
+    size_t size;
+    struct sensor_record_s* r;
+
+    DEBUG_PRINT("sensor_record_start");
+
+    RETURN_IF_NOT_HANDLE(sensor);
+    if(path == NULL || types == NULL || type_count <= 0)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    for(i=0; i<type_count; i++){
+        RETURN_IF_NOT_TYPE(types[i]);
+        mask |= 1u << types[i];
+    }
+
+    // the header and one chunk at least
+    size = (size_t)max_size_kb * 1024 / RECORD_CHUNK_SIZE * RECORD_CHUNK_SIZE;
+    if(size < 2 * RECORD_CHUNK_SIZE)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    _sensor_release(sensor, _sensor_record_release);
+
+    r = (struct sensor_record_s*)calloc(1, sizeof(struct sensor_record_s));
+    if(r == NULL)
+        RETURN_ERROR(SENSOR_ERROR_OUT_OF_MEMORY);
+
+    r->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if(r->fd < 0){
+        free(r);
+        RETURN_ERROR(SENSOR_ERROR_IO_ERROR);
+    }
+
+    // blocks are reserved now, a full disk would otherwise fault in the callback
+    if(posix_fallocate(r->fd, 0, size) != 0
+            || (r->map = (char*)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, r->fd, 0)) == MAP_FAILED){
+        close(r->fd);
+        unlink(path);
+        free(r);
+        RETURN_ERROR(SENSOR_ERROR_IO_ERROR);
+    }
+
+    r->capacity = size / RECORD_CHUNK_SIZE - 1;
+    r->file = (struct sensor_record_file_s*)r->map;
+    r->file->magic = RECORD_MAGIC;
+    r->file->version = RECORD_VERSION;
+    r->file->header_size = sizeof(struct sensor_record_file_s);
+    r->file->chunk_size = RECORD_CHUNK_SIZE;
+    r->file->types = mask;
+    r->file->encoding = sensor->record_format == SENSOR_RECORD_FORMAT_COMPRESSED ? RECORD_ENCODING_DELTA : RECORD_ENCODING_RAW;
+
+    if(r->file->encoding == RECORD_ENCODING_DELTA){
+        for(i=0; i<CB_NUMBERS; i++){
+            sensor_data_properties_t properties;
+
+            if(!(mask & (1u << i)))
+                continue;
+            if(_sensor_backend()->get_data_properties(_DTYPE[i], &properties) == 0 && properties.sensor_resolution > 0)
+                r->file->resolution[i] = properties.sensor_resolution;
+            else
+                r->file->resolution[i] = RECORD_DEFAULT_RESOLUTION;
+        }
+    }else{
+        r->file->record_size = sizeof(struct sensor_record_sample_s);
+    }
+
+    sensor->record = r;
+    return SENSOR_ERROR_NONE;
+}
+
+int sensor_record_stop(sensor_h sensor)
+{
+    DEBUG_PRINT("sensor_record_stop");
+
+    RETURN_IF_NOT_HANDLE(sensor);
+
+    _sensor_release(sensor, _sensor_record_release);
+    return SENSOR_ERROR_NONE;
+}
+
+int sensor_record_set_format(sensor_h sensor, sensor_record_format_e format)
+{
+    DEBUG_PRINT("sensor_record_set_format");
+
+    RETURN_IF_NOT_HANDLE(sensor);
+    if(format != SENSOR_RECORD_FORMAT_RAW && format != SENSOR_RECORD_FORMAT_COMPRESSED)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    sensor->record_format = format;
+    return SENSOR_ERROR_NONE;
+}
+
+// maps a recording read only, after checking its header
+int _sensor_record_map(const char* path, char** map, size_t* size)
+{
+    int fd;
+    struct stat st;
+    const struct sensor_record_file_s* f;
+
+    fd = open(path, O_RDONLY);
+    if(fd < 0)
+        RETURN_ERROR(SENSOR_ERROR_IO_ERROR);
+
+    if(fstat(fd, &st) < 0 || st.st_size < RECORD_CHUNK_SIZE){
+        close(fd);
+        RETURN_ERROR(SENSOR_ERROR_IO_ERROR);
+    }
+
+    *map = (char*)mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(*map == MAP_FAILED)
+        RETURN_ERROR(SENSOR_ERROR_IO_ERROR);
+
+    f = (const struct sensor_record_file_s*)*map;
+    if(f->magic != RECORD_MAGIC || f->version != RECORD_VERSION || f->chunk_size != RECORD_CHUNK_SIZE
+            || (f->encoding == RECORD_ENCODING_RAW ? f->record_size != sizeof(struct sensor_record_sample_s) : f->encoding != RECORD_ENCODING_DELTA)
+            || (f->chunks + 1) * (size_t)RECORD_CHUNK_SIZE > (size_t)st.st_size){
+        munmap(*map, st.st_size);
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+    }
+
+    *size = st.st_size;
+    return SENSOR_ERROR_NONE;
+}
+
+int sensor_record_foreach_sample(const char *path, sensor_record_sample_cb callback, void *user_data)
+{
+    int err;
+    unsigned int c;
+    char* map;
+    size_t size;
+    const struct sensor_record_file_s* f;
+    bool more = true;
+
+    DEBUG_PRINT("sensor_record_foreach_sample");
+
+    if(path == NULL || callback == NULL)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    if( (err = _sensor_record_map(path, &map, &size)) != SENSOR_ERROR_NONE )
+        return err;
+
+    f = (const struct sensor_record_file_s*)map;
+    for(c=1; c<=f->chunks && more; c++){
+        const struct sensor_record_chunk_s* chunk = (const struct sensor_record_chunk_s*)(map + c * RECORD_CHUNK_SIZE);
+        struct sensor_record_cursor_s cursor;
+        struct sensor_record_sample_s sample;
+
+        if(chunk->type >= CB_NUMBERS)
+            continue;
+
+        _sensor_record_cursor_init(&cursor, f, chunk);
+        while(more && _sensor_record_cursor_next(&cursor, &sample) == 0)
+            more = callback(chunk->type, sample.time_stamp, sample.accuracy, sample.values, user_data);
+    }
+
+    munmap(map, size);
+    return SENSOR_ERROR_NONE;
+}
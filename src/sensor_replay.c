@@ -0,0 +1,469 @@
+/*
+ * Copyright (c) 2011 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#include <sensor_framework_private.h>
+#include <sensors.h>
+#include <sensor_private.h>
+
+/*
+ * Serves the sf_* calls from a file of sensor_record_start(). Once a
+ * connection is started, a thread merges the streams of the file by the
+ * time since the first sample of each stream, the streams may be stamped on
+ * different clocks, and calls the registered callbacks, like the sensor
+ * framework does from its own thread. The interval asked at registration is not applied,
+ * the streams are replayed at their recorded rate.
+ */
+#define REPLAY_CONNECTIONS      64
+#define REPLAY_REGISTRATIONS    128
+
+struct sensor_replay_stream_s {
+    const struct sensor_record_chunk_s** chunks;
+    int chunk_count;
+    int chunk;
+    struct sensor_record_cursor_s cursor;
+    int pending;
+    struct sensor_record_sample_s sample;   // the next one, when pending
+    int has_first;
+    unsigned long long first;
+};
+
+struct sensor_replay_connection_s {
+    int used;
+    int started;
+    sensor_type_t type;
+};
+
+struct sensor_replay_registration_s {
+    int used;
+    int handle;
+    unsigned int event_type;
+    sensor_callback_func_t cb;
+    void* cb_data;
+};
+
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t finished_cond;
+
+    char* map;
+    size_t size;
+    const struct sensor_record_file_s* file;
+    float speed;
+
+    struct sensor_replay_stream_s streams[CB_NUMBERS];
+    const struct sensor_record_chunk_s** chunk_list;
+
+    struct sensor_replay_connection_s connections[REPLAY_CONNECTIONS];
+    struct sensor_replay_registration_s registrations[REPLAY_REGISTRATIONS];
+    int has_last[CB_NUMBERS];
+    sensor_data_t last[CB_NUMBERS];
+
+    pthread_t thread;
+    int running;
+    volatile int stopping;
+    int finished;
+} _replay = { .lock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP, .finished_cond = PTHREAD_COND_INITIALIZER };
+
+static bool _sensor_replay_recorded(sensor_type_e type)
+{
+    return _replay.file != NULL && (_replay.file->types & (1u << type));
+}
+
+// microseconds from the first sample of the stream, a time stamp going backwards is not waited for
+static unsigned long long _sensor_replay_offset(const struct sensor_replay_stream_s* s)
+{
+    long long offset = (long long)(s->sample.time_stamp - s->first);
+
+    return offset > 0 ? offset : 0;
+}
+
+// the stream with the oldest pending sample, -1 at the end of the file
+static int _sensor_replay_next(void)
+{
+    int i, next = -1;
+    unsigned long long oldest = 0;
+
+    for(i=0; i<CB_NUMBERS; i++){
+        struct sensor_replay_stream_s* s = &_replay.streams[i];
+
+        while(!s->pending){
+            if(_sensor_record_cursor_next(&s->cursor, &s->sample) == 0)
+                s->pending = 1;
+            else if(s->chunk < s->chunk_count)
+                _sensor_record_cursor_init(&s->cursor, _replay.file, s->chunks[s->chunk++]);
+            else
+                break;
+        }
+        if(!s->pending)
+            continue;
+
+        if(!s->has_first){
+            s->first = s->sample.time_stamp;
+            s->has_first = 1;
+        }
+
+        if(next < 0 || _sensor_replay_offset(s) < oldest){
+            next = i;
+            oldest = _sensor_replay_offset(s);
+        }
+    }
+    return next;
+}
+
+static void _sensor_replay_dispatch(sensor_type_e type, const struct sensor_record_sample_s* sample)
+{
+    int i;
+    sensor_data_t data;
+    sensor_event_data_t event;
+
+    memset(&data, 0, sizeof(data));
+    data.data_accuracy = sample->accuracy;
+    data.time_stamp = sample->time_stamp;
+    data.values_num = 3;
+    memcpy(data.values, sample->values, sizeof(sample->values));
+
+    pthread_mutex_lock(&_replay.lock);
+
+    _replay.last[type] = data;
+    _replay.has_last[type] = 1;
+
+    for(i=0; i<REPLAY_REGISTRATIONS; i++){
+        struct sensor_replay_registration_s* r = &_replay.registrations[i];
+
+        if(!r->used || r->event_type != (unsigned int)_EVENT[type] || !_replay.connections[r->handle].started)
+            continue;
+
+        // every callback gets its own copy, the library corrects samples in place
+        data = _replay.last[type];
+        event.event_type = r->event_type;
+        event.event_data = &data;
+        event.event_data_size = sizeof(data);
+
+        r->cb(r->event_type, &event, r->cb_data);
+    }
+
+    pthread_mutex_unlock(&_replay.lock);
+}
+
+static void* _sensor_replay_thread(void* arg)
+{
+    int type;
+    struct timespec start, at;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    while(!_replay.stopping && (type = _sensor_replay_next()) >= 0){
+        struct sensor_replay_stream_s* s = &_replay.streams[type];
+        const struct sensor_record_sample_s* sample = &s->sample;
+
+        if(_replay.speed > 0){
+            unsigned long long offset_ns = (unsigned long long)(_sensor_replay_offset(s) * 1000.0 / _replay.speed);
+
+            at.tv_sec = start.tv_sec + (start.tv_nsec + offset_ns) / 1000000000ull;
+            at.tv_nsec = (start.tv_nsec + offset_ns) % 1000000000ull;
+            while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &at, NULL) != 0 && !_replay.stopping)
+                ;
+        }
+
+        _sensor_replay_dispatch(type, sample);
+        s->pending = 0;
+    }
+
+    pthread_mutex_lock(&_replay.lock);
+    _replay.finished = 1;
+    pthread_cond_broadcast(&_replay.finished_cond);
+    pthread_mutex_unlock(&_replay.lock);
+
+    return NULL;
+}
+
+int _sensor_replay_open(const char* path, float speed)
+{
+    int i, err;
+    unsigned int c;
+    char* map;
+    size_t size;
+    const struct sensor_record_file_s* f;
+    const struct sensor_record_chunk_s** list;
+
+    if( (err = _sensor_record_map(path, &map, &size)) != SENSOR_ERROR_NONE )
+        return err;
+
+    f = (const struct sensor_record_file_s*)map;
+    list = (const struct sensor_record_chunk_s**)calloc(f->chunks + 1, sizeof(*list));
+    if(list == NULL){
+        munmap(map, size);
+        RETURN_ERROR(SENSOR_ERROR_OUT_OF_MEMORY);
+    }
+
+    pthread_mutex_lock(&_replay.lock);
+
+    memset(_replay.streams, 0, sizeof(_replay.streams));
+    memset(_replay.connections, 0, sizeof(_replay.connections));
+    memset(_replay.registrations, 0, sizeof(_replay.registrations));
+    memset(_replay.has_last, 0, sizeof(_replay.has_last));
+
+    // the chunks of every stream, in file order
+    for(i=0; i<CB_NUMBERS; i++){
+        _replay.streams[i].chunks = list;
+        for(c=1; c<=f->chunks; c++){
+            const struct sensor_record_chunk_s* chunk = (const struct sensor_record_chunk_s*)(map + c * RECORD_CHUNK_SIZE);
+            if(chunk->type == (unsigned int)i)
+                *list++ = chunk;
+        }
+        _replay.streams[i].chunk_count = list - _replay.streams[i].chunks;
+    }
+
+    _replay.map = map;
+    _replay.size = size;
+    _replay.file = f;
+    _replay.chunk_list = _replay.streams[0].chunks;
+    _replay.speed = speed;
+    _replay.running = 0;
+    _replay.stopping = 0;
+    _replay.finished = 0;
+
+    pthread_mutex_unlock(&_replay.lock);
+
+    return SENSOR_ERROR_NONE;
+}
+
+void _sensor_replay_close(void)
+{
+    if(_replay.file == NULL)
+        return;
+
+    if(_replay.running){
+        _replay.stopping = 1;
+        pthread_join(_replay.thread, NULL);
+    }
+
+    pthread_mutex_lock(&_replay.lock);
+    munmap(_replay.map, _replay.size);
+    free(_replay.chunk_list);
+    _replay.map = NULL;
+    _replay.file = NULL;
+    _replay.chunk_list = NULL;
+    _replay.running = 0;
+    pthread_mutex_unlock(&_replay.lock);
+}
+
+static int _sensor_replay_connect(sensor_type_t sensor_type)
+{
+    int i, id = -1;
+
+    pthread_mutex_lock(&_replay.lock);
+    for(i=0; i<REPLAY_CONNECTIONS; i++){
+        if(!_replay.connections[i].used){
+            _replay.connections[i].used = 1;
+            _replay.connections[i].started = 0;
+            _replay.connections[i].type = sensor_type;
+            id = i;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&_replay.lock);
+
+    return id;
+}
+
+static int _sensor_replay_disconnect(int handle)
+{
+    int i;
+
+    if(handle < 0 || handle >= REPLAY_CONNECTIONS)
+        return -1;
+
+    pthread_mutex_lock(&_replay.lock);
+    for(i=0; i<REPLAY_REGISTRATIONS; i++){
+        if(_replay.registrations[i].handle == handle)
+            _replay.registrations[i].used = 0;
+    }
+    _replay.connections[handle].used = 0;
+    _replay.connections[handle].started = 0;
+    pthread_mutex_unlock(&_replay.lock);
+
+    return 0;
+}
+
+static int _sensor_replay_start(int handle, int option)
+{
+    int err = 0;
+
+    if(handle < 0 || handle >= REPLAY_CONNECTIONS)
+        return -1;
+
+    pthread_mutex_lock(&_replay.lock);
+    _replay.connections[handle].started = 1;
+    if(!_replay.running && _replay.file != NULL){
+        if(pthread_create(&_replay.thread, NULL, _sensor_replay_thread, NULL) == 0)
+            _replay.running = 1;
+        else
+            err = -1;
+    }
+    pthread_mutex_unlock(&_replay.lock);
+
+    return err;
+}
+
+static int _sensor_replay_stop(int handle)
+{
+    if(handle < 0 || handle >= REPLAY_CONNECTIONS)
+        return -1;
+
+    pthread_mutex_lock(&_replay.lock);
+    _replay.connections[handle].started = 0;
+    pthread_mutex_unlock(&_replay.lock);
+
+    return 0;
+}
+
+static int _sensor_replay_register_event(int handle, unsigned int event_type, event_condition_t *event_condition, sensor_callback_func_t cb, void *cb_data)
+{
+    int i, err = -1;
+
+    pthread_mutex_lock(&_replay.lock);
+    for(i=0; i<REPLAY_REGISTRATIONS; i++){
+        struct sensor_replay_registration_s* r = &_replay.registrations[i];
+
+        if(!r->used){
+            r->used = 1;
+            r->handle = handle;
+            r->event_type = event_type;
+            r->cb = cb;
+            r->cb_data = cb_data;
+            err = 0;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&_replay.lock);
+
+    return err;
+}
+
+static int _sensor_replay_unregister_event(int handle, unsigned int event_type)
+{
+    int i, err = -1;
+
+    pthread_mutex_lock(&_replay.lock);
+    for(i=0; i<REPLAY_REGISTRATIONS; i++){
+        struct sensor_replay_registration_s* r = &_replay.registrations[i];
+
+        if(r->used && r->handle == handle && r->event_type == event_type){
+            r->used = 0;
+            err = 0;
+        }
+    }
+    pthread_mutex_unlock(&_replay.lock);
+
+    return err;
+}
+
+static int _sensor_replay_get_data(int handle, unsigned int data_id, sensor_data_t* values)
+{
+    int i, err = -1;
+
+    pthread_mutex_lock(&_replay.lock);
+    for(i=0; i<CB_NUMBERS; i++){
+        if((unsigned int)_DTYPE[i] == data_id && _replay.has_last[i]){
+            *values = _replay.last[i];
+            err = 0;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&_replay.lock);
+
+    return err;
+}
+
+static int _sensor_replay_get_properties(sensor_type_t sensor_type, sensor_properties_t *return_properties)
+{
+    int i;
+
+    for(i=0; i<CB_NUMBERS; i++){
+        if(_TYPE[i] == sensor_type && _sensor_replay_recorded(i)){
+            memset(return_properties, 0, sizeof(*return_properties));
+            strncpy(return_properties->sensor_name, "replay", sizeof(return_properties->sensor_name) - 1);
+            strncpy(return_properties->sensor_vendor, "replay", sizeof(return_properties->sensor_vendor) - 1);
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static int _sensor_replay_get_data_properties(unsigned int data_id, sensor_data_properties_t *return_data_properties)
+{
+    int i;
+
+    for(i=0; i<CB_NUMBERS; i++){
+        if((unsigned int)_DTYPE[i] == data_id && _sensor_replay_recorded(i)){
+            memset(return_data_properties, 0, sizeof(*return_data_properties));
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static int _sensor_replay_is_sensor_event_available(sensor_type_t sensor_type, unsigned int event_type)
+{
+    int i;
+
+    for(i=0; i<CB_NUMBERS; i++){
+        if(_TYPE[i] == sensor_type && (unsigned int)_EVENT[i] == event_type && _sensor_replay_recorded(i))
+            return 0;
+    }
+    return -1;
+}
+
+const struct sensor_backend_s _sensor_replay_backend = {
+    _sensor_replay_connect,
+    _sensor_replay_disconnect,
+    _sensor_replay_start,
+    _sensor_replay_stop,
+    _sensor_replay_register_event,
+    _sensor_replay_unregister_event,
+    _sensor_replay_get_data,
+    _sensor_replay_get_properties,
+    _sensor_replay_get_data_properties,
+    _sensor_replay_is_sensor_event_available,
+};
+
+int sensor_replay_wait(void)
+{
+    DEBUG_PRINT("sensor_replay_wait");
+
+    pthread_mutex_lock(&_replay.lock);
+    if(_replay.file == NULL || !_replay.running){
+        pthread_mutex_unlock(&_replay.lock);
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+    }
+    while(!_replay.finished)
+        pthread_cond_wait(&_replay.finished_cond, &_replay.lock);
+    pthread_mutex_unlock(&_replay.lock);
+
+    return SENSOR_ERROR_NONE;
+}
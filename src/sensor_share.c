@@ -0,0 +1,395 @@
+/*
+ * Copyright (c) 2011 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#include <sensor_framework_private.h>
+#include <sensors.h>
+#include <sensor_private.h>
+
+/*
+ * A ring of samples in a shared memory object, one publisher and any
+ * number of readers. The publisher never waits on a reader: a slot carries
+ * the position it holds, written after the sample, and a reader that finds
+ * another position has been lapped and counts the sample as lost. The
+ * position counters are 32 bits and compared by difference, so they wrap.
+ * Readers wait with a futex on a word bumped by every publication and by
+ * the close, the publisher only wakes them when one of them waits. The
+ * publisher holds a lock on the object while it shares, the object of a
+ * publisher that died is taken over.
+ */
+#define SHARE_MAGIC         0x48534e53      // "SNSH"
+#define SHARE_VERSION       1
+#define SHARE_MODE          0660
+
+struct sensor_share_slot_s {
+    volatile unsigned int position;     // position of the sample + 1, once written
+    unsigned int type;
+    unsigned long long time_stamp;
+    int accuracy;
+    float values[3];
+};
+
+struct sensor_share_ring_s {
+    unsigned int magic;
+    unsigned int version;
+    unsigned int size;
+    unsigned int slots;             // a power of 2
+    unsigned int types;             // mask of the published sensor_type_e
+    volatile unsigned int closed;
+    volatile unsigned int head;     // samples published
+    volatile unsigned int futex;
+    volatile int waiters;
+    struct sensor_share_slot_s slot[];
+};
+
+struct sensor_share_s {
+    char* name;
+    int fd;                         // locked while the name is held
+    size_t size;
+    unsigned int slots;             // the readers map the ring writable too
+    struct sensor_share_ring_s* ring;
+};
+
+struct sensor_share_reader_s {
+    size_t size;
+    const struct sensor_share_ring_s* ring;
+    unsigned int slots;             // as checked at the open, the writer can change the ring
+    unsigned int mask;
+    volatile int* waiters;
+    unsigned int next;
+    unsigned long long lost;
+};
+
+void _sensor_share_feed(struct sensor_share_s* share, sensor_type_e type, sensor_data_t* data, int data_num)
+{
+    struct sensor_share_ring_s* ring = share->ring;
+    unsigned int position = ring->head;
+    int i;
+
+    if(!(ring->types & (1u << type)))
+        return;
+
+    for(i=0; i<data_num; i++, position++){
+        struct sensor_share_slot_s* slot = &ring->slot[position & (share->slots - 1)];
+
+        slot->position = position;
+        __sync_synchronize();
+        slot->type = type;
+        slot->time_stamp = data[i].time_stamp;
+        slot->accuracy = data[i].data_accuracy;
+        memcpy(slot->values, data[i].values, sizeof(slot->values));
+        __sync_synchronize();
+        slot->position = position + 1;
+    }
+
+    __sync_synchronize();
+    ring->head = position;
+    ring->futex++;
+    __sync_synchronize();
+
+    if(ring->waiters > 0)
+        syscall(SYS_futex, &ring->futex, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+void _sensor_share_release(sensor_h handle)
+{
+    struct sensor_share_s* share = handle->share;
+
+    if(share == NULL)
+        return;
+
+    // the readers drain what is left, then see the end
+    share->ring->closed = 1;
+    share->ring->futex++;
+    __sync_synchronize();
+    syscall(SYS_futex, &share->ring->futex, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+
+    munmap(share->ring, share->size);
+    shm_unlink(share->name);
+    close(share->fd);
+    free(share->name);
+    free(share);
+    handle->share = NULL;
+}
+
+// unlinks the object of a publisher that died without stopping, 0 when the name is free
+static int _sensor_share_take_over(const char* name)
+{
+    int fd, current;
+    struct stat st, now;
+    struct sensor_share_ring_s* ring;
+
+    fd = shm_open(name, O_RDWR, 0);
+    if(fd < 0)
+        return errno == ENOENT ? 0 : -1;
+
+    // a live publisher holds the lock, an object still empty is being created
+    if(flock(fd, LOCK_EX | LOCK_NB) < 0 || fstat(fd, &st) < 0 || st.st_size == 0){
+        close(fd);
+        return -1;
+    }
+
+    // taken over by another process meanwhile
+    current = shm_open(name, O_RDONLY, 0);
+    if(current < 0 || fstat(current, &now) < 0 || now.st_ino != st.st_ino){
+        if(current >= 0)
+            close(current);
+        close(fd);
+        return -1;
+    }
+    close(current);
+
+    // the readers left on it see the end
+    if(st.st_size >= (off_t)sizeof(struct sensor_share_ring_s)
+            && (ring = (struct sensor_share_ring_s*)mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)) != MAP_FAILED){
+        if(ring->magic == SHARE_MAGIC){
+            ring->closed = 1;
+            ring->futex++;
+            __sync_synchronize();
+            syscall(SYS_futex, &ring->futex, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+        }
+        munmap(ring, st.st_size);
+    }
+
+    shm_unlink(name);
+    close(fd);
+    return 0;
+}
+
+int sensor_share_start(sensor_h sensor, const char *name, const sensor_type_e *types, int type_count, unsigned int slots)
+{
+    int i, fd;
+    unsigned int mask = 0;
+    struct sensor_share_s* share;
+    struct sensor_share_ring_s* ring;
+
+    DEBUG_PRINT("sensor_share_start");
+
+    RETURN_IF_NOT_HANDLE(sensor);
+    if(name == NULL || name[0] != '/' || types == NULL || type_count <= 0 || slots < 2 || (slots & (slots - 1)) != 0)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    for(i=0; i<type_count; i++){
+        RETURN_IF_NOT_TYPE(types[i]);
+        mask |= 1u << types[i];
+    }
+
+    _sensor_release(sensor, _sensor_share_release);
+
+    share = (struct sensor_share_s*)calloc(1, sizeof(struct sensor_share_s));
+    if(share == NULL || (share->name = strdup(name)) == NULL){
+        free(share);
+        RETURN_ERROR(SENSOR_ERROR_OUT_OF_MEMORY);
+    }
+    share->size = sizeof(struct sensor_share_ring_s) + slots * sizeof(struct sensor_share_slot_s);
+
+    // the name of a live publisher is not taken over, only its release unlinks it
+    fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, SHARE_MODE);
+    if(fd < 0 && errno == EEXIST && _sensor_share_take_over(name) == 0)
+        fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, SHARE_MODE);
+    if(fd < 0){
+        free(share->name);
+        free(share);
+        RETURN_ERROR(SENSOR_ERROR_IO_ERROR);
+    }
+
+    if(flock(fd, LOCK_EX) < 0 || ftruncate(fd, share->size) < 0
+            || (share->ring = (struct sensor_share_ring_s*)mmap(NULL, share->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)) == MAP_FAILED){
+        shm_unlink(name);
+        close(fd);
+        free(share->name);
+        free(share);
+        RETURN_ERROR(SENSOR_ERROR_IO_ERROR);
+    }
+    share->fd = fd;
+    share->slots = slots;
+
+    ring = share->ring;
+    ring->version = SHARE_VERSION;
+    ring->size = share->size;
+    ring->slots = slots;
+    ring->types = mask;
+    __sync_synchronize();
+    ring->magic = SHARE_MAGIC;
+
+    sensor->share = share;
+    return SENSOR_ERROR_NONE;
+}
+
+int sensor_share_stop(sensor_h sensor)
+{
+    DEBUG_PRINT("sensor_share_stop");
+
+    RETURN_IF_NOT_HANDLE(sensor);
+
+    _sensor_release(sensor, _sensor_share_release);
+    return SENSOR_ERROR_NONE;
+}
+
+int sensor_share_reader_open(const char *name, sensor_share_reader_h *reader)
+{
+    int fd;
+    struct stat st;
+    void* map;
+    const struct sensor_share_ring_s* ring;
+    struct sensor_share_reader_s* r;
+
+    DEBUG_PRINT("sensor_share_reader_open");
+
+    if(name == NULL || reader == NULL)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    // read write, a waiting reader is counted in the ring
+    fd = shm_open(name, O_RDWR, 0);
+    if(fd < 0)
+        RETURN_ERROR(SENSOR_ERROR_IO_ERROR);
+
+    if(fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(struct sensor_share_ring_s)){
+        close(fd);
+        RETURN_ERROR(SENSOR_ERROR_IO_ERROR);
+    }
+
+    map = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if(map == MAP_FAILED)
+        RETURN_ERROR(SENSOR_ERROR_IO_ERROR);
+
+    ring = (const struct sensor_share_ring_s*)map;
+    if(ring->magic != SHARE_MAGIC || ring->version != SHARE_VERSION || ring->size != (size_t)st.st_size
+            || ring->slots == 0 || (ring->slots & (ring->slots - 1)) != 0
+            || sizeof(struct sensor_share_ring_s) + ring->slots * sizeof(struct sensor_share_slot_s) != (size_t)st.st_size){
+        munmap(map, st.st_size);
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+    }
+
+    r = (struct sensor_share_reader_s*)calloc(1, sizeof(struct sensor_share_reader_s));
+    if(r == NULL){
+        munmap(map, st.st_size);
+        RETURN_ERROR(SENSOR_ERROR_OUT_OF_MEMORY);
+    }
+
+    r->size = st.st_size;
+    r->ring = ring;
+    r->slots = (st.st_size - sizeof(struct sensor_share_ring_s)) / sizeof(struct sensor_share_slot_s);
+    r->mask = r->slots - 1;
+    r->waiters = &((struct sensor_share_ring_s*)map)->waiters;
+    // only the samples published from now on
+    r->next = ring->head;
+
+    *reader = r;
+    return SENSOR_ERROR_NONE;
+}
+
+static void _sensor_share_wait(sensor_share_reader_h r, int timeout_ms)
+{
+    struct timespec t;
+    unsigned int futex;
+
+    t.tv_sec = timeout_ms / 1000;
+    t.tv_nsec = (timeout_ms % 1000) * 1000000L;
+
+    __sync_fetch_and_add(r->waiters, 1);
+    futex = r->ring->futex;
+    __sync_synchronize();
+    if(r->ring->head == r->next && !r->ring->closed)
+        syscall(SYS_futex, &r->ring->futex, FUTEX_WAIT, futex, timeout_ms < 0 ? NULL : &t, NULL, 0);
+    __sync_fetch_and_sub(r->waiters, 1);
+}
+
+int sensor_share_reader_read(sensor_share_reader_h reader, sensor_share_sample_s *samples, int max, int timeout_ms, int *count)
+{
+    const struct sensor_share_ring_s* ring;
+    unsigned int head;
+    int n = 0;
+
+    if(reader == NULL || samples == NULL || max <= 0 || count == NULL)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    ring = reader->ring;
+    head = ring->head;
+    if(head == reader->next && timeout_ms != 0){
+        _sensor_share_wait(reader, timeout_ms);
+        head = ring->head;
+    }
+    __sync_synchronize();
+
+    if(head - reader->next > reader->slots){
+        reader->lost += head - reader->next - reader->slots;
+        reader->next = head - reader->slots;
+    }
+
+    while(n < max && reader->next != head){
+        const struct sensor_share_slot_s* slot = &ring->slot[reader->next & reader->mask];
+        sensor_share_sample_s* s = &samples[n];
+        unsigned int position = slot->position;
+
+        __sync_synchronize();
+        s->type = slot->type;
+        s->timestamp = slot->time_stamp;
+        s->accuracy = slot->accuracy;
+        memcpy(s->values, slot->values, sizeof(s->values));
+        __sync_synchronize();
+
+        // lapped by the publisher while reading
+        if(position != reader->next + 1 || slot->position != position)
+            reader->lost++;
+        else
+            n++;
+        reader->next++;
+    }
+
+    *count = n;
+    if(n == 0 && ring->closed && reader->next == ring->head)
+        RETURN_ERROR(SENSOR_ERROR_IO_ERROR);
+
+    return SENSOR_ERROR_NONE;
+}
+
+int sensor_share_reader_get_lost(sensor_share_reader_h reader, unsigned long long *lost)
+{
+    if(reader == NULL || lost == NULL)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    *lost = reader->lost;
+    return SENSOR_ERROR_NONE;
+}
+
+int sensor_share_reader_close(sensor_share_reader_h reader)
+{
+    DEBUG_PRINT("sensor_share_reader_close");
+
+    if(reader == NULL)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    munmap((void*)reader->ring, reader->size);
+    free(reader);
+    return SENSOR_ERROR_NONE;
+}
@@ -0,0 +1,395 @@
+/*
+ * Copyright (c) 2011 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <sensor_framework_private.h>
+#include <sensors.h>
+#include <sensor_private.h>
+
+#define SPECTRUM_AXES           3
+#define SPECTRUM_MIN_WINDOW     16
+#define SPECTRUM_MAX_WINDOW     8192
+
+/*
+ * A real window of n samples is transformed with one complex FFT of n/2
+ * points on the even/odd interleaved samples, then split into the n/2+1
+ * bins of the real spectrum. Every table and buffer is allocated with the
+ * handle, the dispatch path never allocates. The twiddles of each stage
+ * are contiguous, its butterflies run four at a time on vectors of the
+ * compiler, which are the SIMD registers of the target when it has them.
+ */
+struct sensor_spectrum_s {
+    sensor_h sensor;
+    sensor_type_e type;
+    int interval_ms;
+    struct sensor_spectrum_s* next;
+
+    int n;
+    int bands;
+    int filled;
+    unsigned long long first_time_stamp;
+
+    float* input[SPECTRUM_AXES];    // n samples per axis
+    float* hann;                    // n
+    float* re;                      // n/2
+    float* im;                      // n/2
+    int* reverse;                   // n/2
+    float* twiddle_re;              // n/2-1 twiddles of the n/2 points FFT, stage of half h at h-1
+    float* twiddle_im;
+    float* split_cos;               // n/2+1 twiddles of the real split
+    float* split_sin;
+    float* power;                   // n/2+1
+    float* band_energy[SPECTRUM_AXES];
+    float scale;
+
+    sensor_spectrum_window_cb callback;
+    void* user_data;
+};
+
+typedef float sensor_spectrum_v4sf __attribute__((vector_size(16)));
+
+static inline sensor_spectrum_v4sf _sensor_spectrum_load(const float* p)
+{
+    sensor_spectrum_v4sf v;
+
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline void _sensor_spectrum_store(float* p, sensor_spectrum_v4sf v)
+{
+    memcpy(p, &v, sizeof(v));
+}
+
+static void _sensor_spectrum_fft(struct sensor_spectrum_s* s)
+{
+    int m = s->n / 2;
+    int i, j, half, start, k;
+    float* re = s->re;
+    float* im = s->im;
+
+    for(i=0; i<m; i++){
+        j = s->reverse[i];
+        if(j > i){
+            float t = re[i]; re[i] = re[j]; re[j] = t;
+            t = im[i]; im[i] = im[j]; im[j] = t;
+        }
+    }
+
+    for(half=1; half<m; half<<=1){
+        const float* wr = s->twiddle_re + half - 1;
+        const float* wi = s->twiddle_im + half - 1;
+
+        for(start=0; start<m; start+=2*half){
+            float* ra = re + start;
+            float* ia = im + start;
+            float* rb = ra + half;
+            float* ib = ia + half;
+
+            // from the stage of 8 points on, half is a multiple of 4
+            for(k=0; half>=4 && k<half; k+=4){
+                sensor_spectrum_v4sf vwr = _sensor_spectrum_load(wr + k);
+                sensor_spectrum_v4sf vwi = _sensor_spectrum_load(wi + k);
+                sensor_spectrum_v4sf ar = _sensor_spectrum_load(ra + k);
+                sensor_spectrum_v4sf ai = _sensor_spectrum_load(ia + k);
+                sensor_spectrum_v4sf br = _sensor_spectrum_load(rb + k);
+                sensor_spectrum_v4sf bi = _sensor_spectrum_load(ib + k);
+                sensor_spectrum_v4sf tr = br * vwr - bi * vwi;
+                sensor_spectrum_v4sf ti = br * vwi + bi * vwr;
+
+                _sensor_spectrum_store(rb + k, ar - tr);
+                _sensor_spectrum_store(ib + k, ai - ti);
+                _sensor_spectrum_store(ra + k, ar + tr);
+                _sensor_spectrum_store(ia + k, ai + ti);
+            }
+
+            for(; k<half; k++){
+                float tr = rb[k] * wr[k] - ib[k] * wi[k];
+                float ti = rb[k] * wi[k] + ib[k] * wr[k];
+
+                rb[k] = ra[k] - tr;
+                ib[k] = ia[k] - ti;
+                ra[k] += tr;
+                ia[k] += ti;
+            }
+        }
+    }
+}
+
+// power of the n/2+1 real bins from the n/2 points complex FFT
+static void _sensor_spectrum_split(struct sensor_spectrum_s* s)
+{
+    int m = s->n / 2;
+    int k;
+
+    for(k=0; k<=m; k++){
+        int a = k % m;
+        int b = (m - k) % m;
+        float er = (s->re[a] + s->re[b]) * 0.5f;
+        float ei = (s->im[a] - s->im[b]) * 0.5f;
+        float or_ = (s->im[a] + s->im[b]) * 0.5f;
+        float oi = -(s->re[a] - s->re[b]) * 0.5f;
+        float wr = s->split_cos[k];
+        float wi = -s->split_sin[k];
+        float xr = er + wr * or_ - wi * oi;
+        float xi = ei + wr * oi + wi * or_;
+
+        s->power[k] = (xr * xr + xi * xi) * s->scale;
+    }
+}
+
+static void _sensor_spectrum_window(struct sensor_spectrum_s* s, unsigned long long last_time_stamp)
+{
+    int a, i, k;
+    int m = s->n / 2;
+    float duration = (last_time_stamp - s->first_time_stamp) / 1000000.0f;
+    sensor_spectrum_window_s result;
+
+    memset(&result, 0, sizeof(result));
+    result.timestamp = last_time_stamp;
+    result.sample_rate = duration > 0 ? (s->n - 1) / duration : 0;
+    result.bands = s->bands;
+
+    for(a=0; a<SPECTRUM_AXES; a++){
+        float* x = s->input[a];
+        float mean = 0;
+        int peak = 1;
+
+        // gravity and offsets would leak through the window into the low bins
+        for(i=0; i<s->n; i++)
+            mean += x[i];
+        mean /= s->n;
+
+        for(i=0; i<m; i++){
+            s->re[i] = (x[2*i] - mean) * s->hann[2*i];
+            s->im[i] = (x[2*i+1] - mean) * s->hann[2*i+1];
+        }
+
+        _sensor_spectrum_fft(s);
+        _sensor_spectrum_split(s);
+
+        memset(s->band_energy[a], 0, s->bands * sizeof(float));
+        for(k=1; k<=m; k++){
+            s->band_energy[a][(long long)(k - 1) * s->bands / m] += s->power[k];
+            if(s->power[k] > s->power[peak])
+                peak = k;
+        }
+
+        result.peak_power[a] = s->power[peak];
+        if(peak < m){
+            // parabolic interpolation between the neighbour bins
+            float l = s->power[peak - 1], c = s->power[peak], r = s->power[peak + 1];
+            float d = l - 2 * c + r;
+            float offset = d != 0 ? 0.5f * (l - r) / d : 0;
+            result.peak_frequency[a] = (peak + offset) * result.sample_rate / s->n;
+        }else{
+            result.peak_frequency[a] = peak * result.sample_rate / s->n;
+        }
+        result.band_energy[a] = s->band_energy[a];
+    }
+
+    s->callback(&result, s->user_data);
+}
+
+void _sensor_spectrum_feed(struct sensor_spectrum_s* s, sensor_data_t* data, int data_num)
+{
+    int i;
+
+    for(; s != NULL; s = s->next){
+        if(s->callback == NULL)
+            continue;
+
+        for(i=0; i<data_num; i++){
+            if(s->filled == 0)
+                s->first_time_stamp = data[i].time_stamp;
+
+            s->input[0][s->filled] = data[i].values[0];
+            s->input[1][s->filled] = data[i].values[1];
+            s->input[2][s->filled] = data[i].values[2];
+
+            if(++s->filled == s->n){
+                _sensor_spectrum_window(s, data[i].time_stamp);
+                s->filled = 0;
+            }
+        }
+    }
+}
+
+void _sensor_spectrum_release(sensor_h handle)
+{
+    int i;
+    struct sensor_spectrum_s* s;
+
+    for(i=0; i<CB_NUMBERS; i++){
+        while( (s = handle->spectrum[i]) != NULL ){
+            handle->spectrum[i] = s->next;
+            free(s);
+        }
+    }
+}
+
+int sensor_spectrum_create(sensor_h sensor, sensor_type_e type, int interval_ms, int window_size, int bands, sensor_spectrum_h *spectrum)
+{
+    int a, i, bits, half;
+    int err;
+    int n = window_size;
+    int m = window_size / 2;
+    char* mem;
+    float sum2 = 0;
+    struct sensor_spectrum_s* s;
+
+    DEBUG_PRINT("sensor_spectrum_create");
+
+    RETURN_IF_NOT_HANDLE(sensor);
+    switch(type){
+        case SENSOR_ACCELEROMETER:
+        case SENSOR_MAGNETIC:
+        case SENSOR_GYROSCOPE:
+            break;
+        default:
+            RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+    }
+
+    if(spectrum == NULL || interval_ms < 0 || n < SPECTRUM_MIN_WINDOW || n > SPECTRUM_MAX_WINDOW || (n & (n - 1)) != 0)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+    if(bands < 1 || bands > m)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    mem = (char*)calloc(1, sizeof(struct sensor_spectrum_s)
+            + (SPECTRUM_AXES + 1) * n * sizeof(float)       // input, hann
+            + 2 * m * sizeof(float) + m * sizeof(int)       // re, im, reverse
+            + 2 * m * sizeof(float)                         // fft twiddles
+            + 3 * (m + 1) * sizeof(float)                   // split twiddles, power
+            + SPECTRUM_AXES * bands * sizeof(float));
+    if(mem == NULL)
+        RETURN_ERROR(SENSOR_ERROR_OUT_OF_MEMORY);
+
+    s = (struct sensor_spectrum_s*)mem;
+    mem += sizeof(struct sensor_spectrum_s);
+    for(a=0; a<SPECTRUM_AXES; a++){
+        s->input[a] = (float*)mem;
+        mem += n * sizeof(float);
+    }
+    s->hann = (float*)mem;          mem += n * sizeof(float);
+    s->re = (float*)mem;            mem += m * sizeof(float);
+    s->im = (float*)mem;            mem += m * sizeof(float);
+    s->reverse = (int*)mem;         mem += m * sizeof(int);
+    s->twiddle_re = (float*)mem;    mem += m * sizeof(float);
+    s->twiddle_im = (float*)mem;    mem += m * sizeof(float);
+    s->split_cos = (float*)mem;     mem += (m + 1) * sizeof(float);
+    s->split_sin = (float*)mem;     mem += (m + 1) * sizeof(float);
+    s->power = (float*)mem;         mem += (m + 1) * sizeof(float);
+    for(a=0; a<SPECTRUM_AXES; a++){
+        s->band_energy[a] = (float*)mem;
+        mem += bands * sizeof(float);
+    }
+
+    for(i=0; i<n; i++){
+        s->hann[i] = 0.5f - 0.5f * cos(2 * M_PI * i / n);
+        sum2 += s->hann[i] * s->hann[i];
+    }
+    // one-sided power normalized so that the bins add up to the mean square of the signal
+    s->scale = 2.0f / (n * sum2);
+
+    for(bits=0; (1 << bits) < m; bits++)
+        ;
+    for(i=0; i<m; i++){
+        int r = 0, b;
+        for(b=0; b<bits; b++)
+            r |= ((i >> b) & 1) << (bits - 1 - b);
+        s->reverse[i] = r;
+    }
+    for(half=1; half<m; half<<=1){
+        for(i=0; i<half; i++){
+            s->twiddle_re[half - 1 + i] = cos(M_PI * i / half);
+            s->twiddle_im[half - 1 + i] = -sin(M_PI * i / half);
+        }
+    }
+    for(i=0; i<=m; i++){
+        s->split_cos[i] = cos(2 * M_PI * i / n);
+        s->split_sin[i] = sin(2 * M_PI * i / n);
+    }
+
+    s->sensor = sensor;
+    s->type = type;
+    s->interval_ms = interval_ms;
+    s->n = n;
+    s->bands = bands;
+
+    if( (err = _sensor_listen(sensor, type, interval_ms)) != SENSOR_ERROR_NONE ){
+        free(s);
+        return err;
+    }
+
+    s->next = sensor->spectrum[type];
+    sensor->spectrum[type] = s;
+
+    *spectrum = s;
+    return SENSOR_ERROR_NONE;
+}
+
+int sensor_spectrum_destroy(sensor_spectrum_h spectrum)
+{
+    struct sensor_spectrum_s** link;
+
+    DEBUG_PRINT("sensor_spectrum_destroy");
+
+    if(spectrum == NULL)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    pthread_mutex_lock(&spectrum->sensor->lock);
+    for(link = &spectrum->sensor->spectrum[spectrum->type]; *link != NULL; link = &(*link)->next){
+        if(*link == spectrum){
+            *link = spectrum->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&spectrum->sensor->lock);
+
+    _sensor_unlisten(spectrum->sensor, spectrum->type, spectrum->interval_ms);
+    free(spectrum);
+
+    return SENSOR_ERROR_NONE;
+}
+
+int sensor_spectrum_set_window_cb(sensor_spectrum_h spectrum, sensor_spectrum_window_cb callback, void *user_data)
+{
+    if(spectrum == NULL || callback == NULL)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    spectrum->user_data = user_data;
+    spectrum->callback = callback;
+
+    return SENSOR_ERROR_NONE;
+}
+
+int sensor_spectrum_unset_window_cb(sensor_spectrum_h spectrum)
+{
+    if(spectrum == NULL)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    spectrum->callback = NULL;
+    spectrum->user_data = NULL;
+    spectrum->filled = 0;
+
+    return SENSOR_ERROR_NONE;
+}
@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2011 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <sensor_framework_private.h>
+#include <sensors.h>
+#include <sensor_private.h>
+
+/*
+ * The state file is mapped shared for the life of the handle. A snapshot
+ * is a memcpy into the mapping, the kernel writes the pages back, so the
+ * periodic save costs no system call. The file is only trusted when its
+ * magic, version and size match and no snapshot was interrupted.
+ */
+#define STATE_MAGIC         0x54534e53      // "SNST"
+#define STATE_VERSION       1
+
+struct sensor_state_file_s {
+    unsigned int magic;
+    unsigned int version;
+    unsigned int size;
+    unsigned int writing;       // set while a snapshot is copied
+    unsigned int sections;
+
+    struct sensor_state_magnetic_s magnetic;
+    struct sensor_state_gyroscope_s gyroscope;
+};
+
+struct sensor_state_s {
+    struct sensor_state_file_s* file;
+    unsigned long long interval_us;
+    unsigned long long last_save;
+};
+
+static void _sensor_state_save(sensor_h handle)
+{
+    struct sensor_state_file_s* f = handle->state->file;
+    unsigned int sections = 0;
+
+    f->writing = 1;
+    __sync_synchronize();
+
+    if(handle->magnetic_calibration != NULL){
+        _sensor_magnetic_calibration_save(handle, &f->magnetic);
+        sections |= SENSOR_STATE_MAGNETIC;
+    }else{
+        sections |= f->sections & SENSOR_STATE_MAGNETIC;
+    }
+
+    if(handle->gyroscope_bias != NULL){
+        _sensor_gyroscope_bias_save(handle, &f->gyroscope);
+        sections |= SENSOR_STATE_GYROSCOPE;
+    }else{
+        sections |= f->sections & SENSOR_STATE_GYROSCOPE;
+    }
+
+    f->sections = sections;
+    __sync_synchronize();
+    f->writing = 0;
+}
+
+void _sensor_state_feed(sensor_h handle, unsigned long long time_stamp)
+{
+    struct sensor_state_s* s = handle->state;
+
+    if(s->interval_us == 0)
+        return;
+
+    if(s->last_save == 0 || time_stamp < s->last_save){
+        s->last_save = time_stamp;
+        return;
+    }
+
+    if(time_stamp - s->last_save >= s->interval_us){
+        _sensor_state_save(handle);
+        s->last_save = time_stamp;
+    }
+}
+
+// loads the given sections of the file into the features that are enabled
+void _sensor_state_restore(sensor_h handle, unsigned int sections)
+{
+    struct sensor_state_file_s* f;
+
+    if(handle->state == NULL)
+        return;
+
+    f = handle->state->file;
+    sections &= f->sections;
+
+    if((sections & SENSOR_STATE_MAGNETIC) && handle->magnetic_calibration != NULL)
+        _sensor_magnetic_calibration_load(handle, &f->magnetic);
+    if((sections & SENSOR_STATE_GYROSCOPE) && handle->gyroscope_bias != NULL)
+        _sensor_gyroscope_bias_load(handle, &f->gyroscope);
+}
+
+void _sensor_state_release(sensor_h handle)
+{
+    struct sensor_state_s* s = handle->state;
+
+    if(s == NULL)
+        return;
+
+    _sensor_state_save(handle);
+    msync(s->file, sizeof(struct sensor_state_file_s), MS_SYNC);
+    munmap(s->file, sizeof(struct sensor_state_file_s));
+
+    free(s);
+    handle->state = NULL;
+}
+
+int sensor_state_file_set(sensor_h sensor, const char *path, int interval_ms)
+{
+    int fd;
+    struct stat st;
+    void* map;
+    struct sensor_state_s* s;
+    struct sensor_state_file_s* f;
+
+    DEBUG_PRINT("sensor_state_file_set");
+
+    RETURN_IF_NOT_HANDLE(sensor);
+    if(path == NULL || interval_ms < 0)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    _sensor_release(sensor, _sensor_state_release);
+
+    s = (struct sensor_state_s*)calloc(1, sizeof(struct sensor_state_s));
+    if(s == NULL)
+        RETURN_ERROR(SENSOR_ERROR_OUT_OF_MEMORY);
+
+    fd = open(path, O_RDWR | O_CREAT, 0600);
+    if(fd < 0){
+        free(s);
+        RETURN_ERROR(SENSOR_ERROR_IO_ERROR);
+    }
+
+    if(fstat(fd, &st) < 0 || (st.st_size != sizeof(struct sensor_state_file_s) && ftruncate(fd, sizeof(struct sensor_state_file_s)) < 0)){
+        close(fd);
+        free(s);
+        RETURN_ERROR(SENSOR_ERROR_IO_ERROR);
+    }
+
+    map = mmap(NULL, sizeof(struct sensor_state_file_s), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if(map == MAP_FAILED){
+        free(s);
+        RETURN_ERROR(SENSOR_ERROR_IO_ERROR);
+    }
+
+    f = (struct sensor_state_file_s*)map;
+    if(st.st_size != sizeof(struct sensor_state_file_s) || f->magic != STATE_MAGIC || f->version != STATE_VERSION
+            || f->size != sizeof(struct sensor_state_file_s) || f->writing){
+        memset(f, 0, sizeof(struct sensor_state_file_s));
+        f->magic = STATE_MAGIC;
+        f->version = STATE_VERSION;
+        f->size = sizeof(struct sensor_state_file_s);
+    }
+
+    s->file = f;
+    s->interval_us = interval_ms * 1000ull;
+    sensor->state = s;
+
+    _sensor_state_restore(sensor, SENSOR_STATE_MAGNETIC | SENSOR_STATE_GYROSCOPE);
+
+    return SENSOR_ERROR_NONE;
+}
+
+int sensor_state_file_unset(sensor_h sensor)
+{
+    DEBUG_PRINT("sensor_state_file_unset");
+
+    RETURN_IF_NOT_HANDLE(sensor);
+
+    _sensor_release(sensor, _sensor_state_release);
+    return SENSOR_ERROR_NONE;
+}
@@ -0,0 +1,340 @@
+/*
+ * Copyright (c) 2011 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <sensor_framework_private.h>
+#include <sensors.h>
+#include <sensor_private.h>
+
+#define STATS_AXES          3
+#define STATS_MAX_SAMPLES   65536
+
+struct _stats_sample {
+    unsigned long long time_stamp;
+    float values[STATS_AXES];
+};
+
+// published copy of the accumulators, guarded by sensor_stats_s::seq
+struct _stats_snapshot {
+    unsigned long long time_stamp;
+    int count;
+    double mean[STATS_AXES];
+    double m2[STATS_AXES];
+    float min[STATS_AXES];
+    float max[STATS_AXES];
+};
+
+struct sensor_stats_s {
+    sensor_h sensor;
+    sensor_type_e type;
+    struct sensor_stats_s* next;
+
+    unsigned long long window_us;
+    unsigned long long window_start;
+
+    // samples inside the window, head and tail are running sequence numbers
+    int capacity;
+    struct _stats_sample* ring;
+    unsigned int head;
+    unsigned int tail;
+
+    // monotonic deques of sequence numbers, front is the current min/max
+    unsigned int* min_q[STATS_AXES];
+    unsigned int* max_q[STATS_AXES];
+    unsigned int min_head[STATS_AXES], min_tail[STATS_AXES];
+    unsigned int max_head[STATS_AXES], max_tail[STATS_AXES];
+
+    // Welford accumulators
+    double mean[STATS_AXES];
+    double m2[STATS_AXES];
+
+    sensor_stats_window_cb window_cb;
+    void* window_user_data;
+
+    unsigned int seq;
+    struct _stats_snapshot published;
+};
+
+#define _SAMPLE(stats, n) (&(stats)->ring[(n) & ((stats)->capacity - 1)])
+#define _QUEUE(q, n, capacity) ((q)[(n) & ((capacity) - 1)])
+
+static void _sensor_stats_evict(struct sensor_stats_s* stats)
+{
+    int a;
+    int count = stats->tail - stats->head;
+    struct _stats_sample* old = _SAMPLE(stats, stats->head);
+
+    for(a=0; a<STATS_AXES; a++){
+        double d;
+
+        if(count == 1){
+            stats->mean[a] = 0;
+            stats->m2[a] = 0;
+        }else{
+            d = old->values[a] - stats->mean[a];
+            stats->mean[a] -= d / (count - 1);
+            stats->m2[a] -= d * (old->values[a] - stats->mean[a]);
+        }
+
+        if(stats->min_head[a] != stats->min_tail[a] && _QUEUE(stats->min_q[a], stats->min_head[a], stats->capacity) == stats->head)
+            stats->min_head[a]++;
+        if(stats->max_head[a] != stats->max_tail[a] && _QUEUE(stats->max_q[a], stats->max_head[a], stats->capacity) == stats->head)
+            stats->max_head[a]++;
+    }
+
+    stats->head++;
+}
+
+static void _sensor_stats_push(struct sensor_stats_s* stats, sensor_data_t* data)
+{
+    int a;
+    int count;
+    unsigned int n = stats->tail;
+    struct _stats_sample* sample = _SAMPLE(stats, n);
+
+    sample->time_stamp = data->time_stamp;
+    memcpy(sample->values, data->values, sizeof(sample->values));
+    stats->tail++;
+    count = stats->tail - stats->head;
+
+    for(a=0; a<STATS_AXES; a++){
+        float v = sample->values[a];
+        double d = v - stats->mean[a];
+
+        stats->mean[a] += d / count;
+        stats->m2[a] += d * (v - stats->mean[a]);
+
+        while(stats->min_head[a] != stats->min_tail[a] &&
+                _SAMPLE(stats, _QUEUE(stats->min_q[a], stats->min_tail[a] - 1, stats->capacity))->values[a] >= v)
+            stats->min_tail[a]--;
+        _QUEUE(stats->min_q[a], stats->min_tail[a]++, stats->capacity) = n;
+
+        while(stats->max_head[a] != stats->max_tail[a] &&
+                _SAMPLE(stats, _QUEUE(stats->max_q[a], stats->max_tail[a] - 1, stats->capacity))->values[a] <= v)
+            stats->max_tail[a]--;
+        _QUEUE(stats->max_q[a], stats->max_tail[a]++, stats->capacity) = n;
+    }
+}
+
+static void _sensor_stats_publish(struct sensor_stats_s* stats)
+{
+    int a;
+    struct _stats_snapshot* p = &stats->published;
+
+    _sensor_seq_write_begin(&stats->seq);
+    p->time_stamp = _SAMPLE(stats, stats->tail - 1)->time_stamp;
+    p->count = stats->tail - stats->head;
+    for(a=0; a<STATS_AXES; a++){
+        p->mean[a] = stats->mean[a];
+        p->m2[a] = stats->m2[a];
+        p->min[a] = _SAMPLE(stats, _QUEUE(stats->min_q[a], stats->min_head[a], stats->capacity))->values[a];
+        p->max[a] = _SAMPLE(stats, _QUEUE(stats->max_q[a], stats->max_head[a], stats->capacity))->values[a];
+    }
+    _sensor_seq_write_end(&stats->seq);
+}
+
+static void _sensor_stats_summarize(const struct _stats_snapshot* p, sensor_stats_summary_s* summary)
+{
+    int a;
+
+    memset(summary, 0, sizeof(*summary));
+    summary->timestamp = p->time_stamp;
+    summary->count = p->count;
+    if(p->count <= 0)
+        return;
+
+    for(a=0; a<STATS_AXES; a++){
+        double variance = p->m2[a] / p->count;
+        if(variance < 0)
+            variance = 0;
+        summary->mean[a] = p->mean[a];
+        summary->variance[a] = variance;
+        summary->min[a] = p->min[a];
+        summary->max[a] = p->max[a];
+        summary->rms[a] = sqrt(variance + p->mean[a] * p->mean[a]);
+    }
+}
+
+void _sensor_stats_feed(struct sensor_stats_s* stats, sensor_data_t* data, int data_num)
+{
+    int i;
+    sensor_stats_summary_s summary;
+
+    for(; stats != NULL; stats = stats->next){
+        for(i=0; i<data_num; i++){
+            unsigned long long ts = data[i].time_stamp;
+
+            while(stats->tail != stats->head &&
+                    (stats->tail - stats->head >= (unsigned int)stats->capacity ||
+                     _SAMPLE(stats, stats->head)->time_stamp + stats->window_us <= ts))
+                _sensor_stats_evict(stats);
+
+            _sensor_stats_push(stats, &data[i]);
+            _sensor_stats_publish(stats);
+
+            if(stats->window_start == 0 || ts < stats->window_start)
+                stats->window_start = ts;
+
+            if(ts - stats->window_start >= stats->window_us){
+                stats->window_start = ts;
+                if(stats->window_cb != NULL){
+                    _sensor_stats_summarize(&stats->published, &summary);
+                    stats->window_cb(&summary, stats->window_user_data);
+                }
+            }
+        }
+    }
+}
+
+void _sensor_stats_release(sensor_h handle)
+{
+    int i;
+    struct sensor_stats_s* stats;
+
+    for(i=0; i<CB_NUMBERS; i++){
+        while( (stats = handle->stats[i]) != NULL ){
+            handle->stats[i] = stats->next;
+            free(stats);
+        }
+    }
+}
+
+int sensor_stats_create(sensor_h sensor, sensor_type_e type, int window_ms, sensor_stats_h *stats)
+{
+    int a;
+    int err;
+    int capacity;
+    char* mem;
+    struct sensor_stats_s* s;
+
+    DEBUG_PRINT("sensor_stats_create");
+
+    RETURN_IF_NOT_HANDLE(sensor);
+    RETURN_IF_NOT_TYPE(type);
+    RETURN_IF_MOTION_TYPE(type);
+    RETURN_IF_VIRTUAL_TYPE(type);
+
+    if(stats == NULL || window_ms <= 0)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    // power of two so that the running sequence numbers wrap cleanly
+    capacity = 1;
+    while(capacity <= window_ms && capacity < STATS_MAX_SAMPLES)
+        capacity <<= 1;
+
+    mem = (char*)calloc(1, sizeof(struct sensor_stats_s)
+            + capacity * sizeof(struct _stats_sample)
+            + 2 * STATS_AXES * capacity * sizeof(unsigned int));
+    if(mem == NULL)
+        RETURN_ERROR(SENSOR_ERROR_OUT_OF_MEMORY);
+
+    s = (struct sensor_stats_s*)mem;
+    mem += sizeof(struct sensor_stats_s);
+    s->ring = (struct _stats_sample*)mem;
+    mem += capacity * sizeof(struct _stats_sample);
+    for(a=0; a<STATS_AXES; a++){
+        s->min_q[a] = (unsigned int*)mem;
+        mem += capacity * sizeof(unsigned int);
+        s->max_q[a] = (unsigned int*)mem;
+        mem += capacity * sizeof(unsigned int);
+    }
+
+    s->sensor = sensor;
+    s->type = type;
+    s->capacity = capacity;
+    s->window_us = window_ms * 1000ull;
+
+    if( (err = _sensor_listen(sensor, type, 0)) != SENSOR_ERROR_NONE ){
+        free(s);
+        return err;
+    }
+
+    s->next = sensor->stats[type];
+    sensor->stats[type] = s;
+
+    *stats = s;
+    return SENSOR_ERROR_NONE;
+}
+
+int sensor_stats_destroy(sensor_stats_h stats)
+{
+    struct sensor_stats_s** link;
+
+    DEBUG_PRINT("sensor_stats_destroy");
+
+    if(stats == NULL)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    pthread_mutex_lock(&stats->sensor->lock);
+    for(link = &stats->sensor->stats[stats->type]; *link != NULL; link = &(*link)->next){
+        if(*link == stats){
+            *link = stats->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&stats->sensor->lock);
+
+    _sensor_unlisten(stats->sensor, stats->type, 0);
+    free(stats);
+
+    return SENSOR_ERROR_NONE;
+}
+
+int sensor_stats_get(sensor_stats_h stats, sensor_stats_summary_s *summary)
+{
+    unsigned int seq;
+    struct _stats_snapshot snapshot;
+
+    if(stats == NULL || summary == NULL)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    do {
+        seq = _sensor_seq_read_begin(&stats->seq);
+        snapshot = stats->published;
+    } while(_sensor_seq_read_retry(&stats->seq, seq));
+
+    _sensor_stats_summarize(&snapshot, summary);
+
+    return SENSOR_ERROR_NONE;
+}
+
+int sensor_stats_set_window_cb(sensor_stats_h stats, sensor_stats_window_cb callback, void *user_data)
+{
+    if(stats == NULL || callback == NULL)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    stats->window_user_data = user_data;
+    stats->window_cb = callback;
+
+    return SENSOR_ERROR_NONE;
+}
+
+int sensor_stats_unset_window_cb(sensor_stats_h stats)
+{
+    if(stats == NULL)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    stats->window_cb = NULL;
+    stats->window_user_data = NULL;
+
+    return SENSOR_ERROR_NONE;
+}
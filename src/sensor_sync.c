@@ -0,0 +1,484 @@
+/*
+ * Copyright (c) 2011 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <sensor_framework_private.h>
+#include <sensors.h>
+#include <sensor_private.h>
+
+#define DEG2RAD         (M_PI / 180.0)
+#define RAD2DEG         (180.0 / M_PI)
+
+#define SYNC_ACCEL      0
+#define SYNC_GYRO       1
+#define SYNC_MAG        2
+#define SYNC_ORIENT     3
+#define SYNC_STREAMS    4
+
+#define MAX_CAPACITY    1024
+
+// a stream silent for longer than this is restarted, not caught up frame by frame
+#define MAX_GAP_US      1000000ull
+
+static const sensor_type_e _sync_types[SYNC_STREAMS] = {
+    SENSOR_ACCELEROMETER, SENSOR_GYROSCOPE, SENSOR_MAGNETIC, SENSOR_ORIENTATION,
+};
+
+/*
+ * Each stream keeps its recent samples in a ring indexed by free running
+ * sequence numbers. Frames are produced on multiples of the interval once
+ * every active stream has a sample at or after the frame time, or once the
+ * newest sample is max_latency past it, in which case the lagging streams
+ * hold their last value.
+ */
+struct sensor_sync_stream_s {
+    unsigned int head;
+    unsigned int tail;
+    unsigned long long* time_stamp;
+    float* values;                  // 4 per sample, orientation is stored as a quaternion x, y, z, w
+};
+
+struct sensor_sync_s {
+    sensor_h sensor;
+    struct sensor_sync_s* next;
+
+    int interval_ms;
+    unsigned long long interval;
+    unsigned long long max_latency;
+    unsigned long long next_frame;
+    unsigned long long first_time_stamp;
+    unsigned int mask;
+
+    int active[SYNC_STREAMS];
+    struct sensor_sync_stream_s stream[SYNC_STREAMS];
+
+    sensor_frame_cb callback;
+    void* user_data;
+    sensor_orientation_frame_cb orientation_callback;
+    void* orientation_user_data;
+};
+
+static void _sensor_sync_euler_to_quat(const float* e, float* q)
+{
+    // azimuth around z, then roll around y, then pitch around x
+    double cz = cos(e[0] * DEG2RAD / 2), sz = sin(e[0] * DEG2RAD / 2);
+    double cx = cos(e[1] * DEG2RAD / 2), sx = sin(e[1] * DEG2RAD / 2);
+    double cy = cos(e[2] * DEG2RAD / 2), sy = sin(e[2] * DEG2RAD / 2);
+
+    q[0] = cz*cy*sx - sz*sy*cx;
+    q[1] = cz*sy*cx + sz*cy*sx;
+    q[2] = sz*cy*cx - cz*sy*sx;
+    q[3] = cz*cy*cx + sz*sy*sx;
+}
+
+static void _sensor_sync_quat_to_euler(const float* q, float* e)
+{
+    double x = q[0], y = q[1], z = q[2], w = q[3];
+    double s = 2 * (w*y - z*x);
+
+    if(s > 1) s = 1;
+    if(s < -1) s = -1;
+
+    e[0] = atan2(2 * (w*z + x*y), 1 - 2 * (y*y + z*z)) * RAD2DEG;
+    if(e[0] < 0)
+        e[0] += 360;
+    e[1] = atan2(2 * (w*x + y*z), 1 - 2 * (x*x + y*y)) * RAD2DEG;
+    e[2] = asin(s) * RAD2DEG;
+}
+
+static void _sensor_sync_slerp(const float* a, const float* b, float t, float* out)
+{
+    double dot = a[0]*b[0] + a[1]*b[1] + a[2]*b[2] + a[3]*b[3];
+    double sign = 1, wa, wb, norm;
+    int i;
+
+    // take the shortest way around
+    if(dot < 0){
+        dot = -dot;
+        sign = -1;
+    }
+
+    if(dot > 0.9995){
+        wa = 1 - t;
+        wb = t;
+    }else{
+        double theta = acos(dot);
+        double st = sin(theta);
+        wa = sin((1 - t) * theta) / st;
+        wb = sin(t * theta) / st;
+    }
+    wb *= sign;
+
+    for(i=0; i<4; i++)
+        out[i] = wa * a[i] + wb * b[i];
+
+    norm = sqrt(out[0]*out[0] + out[1]*out[1] + out[2]*out[2] + out[3]*out[3]);
+    for(i=0; i<4; i++)
+        out[i] /= norm;
+}
+
+static void _sensor_sync_flush(struct sensor_sync_s* s)
+{
+    int i;
+
+    for(i=0; i<SYNC_STREAMS; i++)
+        s->stream[i].tail = s->stream[i].head;
+    s->next_frame = 0;
+    s->first_time_stamp = 0;
+}
+
+// value of the stream at time t, interpolated or held
+static void _sensor_sync_sample(struct sensor_sync_s* s, int id, unsigned long long t, float* out)
+{
+    struct sensor_sync_stream_s* st = &s->stream[id];
+    unsigned int a, b;
+    float* va;
+    float* vb;
+    float f;
+    int i;
+
+    if(st->head == st->tail){
+        memset(out, 0, 4 * sizeof(float));
+        if(id == SYNC_ORIENT)
+            out[3] = 1;
+        return;
+    }
+
+    // keep a single sample at or before t, frame times only move forward
+    while(st->head - st->tail > 1 && st->time_stamp[(st->tail + 1) & s->mask] <= t)
+        st->tail++;
+
+    a = st->tail & s->mask;
+    va = st->values + a * 4;
+
+    if(st->head - st->tail == 1 || st->time_stamp[a] >= t){
+        memcpy(out, va, 4 * sizeof(float));
+        return;
+    }
+
+    b = (st->tail + 1) & s->mask;
+    vb = st->values + b * 4;
+    f = (float)(t - st->time_stamp[a]) / (float)(st->time_stamp[b] - st->time_stamp[a]);
+
+    if(id == SYNC_ORIENT){
+        _sensor_sync_slerp(va, vb, f, out);
+        return;
+    }
+
+    for(i=0; i<3; i++)
+        out[i] = va[i] + (vb[i] - va[i]) * f;
+    out[3] = 0;
+}
+
+static unsigned long long _sensor_sync_newest(struct sensor_sync_s* s, int id)
+{
+    struct sensor_sync_stream_s* st = &s->stream[id];
+
+    if(st->head == st->tail)
+        return 0;
+    return st->time_stamp[(st->head - 1) & s->mask];
+}
+
+static void _sensor_sync_emit(struct sensor_sync_s* s)
+{
+    int i;
+    int waiting = 0;
+    unsigned long long newest = 0, start = 0, t;
+    float v[SYNC_STREAMS][4];
+
+    for(i=0; i<SYNC_STREAMS; i++){
+        struct sensor_sync_stream_s* st = &s->stream[i];
+        unsigned long long n;
+
+        if(!s->active[i])
+            continue;
+        if(st->head == st->tail){
+            waiting = 1;
+            continue;
+        }
+        n = _sensor_sync_newest(s, i);
+        if(n > newest)
+            newest = n;
+        if(st->time_stamp[st->tail & s->mask] > start)
+            start = st->time_stamp[st->tail & s->mask];
+    }
+
+    if(newest == 0)
+        return;
+
+    if(s->next_frame == 0){
+        // start on the first frame every stream can interpolate, or give up waiting after max_latency
+        if(!waiting)
+            t = start;
+        else if(newest >= s->first_time_stamp + s->max_latency)
+            t = newest - s->max_latency;
+        else
+            return;
+        s->next_frame = (t + s->interval - 1) / s->interval * s->interval;
+    }else if(newest > s->next_frame + s->max_latency + MAX_GAP_US){
+        s->next_frame = (newest - s->max_latency) / s->interval * s->interval;
+    }
+
+    while(1){
+        t = s->next_frame;
+
+        if(newest < t + s->max_latency){
+            int ready = 1;
+            for(i=0; i<SYNC_STREAMS; i++){
+                if(s->active[i] && _sensor_sync_newest(s, i) < t)
+                    ready = 0;
+            }
+            if(!ready)
+                break;
+        }
+
+        for(i=0; i<SYNC_STREAMS; i++){
+            if(s->active[i])
+                _sensor_sync_sample(s, i, t, v[i]);
+        }
+
+        s->callback(t, v[SYNC_ACCEL], v[SYNC_GYRO], v[SYNC_MAG], s->user_data);
+
+        if(s->orientation_callback != NULL){
+            float e[3];
+            _sensor_sync_quat_to_euler(v[SYNC_ORIENT], e);
+            s->orientation_callback(t, e[0], e[1], e[2], s->orientation_user_data);
+        }
+
+        s->next_frame += s->interval;
+    }
+}
+
+void _sensor_sync_feed(struct sensor_sync_s* s, sensor_type_e type, sensor_data_t* data, int data_num)
+{
+    int id, i;
+
+    for(id=0; id<SYNC_STREAMS; id++){
+        if(_sync_types[id] == type)
+            break;
+    }
+    if(id == SYNC_STREAMS)
+        return;
+
+    for(; s != NULL; s = s->next){
+        struct sensor_sync_stream_s* st = &s->stream[id];
+
+        if(!s->active[id] || s->callback == NULL)
+            continue;
+
+        for(i=0; i<data_num; i++){
+            unsigned int slot;
+            unsigned long long last = _sensor_sync_newest(s, id);
+
+            // the stream was restarted, frames in flight can not be aligned anymore
+            if(data[i].time_stamp < last)
+                _sensor_sync_flush(s);
+            else if(data[i].time_stamp == last)
+                continue;
+            if(s->first_time_stamp == 0)
+                s->first_time_stamp = data[i].time_stamp;
+
+            if(st->head - st->tail > s->mask)
+                st->tail++;
+
+            slot = st->head & s->mask;
+            st->time_stamp[slot] = data[i].time_stamp;
+            if(id == SYNC_ORIENT){
+                _sensor_sync_euler_to_quat(data[i].values, st->values + slot * 4);
+            }else{
+                memcpy(st->values + slot * 4, data[i].values, 3 * sizeof(float));
+                st->values[slot * 4 + 3] = 0;
+            }
+            st->head++;
+        }
+
+        _sensor_sync_emit(s);
+    }
+}
+
+void _sensor_sync_release(sensor_h handle)
+{
+    struct sensor_sync_s* s;
+
+    while( (s = handle->sync) != NULL ){
+        handle->sync = s->next;
+        free(s);
+    }
+}
+
+static void _sensor_sync_unlisten(struct sensor_sync_s* s)
+{
+    int i;
+
+    for(i=0; i<SYNC_STREAMS; i++){
+        if(s->active[i])
+            _sensor_unlisten(s->sensor, _sync_types[i], s->interval_ms);
+        s->active[i] = 0;
+    }
+}
+
+int sensor_sync_create(sensor_h sensor, int interval_ms, int max_latency_ms, sensor_sync_h *sync)
+{
+    int i, err;
+    unsigned int capacity = 4;
+    char* mem;
+    struct sensor_sync_s* s;
+
+    DEBUG_PRINT("sensor_sync_create");
+
+    RETURN_IF_NOT_HANDLE(sensor);
+    if(sync == NULL || interval_ms <= 0 || max_latency_ms < 0)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    // enough for a 1kHz stream over the latency bound and one frame interval
+    while(capacity < (unsigned int)(max_latency_ms + interval_ms + 2) && capacity < MAX_CAPACITY)
+        capacity <<= 1;
+
+    mem = (char*)calloc(1, sizeof(struct sensor_sync_s)
+            + SYNC_STREAMS * capacity * (sizeof(unsigned long long) + 4 * sizeof(float)));
+    if(mem == NULL)
+        RETURN_ERROR(SENSOR_ERROR_OUT_OF_MEMORY);
+
+    s = (struct sensor_sync_s*)mem;
+    mem += sizeof(struct sensor_sync_s);
+    for(i=0; i<SYNC_STREAMS; i++){
+        s->stream[i].time_stamp = (unsigned long long*)mem;
+        mem += capacity * sizeof(unsigned long long);
+        s->stream[i].values = (float*)mem;
+        mem += capacity * 4 * sizeof(float);
+    }
+
+    s->sensor = sensor;
+    s->mask = capacity - 1;
+    s->interval_ms = interval_ms;
+    s->interval = interval_ms * 1000ull;
+    s->max_latency = max_latency_ms * 1000ull;
+
+    for(i=SYNC_ACCEL; i<=SYNC_MAG; i++){
+        if( (err = _sensor_listen(sensor, _sync_types[i], interval_ms)) != SENSOR_ERROR_NONE ){
+            _sensor_sync_unlisten(s);
+            free(s);
+            return err;
+        }
+        s->active[i] = 1;
+    }
+
+    pthread_mutex_lock(&sensor->lock);
+    s->next = sensor->sync;
+    sensor->sync = s;
+    pthread_mutex_unlock(&sensor->lock);
+
+    *sync = s;
+    return SENSOR_ERROR_NONE;
+}
+
+int sensor_sync_destroy(sensor_sync_h sync)
+{
+    struct sensor_sync_s** link;
+
+    DEBUG_PRINT("sensor_sync_destroy");
+
+    if(sync == NULL)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    pthread_mutex_lock(&sync->sensor->lock);
+    for(link = &sync->sensor->sync; *link != NULL; link = &(*link)->next){
+        if(*link == sync){
+            *link = sync->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&sync->sensor->lock);
+
+    _sensor_sync_unlisten(sync);
+    free(sync);
+
+    return SENSOR_ERROR_NONE;
+}
+
+int sensor_sync_set_frame_cb(sensor_sync_h sync, sensor_frame_cb callback, void *user_data)
+{
+    if(sync == NULL || callback == NULL)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    pthread_mutex_lock(&sync->sensor->lock);
+    sync->user_data = user_data;
+    sync->callback = callback;
+    pthread_mutex_unlock(&sync->sensor->lock);
+
+    return SENSOR_ERROR_NONE;
+}
+
+int sensor_sync_unset_frame_cb(sensor_sync_h sync)
+{
+    if(sync == NULL)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    pthread_mutex_lock(&sync->sensor->lock);
+    sync->callback = NULL;
+    sync->user_data = NULL;
+    _sensor_sync_flush(sync);
+    pthread_mutex_unlock(&sync->sensor->lock);
+
+    return SENSOR_ERROR_NONE;
+}
+
+int sensor_sync_set_orientation_cb(sensor_sync_h sync, sensor_orientation_frame_cb callback, void *user_data)
+{
+    int err;
+
+    if(sync == NULL || callback == NULL)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    if(!sync->active[SYNC_ORIENT] && (err = _sensor_listen(sync->sensor, SENSOR_ORIENTATION, sync->interval_ms)) != SENSOR_ERROR_NONE)
+        return err;
+
+    // the dispatch feeds the streams under the handle lock
+    pthread_mutex_lock(&sync->sensor->lock);
+    if(!sync->active[SYNC_ORIENT]){
+        sync->active[SYNC_ORIENT] = 1;
+        _sensor_sync_flush(sync);
+    }
+    sync->orientation_user_data = user_data;
+    sync->orientation_callback = callback;
+    pthread_mutex_unlock(&sync->sensor->lock);
+
+    return SENSOR_ERROR_NONE;
+}
+
+int sensor_sync_unset_orientation_cb(sensor_sync_h sync)
+{
+    if(sync == NULL)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    if(!sync->active[SYNC_ORIENT])
+        return SENSOR_ERROR_NONE;
+
+    pthread_mutex_lock(&sync->sensor->lock);
+    sync->active[SYNC_ORIENT] = 0;
+    sync->orientation_callback = NULL;
+    sync->orientation_user_data = NULL;
+    _sensor_sync_flush(sync);
+    pthread_mutex_unlock(&sync->sensor->lock);
+
+    return _sensor_unlisten(sync->sensor, SENSOR_ORIENTATION, sync->interval_ms);
+}
@@ -0,0 +1,294 @@
+/*
+ * Copyright (c) 2011 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+
+#include <sensor_framework_private.h>
+#include <sensors.h>
+#include <sensor_private.h>
+
+/*
+ * Every thread records its spans in a ring of its own, the only writer of
+ * it. The rings are chained in a list under a lock, taken by a thread on
+ * its first span and by the export, never by the recording of a span. A
+ * slot carries the position it holds once written, the export skips a slot
+ * overwritten while it was read. The rings of a previous trace are told
+ * apart by their generation and reused by their thread, or freed by it when
+ * their size differs. A thread leaves its ring behind on exit to keep its
+ * spans for the export, the next trace frees it.
+ */
+struct sensor_trace_event_s {
+    volatile unsigned int position;     // position of the span + 1, once written
+    unsigned short span;
+    short type;
+    unsigned long long begin;           // monotonic clock, nanoseconds
+    unsigned long long end;
+};
+
+struct sensor_trace_buffer_s {
+    struct sensor_trace_buffer_s* next;
+    pid_t tid;
+    volatile int exited;
+    unsigned int generation;
+    unsigned int size;                  // a power of 2
+    volatile unsigned int head;
+    struct sensor_trace_event_s event[];
+};
+
+volatile int _sensor_trace_on;
+
+static struct {
+    volatile unsigned int generation;
+    unsigned int size;
+    struct sensor_trace_buffer_s* buffers;
+    pthread_mutex_t lock;
+    pthread_key_t key;
+} _trace = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+static __thread struct sensor_trace_buffer_s* _buffer;
+static pthread_once_t _trace_once = PTHREAD_ONCE_INIT;
+
+static const char* _SPAN_NAME[] = {
+    "sf_connect",
+    "sf_register_event",
+    "sf_unregister_event",
+    "sf_get_data",
+    "_sensor_callback",
+    "user callback",
+};
+
+static const char* _TYPE_NAME[] = {
+    "ACCELEROMETER",
+    "MAGNETIC",
+    "ORIENTATION",
+    "GYROSCOPE",
+    "LIGHT",
+    "PROXIMITY",
+    "MOTION_SNAP",
+    "MOTION_SHAKE",
+    "MOTION_DOUBLETAP",
+    "MOTION_PANNING",
+    "MOTION_FACEDOWN",
+    "DEVICE_ORIENTATION",
+    "PEDOMETER",
+};
+
+unsigned long long _sensor_trace_now(void)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000000000ull + t.tv_nsec;
+}
+
+static void _sensor_trace_exit(void* buffer)
+{
+    ((struct sensor_trace_buffer_s*)buffer)->exited = 1;
+    _buffer = NULL;
+}
+
+static void _sensor_trace_init(void)
+{
+    pthread_key_create(&_trace.key, _sensor_trace_exit);
+}
+
+// called with the lock held
+static void _sensor_trace_unlink(struct sensor_trace_buffer_s* b)
+{
+    struct sensor_trace_buffer_s** p;
+
+    for(p = &_trace.buffers; *p != NULL; p = &(*p)->next){
+        if(*p == b){
+            *p = b->next;
+            free(b);
+            return;
+        }
+    }
+}
+
+static struct sensor_trace_buffer_s* _sensor_trace_buffer(void)
+{
+    struct sensor_trace_buffer_s* b = _buffer;
+    unsigned int generation = _trace.generation;
+
+    if(b != NULL && b->generation == generation)
+        return b;
+
+    // the ring of the previous trace is reused when it has the size asked for
+    if(b != NULL && b->size == _trace.size){
+        b->head = 0;
+        __sync_synchronize();
+        b->generation = generation;
+        return b;
+    }
+
+    pthread_once(&_trace_once, _sensor_trace_init);
+
+    pthread_mutex_lock(&_trace.lock);
+    if(b != NULL){
+        _sensor_trace_unlink(b);
+        _buffer = NULL;
+        pthread_setspecific(_trace.key, NULL);
+    }
+
+    b = (struct sensor_trace_buffer_s*)calloc(1, sizeof(struct sensor_trace_buffer_s) + _trace.size * sizeof(struct sensor_trace_event_s));
+    if(b != NULL){
+        b->tid = syscall(SYS_gettid);
+        b->generation = generation;
+        b->size = _trace.size;
+        b->next = _trace.buffers;
+        _trace.buffers = b;
+
+        _buffer = b;
+        pthread_setspecific(_trace.key, b);
+    }
+    pthread_mutex_unlock(&_trace.lock);
+
+    return b;
+}
+
+void _sensor_trace_add(int span, int type, unsigned long long begin, unsigned long long end)
+{
+    struct sensor_trace_buffer_s* b;
+    struct sensor_trace_event_s* e;
+    unsigned int position;
+
+    if(!_sensor_trace_on || begin == 0 || (b = _sensor_trace_buffer()) == NULL)
+        return;
+
+    position = b->head;
+    e = &b->event[position & (b->size - 1)];
+
+    e->position = 0;
+    __sync_synchronize();
+    e->span = span;
+    e->type = type;
+    e->begin = begin;
+    e->end = end;
+    __sync_synchronize();
+    e->position = position + 1;
+    b->head = position + 1;
+}
+
+int sensor_trace_start(unsigned int spans_per_thread)
+{
+    struct sensor_trace_buffer_s** p;
+    struct sensor_trace_buffer_s* b;
+
+    DEBUG_PRINT("sensor_trace_start");
+
+    if(spans_per_thread < 2 || (spans_per_thread & (spans_per_thread - 1)) != 0)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    _sensor_trace_on = 0;
+    __sync_synchronize();
+
+    // the spans of the exited threads belong to the previous trace
+    pthread_mutex_lock(&_trace.lock);
+    for(p = &_trace.buffers; (b = *p) != NULL; ){
+        if(b->exited){
+            *p = b->next;
+            free(b);
+        }
+        else
+            p = &b->next;
+    }
+    _trace.size = spans_per_thread;
+    __sync_fetch_and_add(&_trace.generation, 1);
+    pthread_mutex_unlock(&_trace.lock);
+
+    _sensor_trace_on = 1;
+
+    return SENSOR_ERROR_NONE;
+}
+
+int sensor_trace_stop(void)
+{
+    DEBUG_PRINT("sensor_trace_stop");
+
+    _sensor_trace_on = 0;
+    return SENSOR_ERROR_NONE;
+}
+
+int sensor_trace_export(const char *path)
+{
+    FILE* f;
+    struct sensor_trace_buffer_s* b;
+    int pid = getpid();
+    int first = 1;
+
+    DEBUG_PRINT("sensor_trace_export");
+
+    if(path == NULL)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    f = fopen(path, "w");
+    if(f == NULL)
+        RETURN_ERROR(SENSOR_ERROR_IO_ERROR);
+
+    fprintf(f, "{\"traceEvents\":[");
+
+    pthread_mutex_lock(&_trace.lock);
+    for(b = _trace.buffers; b != NULL; b = b->next){
+        unsigned int head = b->head, position;
+
+        if(b->generation != _trace.generation)
+            continue;
+
+        __sync_synchronize();
+        position = head > b->size ? head - b->size : 0;
+        for(; position != head; position++){
+            const struct sensor_trace_event_s* e = &b->event[position & (b->size - 1)];
+            struct sensor_trace_event_s copy;
+
+            copy.position = e->position;
+            __sync_synchronize();
+            copy.span = e->span;
+            copy.type = e->type;
+            copy.begin = e->begin;
+            copy.end = e->end;
+            __sync_synchronize();
+
+            // overwritten by its thread while read
+            if(copy.position != position + 1 || e->position != copy.position)
+                continue;
+
+            fprintf(f, "%s\n{\"name\":\"%s\",\"cat\":\"sensor\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f",
+                    first ? "" : ",", _SPAN_NAME[copy.span], pid, b->tid, copy.begin / 1000.0, (copy.end - copy.begin) / 1000.0);
+            if(copy.type >= 0 && copy.type < CB_NUMBERS)
+                fprintf(f, ",\"args\":{\"type\":\"%s\"}", _TYPE_NAME[copy.type]);
+            fprintf(f, "}");
+            first = 0;
+        }
+    }
+    pthread_mutex_unlock(&_trace.lock);
+
+    fprintf(f, "\n],\"displayTimeUnit\":\"ns\"}\n");
+
+    if(fclose(f) != 0)
+        RETURN_ERROR(SENSOR_ERROR_IO_ERROR);
+
+    return SENSOR_ERROR_NONE;
+}
@@ -0,0 +1,372 @@
+/*
+ * Copyright (c) 2011 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include <sensor_framework_private.h>
+#include <sensors.h>
+#include <sensor_private.h>
+
+// under this the gravity and the field are nearly parallel, or the device is in free fall
+#define MIN_EAST_NORM           0.1f
+
+// a proximity sensor without a known range reports 0 when near and 5 cm or more when far
+#define DEFAULT_FAR_CM          5.0f
+
+/*
+ * World Magnetic Model 2025, Schmidt semi-normalized Gauss coefficients in nT
+ * and their secular variation in nT per year, from the 2025.0 epoch. The
+ * secular variation is only valid for the WMM_YEARS of the model.
+ */
+#define WMM_DEGREE              12
+#define WMM_EPOCH               1735689600.0    // 2025-01-01 UTC
+#define WMM_YEARS               5
+#define WMM_REFERENCE_RADIUS_KM 6371.2
+#define WGS84_A_KM              6378.137
+#define WGS84_B_KM              6356.7523142
+
+static const float _WMM_G[WMM_DEGREE + 1][WMM_DEGREE + 1] = {
+    { 0.0f },
+    { -29351.8f, -1410.8f },
+    { -2556.6f, 2951.1f, 1649.3f },
+    { 1361.0f, -2404.1f, 1243.8f, 453.6f },
+    { 895.0f, 799.5f, 55.7f, -281.1f, 12.1f },
+    { -233.2f, 368.9f, 187.2f, -138.7f, -142.0f, 20.9f },
+    { 64.4f, 63.8f, 76.9f, -115.7f, -40.9f, 14.9f, -60.7f },
+    { 79.5f, -77.0f, -8.8f, 59.3f, 15.8f, 2.5f, -11.1f, 14.2f },
+    { 23.2f, 10.8f, -17.5f, 2.0f, -21.7f, 16.9f, 15.0f, -16.8f, 0.9f },
+    { 4.6f, 7.8f, 3.0f, -0.2f, -2.5f, -13.1f, 2.4f, 8.6f, -8.7f, -12.9f },
+    { -1.3f, -6.4f, 0.2f, 2.0f, -1.0f, -0.6f, -0.9f, 1.5f, 0.9f, -2.7f, -3.9f },
+    { 2.9f, -1.5f, -2.5f, 2.4f, -0.6f, -0.1f, -0.6f, -0.1f, 1.1f, -1.0f, -0.2f, 2.6f },
+    { -2.0f, -0.2f, 0.3f, 1.2f, -1.3f, 0.6f, 0.6f, 0.5f, -0.1f, -0.4f, -0.2f, -1.3f, -0.7f },
+};
+
+static const float _WMM_H[WMM_DEGREE + 1][WMM_DEGREE + 1] = {
+    { 0.0f },
+    { 0.0f, 4545.4f },
+    { 0.0f, -3133.6f, -815.1f },
+    { 0.0f, -56.6f, 237.5f, -549.5f },
+    { 0.0f, 278.6f, -133.9f, 212.0f, -375.6f },
+    { 0.0f, 45.4f, 220.2f, -122.9f, 43.0f, 106.1f },
+    { 0.0f, -18.4f, 16.8f, 48.8f, -59.8f, 10.9f, 72.7f },
+    { 0.0f, -48.9f, -14.4f, -1.0f, 23.4f, -7.4f, -25.1f, -2.3f },
+    { 0.0f, 7.1f, -12.6f, 11.4f, -9.7f, 12.7f, 0.7f, -5.2f, 3.9f },
+    { 0.0f, -24.8f, 12.2f, 8.3f, -3.3f, -5.2f, 7.2f, -0.6f, 0.8f, 10.0f },
+    { 0.0f, 3.3f, 0.0f, 2.4f, 5.3f, -9.1f, 0.4f, -4.2f, -3.8f, 0.9f, -9.1f },
+    { 0.0f, 0.0f, 2.9f, -0.6f, 0.2f, 0.5f, -0.3f, -1.2f, -1.7f, -2.9f, -1.8f, -2.3f },
+    { 0.0f, -1.3f, 0.7f, 1.0f, -1.4f, 0.0f, 0.6f, -0.1f, 0.8f, 0.1f, -1.0f, 0.1f, 0.2f },
+};
+
+static const float _WMM_DG[WMM_DEGREE + 1][WMM_DEGREE + 1] = {
+    { 0.0f },
+    { 12.0f, 9.7f },
+    { -11.6f, -5.2f, -8.0f },
+    { -1.3f, -4.2f, 0.4f, -15.6f },
+    { -1.6f, -2.4f, -6.0f, 5.6f, -7.0f },
+    { 0.6f, 1.4f, 0.0f, 0.6f, 2.2f, 0.9f },
+    { -0.2f, -0.4f, 0.9f, 1.2f, -0.9f, 0.3f, 0.9f },
+    { 0.0f, -0.1f, -0.1f, 0.5f, -0.1f, -0.8f, -0.8f, 0.8f },
+    { -0.1f, 0.2f, 0.0f, 0.5f, -0.1f, 0.3f, 0.2f, 0.0f, 0.2f },
+    { 0.0f, -0.1f, 0.1f, 0.3f, -0.3f, 0.0f, 0.3f, -0.1f, 0.1f, -0.1f },
+    { 0.1f, 0.0f, 0.1f, 0.1f, 0.0f, -0.3f, 0.0f, -0.1f, -0.1f, 0.0f, 0.0f },
+    { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, -0.1f, 0.0f, 0.0f, -0.1f, -0.1f, -0.1f, -0.1f },
+    { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.1f, 0.0f, 0.0f, 0.0f, -0.1f, 0.0f, -0.1f },
+};
+
+static const float _WMM_DH[WMM_DEGREE + 1][WMM_DEGREE + 1] = {
+    { 0.0f },
+    { 0.0f, -21.5f },
+    { 0.0f, -27.7f, -12.1f },
+    { 0.0f, 4.0f, -0.3f, -4.1f },
+    { 0.0f, -1.1f, 4.1f, 1.6f, -4.4f },
+    { 0.0f, -0.5f, 2.2f, 0.4f, 1.7f, 1.9f },
+    { 0.0f, 0.3f, -1.6f, -0.4f, 0.9f, 0.7f, 0.9f },
+    { 0.0f, 0.6f, 0.5f, -0.8f, 0.0f, -1.0f, 0.6f, -0.2f },
+    { 0.0f, -0.2f, 0.5f, -0.4f, 0.4f, -0.5f, -0.6f, 0.3f, 0.2f },
+    { 0.0f, -0.3f, 0.3f, -0.3f, 0.3f, 0.2f, -0.1f, -0.2f, 0.4f, 0.1f },
+    { 0.0f, 0.0f, 0.0f, -0.2f, 0.1f, -0.1f, 0.1f, 0.0f, -0.1f, 0.2f, 0.0f },
+    { 0.0f, 0.0f, 0.1f, 0.0f, 0.1f, 0.0f, 0.0f, 0.1f, 0.0f, 0.0f, 0.0f, 0.0f },
+    { 0.0f, 0.0f, 0.0f, -0.1f, 0.1f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, -0.1f },
+};
+
+int sensor_util_get_rotation_matrix(float Gx, float Gy, float Gz,
+        float Mx, float My, float Mz,
+        float R[], float I[])
+{
+    float Hx, Hy, Hz, Nx, Ny, Nz;
+    float norm_h, inv_a, inv_m;
+
+    // east is the field crossed with the up vector
+    Hx = My*Gz - Mz*Gy;
+    Hy = Mz*Gx - Mx*Gz;
+    Hz = Mx*Gy - My*Gx;
+    norm_h = sqrtf(Hx*Hx + Hy*Hy + Hz*Hz);
+    if(norm_h < MIN_EAST_NORM)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    Hx /= norm_h;
+    Hy /= norm_h;
+    Hz /= norm_h;
+
+    inv_a = 1.0f / sqrtf(Gx*Gx + Gy*Gy + Gz*Gz);
+    Gx *= inv_a;
+    Gy *= inv_a;
+    Gz *= inv_a;
+
+    // north completes the frame
+    Nx = Gy*Hz - Gz*Hy;
+    Ny = Gz*Hx - Gx*Hz;
+    Nz = Gx*Hy - Gy*Hx;
+
+    if(R != NULL){
+        R[0] = Hx; R[1] = Hy; R[2] = Hz;
+        R[3] = Nx; R[4] = Ny; R[5] = Nz;
+        R[6] = Gx; R[7] = Gy; R[8] = Gz;
+    }
+
+    if(I != NULL){
+        float c, s;
+
+        inv_m = 1.0f / sqrtf(Mx*Mx + My*My + Mz*Mz);
+        c = (Mx*Nx + My*Ny + Mz*Nz) * inv_m;
+        s = (Mx*Gx + My*Gy + Mz*Gz) * inv_m;
+
+        I[0] = 1; I[1] = 0; I[2] = 0;
+        I[3] = 0; I[4] = c; I[5] = s;
+        I[6] = 0; I[7] = -s; I[8] = c;
+    }
+
+    return SENSOR_ERROR_NONE;
+}
+
+int sensor_util_get_rotation_matrix_from_vector(float Vx, float Vy, float Vz, float R[])
+{
+    float q0, sq_x, sq_y, sq_z, xy, zw, xz, yw, yz, xw;
+
+    if(R == NULL)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    // the vector is the x, y, z of a unit quaternion
+    q0 = 1 - Vx*Vx - Vy*Vy - Vz*Vz;
+    q0 = q0 > 0 ? sqrtf(q0) : 0;
+
+    sq_x = 2 * Vx * Vx;
+    sq_y = 2 * Vy * Vy;
+    sq_z = 2 * Vz * Vz;
+    xy = 2 * Vx * Vy;
+    zw = 2 * Vz * q0;
+    xz = 2 * Vx * Vz;
+    yw = 2 * Vy * q0;
+    yz = 2 * Vy * Vz;
+    xw = 2 * Vx * q0;
+
+    R[0] = 1 - sq_y - sq_z;
+    R[1] = xy - zw;
+    R[2] = xz + yw;
+    R[3] = xy + zw;
+    R[4] = 1 - sq_x - sq_z;
+    R[5] = yz - xw;
+    R[6] = xz - yw;
+    R[7] = yz + xw;
+    R[8] = 1 - sq_x - sq_y;
+
+    return SENSOR_ERROR_NONE;
+}
+
+int sensor_util_remap_coordinate_system(float inR[], sensor_util_axis_e x, sensor_util_axis_e y, float outR[])
+{
+    float in[9];
+    int ax, ay, sx, sy, sz;
+    int i, j;
+
+    if(inR == NULL || outR == NULL)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+    if(x < sensor_util_axis_minus_x || x > sensor_util_axis_z || y < sensor_util_axis_minus_x || y > sensor_util_axis_z)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    ax = x % 3;
+    ay = y % 3;
+    if(ax == ay)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    sx = x < sensor_util_axis_x;
+    sy = y < sensor_util_axis_x;
+
+    // z = x cross y, negated when x, y, z are not in cyclic order, and once more per negated axis
+    sz = sx ^ sy ^ ((ax + 1) % 3 != ay);
+
+    memcpy(in, inR, sizeof(in));
+    for(j=0; j<3; j++){
+        for(i=0; i<3; i++){
+            if(i == ax)
+                outR[j*3 + i] = sx ? -in[j*3] : in[j*3];
+            else if(i == ay)
+                outR[j*3 + i] = sy ? -in[j*3 + 1] : in[j*3 + 1];
+            else
+                outR[j*3 + i] = sz ? -in[j*3 + 2] : in[j*3 + 2];
+        }
+    }
+
+    return SENSOR_ERROR_NONE;
+}
+
+int sensor_util_get_inclination(float I[], float* inclination)
+{
+    if(I == NULL || inclination == NULL)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    *inclination = atan2f(I[5], I[4]);
+    return SENSOR_ERROR_NONE;
+}
+
+int sensor_util_get_orientation(float R[], float values[])
+{
+    if(R == NULL || values == NULL)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    values[0] = atan2f(R[1], R[4]);
+    values[1] = asinf(-R[7]);
+    values[2] = atan2f(-R[6], R[8]);
+    return SENSOR_ERROR_NONE;
+}
+
+int sensor_util_get_angle_change(float R[], float prevR[], float angleChange[])
+{
+    float m01, m11, m20, m21, m22;
+
+    if(R == NULL || prevR == NULL || angleChange == NULL)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    // the orientation of transpose(prevR) * R, only the entries it needs
+    m01 = prevR[0]*R[1] + prevR[3]*R[4] + prevR[6]*R[7];
+    m11 = prevR[1]*R[1] + prevR[4]*R[4] + prevR[7]*R[7];
+    m20 = prevR[2]*R[0] + prevR[5]*R[3] + prevR[8]*R[6];
+    m21 = prevR[2]*R[1] + prevR[5]*R[4] + prevR[8]*R[7];
+    m22 = prevR[2]*R[2] + prevR[5]*R[5] + prevR[8]*R[8];
+
+    angleChange[0] = atan2f(m01, m11);
+    angleChange[1] = asinf(-m21);
+    angleChange[2] = atan2f(-m20, m22);
+    return SENSOR_ERROR_NONE;
+}
+
+int sensor_util_get_declination(float latitude, float longitude, float altitude, float* declination)
+{
+    double P[WMM_DEGREE + 1][WMM_DEGREE + 1], dP[WMM_DEGREE + 1][WMM_DEGREE + 1];
+    double schmidt[WMM_DEGREE + 1][WMM_DEGREE + 1];
+    double sin_m[WMM_DEGREE + 1], cos_m[WMM_DEGREE + 1];
+    double a2 = WGS84_A_KM * WGS84_A_KM, b2 = WGS84_B_KM * WGS84_B_KM;
+    double gd_lat, alt_km, clat, slat, rho, gc_lat, gc_lon, radius, ratio, power, years;
+    double ct, st, bx = 0, by = 0, bz = 0, diff, north;
+    int n, m;
+
+    if(declination == NULL || latitude < -90 || latitude > 90 || longitude < -180 || longitude > 180)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    // the east component has no meaning on the poles
+    if(latitude > 89.999f)
+        latitude = 89.999f;
+    if(latitude < -89.999f)
+        latitude = -89.999f;
+
+    // geodetic to geocentric spherical coordinates, altitude in meters
+    gd_lat = latitude * M_PI / 180;
+    alt_km = altitude / 1000.0;
+    clat = cos(gd_lat);
+    slat = sin(gd_lat);
+    rho = sqrt(a2*clat*clat + b2*slat*slat);
+    gc_lat = atan(slat / clat * (rho*alt_km + b2) / (rho*alt_km + a2));
+    gc_lon = longitude * M_PI / 180;
+    radius = sqrt(alt_km*alt_km + 2*alt_km*rho + (a2*a2*clat*clat + b2*b2*slat*slat) / (a2*clat*clat + b2*slat*slat));
+
+    // associated Legendre functions of the colatitude, and the Schmidt factors that normalize them
+    ct = sin(gc_lat);
+    st = cos(gc_lat);
+    P[0][0] = 1;
+    dP[0][0] = 0;
+    schmidt[0][0] = 1;
+    for(n=1; n<=WMM_DEGREE; n++){
+        schmidt[n][0] = schmidt[n-1][0] * (2*n - 1) / n;
+        for(m=0; m<=n; m++){
+            if(m > 0)
+                schmidt[n][m] = schmidt[n][m-1] * sqrt((double)(n - m + 1) * (m == 1 ? 2 : 1) / (n + m));
+
+            if(n == m){
+                P[n][m] = st * P[n-1][m-1];
+                dP[n][m] = ct * P[n-1][m-1] + st * dP[n-1][m-1];
+            }else if(n == 1 || m == n - 1){
+                P[n][m] = ct * P[n-1][m];
+                dP[n][m] = -st * P[n-1][m] + ct * dP[n-1][m];
+            }else{
+                double k = ((n-1)*(n-1) - m*m) / (double)((2*n - 1) * (2*n - 3));
+                P[n][m] = ct * P[n-1][m] - k * P[n-2][m];
+                dP[n][m] = -st * P[n-1][m] + ct * dP[n-1][m] - k * dP[n-2][m];
+            }
+        }
+    }
+
+    for(m=0; m<=WMM_DEGREE; m++){
+        sin_m[m] = sin(m * gc_lon);
+        cos_m[m] = cos(m * gc_lon);
+    }
+
+    years = (time(NULL) - WMM_EPOCH) / (365.25 * 86400);
+    if(years < 0)
+        years = 0;
+    if(years > WMM_YEARS)
+        years = WMM_YEARS;
+    ratio = WMM_REFERENCE_RADIUS_KM / radius;
+    power = ratio * ratio;
+    for(n=1; n<=WMM_DEGREE; n++){
+        power *= ratio;
+        for(m=0; m<=n; m++){
+            double g = (_WMM_G[n][m] + years * _WMM_DG[n][m]) * schmidt[n][m];
+            double h = (_WMM_H[n][m] + years * _WMM_DH[n][m]) * schmidt[n][m];
+
+            bx += power * (g*cos_m[m] + h*sin_m[m]) * dP[n][m];
+            by += power * m * (g*sin_m[m] - h*cos_m[m]) * P[n][m] / st;
+            bz -= (n + 1) * power * (g*cos_m[m] + h*sin_m[m]) * P[n][m];
+        }
+    }
+
+    // back to the geodetic frame, the east component is the same
+    diff = gd_lat - gc_lat;
+    north = bx * cos(diff) + bz * sin(diff);
+
+    *declination = atan2(by, north) * 180 / M_PI;
+    return SENSOR_ERROR_NONE;
+}
+
+int sensor_util_is_near(float distance, bool *is_near)
+{
+    sensor_data_properties_t properties;
+    float far = DEFAULT_FAR_CM;
+
+    if(is_near == NULL)
+        RETURN_ERROR(SENSOR_ERROR_INVALID_PARAMETER);
+
+    // most proximity sensors only report 0 and their range
+    if(_sensor_backend()->get_data_properties(PROXIMITY_DISTANCE_DATA_SET, &properties) == 0 && properties.sensor_max_range > 0)
+        far = properties.sensor_max_range;
+
+    *is_near = distance < far;
+    return SENSOR_ERROR_NONE;
+}
@@ -0,0 +1,283 @@
+/*
+ *
+ * Copyright (c) 2011 Samsung Electronics Co., Ltd All Rights Reserved
+ * PROPRIETARY/CONFIDENTIAL
+ *
+ * This software is the confidential and proprietary information of SAMSUNG
+ * ELECTRONICS ("Confidential Information"). You agree and acknowledge that
+ * this software is owned by Samsung and you shall not disclose such
+ * Confidential Information and shall use it only in accordance with the terms
+ * of the license agreement you entered into with SAMSUNG ELECTRONICS. SAMSUNG
+ * make no representations or warranties about the suitability of the software,
+ * either express or implied, including but not limited to the implied
+ * warranties of merchantability, fitness for a particular purpose, or
+ * non-infringement. SAMSUNG shall not be liable for any damages suffered by
+ * licensee arising out of or related to this software.
+ *
+ */
+
+/*
+ * Drives the callback path of the library through the mock backend and
+ * measures, for every sensor type and batch size:
+ *  - the dispatch cost of an event, from the backend call to the return of
+ *    the last callback, and its share per sample;
+ *  - the latency from the backend call to the first user callback;
+ *  - the throughput ceiling, events and samples per second back to back.
+ *
+ *   dispatch-benchmark [-t accelerometer,gyroscope,...] [-b 1,8,32] [-r rate_hz] [-n events] [-l label] [-j]
+ *
+ * With a rate the events are paced like a sensor, caches cool down between
+ * them. -j prints one JSON object per run, -l tags it, to compare versions.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sensors.h>
+
+#define WARMUP_EVENTS   1000
+#define BATCH_MAX       128
+
+static const struct {
+    const char *name;
+    sensor_type_e type;
+} types[] = {
+    { "accelerometer", SENSOR_ACCELEROMETER },
+    { "gyroscope", SENSOR_GYROSCOPE },
+    { "magnetic", SENSOR_MAGNETIC },
+    { "orientation", SENSOR_ORIENTATION },
+    { "light", SENSOR_LIGHT },
+    { "proximity", SENSOR_PROXIMITY },
+};
+
+struct result {
+    double mean;
+    double p50, p99, p999, max;
+};
+
+static unsigned long long first_callback_ns;
+
+static unsigned long long now_ns(void)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000000000ull + t.tv_nsec;
+}
+
+static void xyz_cb(unsigned long long timestamp, sensor_data_accuracy_e accuracy, float x, float y, float z, void *user_data)
+{
+    if(first_callback_ns == 0)
+        first_callback_ns = now_ns();
+}
+
+static void value_cb(unsigned long long timestamp, float value, void *user_data)
+{
+    if(first_callback_ns == 0)
+        first_callback_ns = now_ns();
+}
+
+static int set_cb(sensor_h handle, sensor_type_e type)
+{
+    switch(type){
+        case SENSOR_ACCELEROMETER:
+            return sensor_accelerometer_set_cb(handle, 10, xyz_cb, NULL);
+        case SENSOR_GYROSCOPE:
+            return sensor_gyroscope_set_cb(handle, 10, xyz_cb, NULL);
+        case SENSOR_MAGNETIC:
+            return sensor_magnetic_set_cb(handle, 10, xyz_cb, NULL);
+        case SENSOR_ORIENTATION:
+            return sensor_orientation_set_cb(handle, 10, xyz_cb, NULL);
+        case SENSOR_LIGHT:
+            return sensor_light_set_cb(handle, 10, value_cb, NULL);
+        case SENSOR_PROXIMITY:
+            return sensor_proximity_set_cb(handle, 10, value_cb, NULL);
+        default:
+            return -1;
+    }
+}
+
+static int compare(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+static struct result summarize(double *values, int n)
+{
+    struct result r;
+    double sum = 0;
+    int i;
+
+    for(i=0; i<n; i++)
+        sum += values[i];
+    qsort(values, n, sizeof(double), compare);
+
+    r.mean = sum / n;
+    r.p50 = values[n / 2];
+    r.p99 = values[(int)(n * 0.99)];
+    r.p999 = values[(int)(n * 0.999)];
+    r.max = values[n - 1];
+    return r;
+}
+
+// the samples of an event, values varying so nothing is constant folded
+static void fill(sensor_mock_sample_s *batch, int count, unsigned long long *timestamp)
+{
+    int i;
+
+    for(i=0; i<count; i++){
+        *timestamp += 5000;
+        batch[i].timestamp = *timestamp;
+        batch[i].accuracy = SENSOR_DATA_ACCURACY_GOOD;
+        batch[i].values_num = 3;
+        batch[i].values[0] = (*timestamp % 1000) * 0.001f;
+        batch[i].values[1] = 9.8f;
+        batch[i].values[2] = 0.1f;
+    }
+}
+
+static void run(sensor_type_e type, const char *name, int batch, int rate, int events, const char *label, int json)
+{
+    sensor_h handle;
+    sensor_mock_sample_s samples[BATCH_MAX];
+    double *cost = malloc(events * sizeof(double));
+    double *latency = malloc(events * sizeof(double));
+    unsigned long long timestamp = 1000000, begin, elapsed, next;
+    struct result c, l;
+    struct timespec at;
+    int i;
+
+    sensor_create(&handle);
+    if(set_cb(handle, type) != SENSOR_ERROR_NONE || sensor_start(handle, type) != SENSOR_ERROR_NONE){
+        printf("%s cannot be started\n", name);
+        sensor_destroy(handle);
+        free(cost);
+        free(latency);
+        return;
+    }
+
+    for(i=0; i<WARMUP_EVENTS; i++){
+        fill(samples, batch, &timestamp);
+        sensor_mock_emit_batch(type, samples, batch);
+    }
+
+    begin = next = now_ns();
+    for(i=0; i<events; i++){
+        unsigned long long t0, t1;
+
+        fill(samples, batch, &timestamp);
+
+        if(rate > 0){
+            next += 1000000000ull / rate;
+            at.tv_sec = next / 1000000000ull;
+            at.tv_nsec = next % 1000000000ull;
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &at, NULL);
+        }
+
+        first_callback_ns = 0;
+        t0 = now_ns();
+        sensor_mock_emit_batch(type, samples, batch);
+        t1 = now_ns();
+
+        cost[i] = t1 - t0;
+        latency[i] = (first_callback_ns != 0 ? first_callback_ns : t1) - t0;
+    }
+    elapsed = now_ns() - begin;
+
+    sensor_stop(handle, type);
+    sensor_destroy(handle);
+
+    c = summarize(cost, events);
+    l = summarize(latency, events);
+
+    if(json){
+        printf("{\"label\":\"%s\",\"type\":\"%s\",\"batch\":%d,\"rate_hz\":%d,\"events\":%d,"
+                "\"event_ns\":{\"mean\":%.1f,\"p50\":%.0f,\"p99\":%.0f,\"p999\":%.0f,\"max\":%.0f},"
+                "\"sample_ns\":%.1f,"
+                "\"latency_ns\":{\"mean\":%.1f,\"p50\":%.0f,\"p99\":%.0f,\"p999\":%.0f,\"max\":%.0f},"
+                "\"events_per_s\":%.0f,\"samples_per_s\":%.0f}\n",
+                label, name, batch, rate, events,
+                c.mean, c.p50, c.p99, c.p999, c.max, c.mean / batch,
+                l.mean, l.p50, l.p99, l.p999, l.max,
+                rate > 0 ? 1e9 / c.mean : events * 1e9 / elapsed, (rate > 0 ? 1e9 / c.mean : events * 1e9 / elapsed) * batch);
+    }else{
+        printf("%-14s %5d %6d %9.1f %7.0f %7.0f %7.0f %9.1f %7.0f %7.0f %7.0f %11.0f %11.0f\n",
+                name, batch, rate, c.mean, c.p50, c.p99, c.p999, c.mean / batch, l.p50, l.p99, l.p999,
+                rate > 0 ? 1e9 / c.mean : events * 1e9 / elapsed, (rate > 0 ? 1e9 / c.mean : events * 1e9 / elapsed) * batch);
+    }
+
+    free(cost);
+    free(latency);
+}
+
+int main(int argc, char *argv[])
+{
+    char type_list[256] = "accelerometer,gyroscope,magnetic,light";
+    char batch_list[256] = "1,8,32";
+    const char *label = "";
+    int rate = 0, events = 0, json = 0;
+    int opt, i;
+    char *t, *b, *save_t, *save_b;
+    unsigned long long clock_begin;
+    sensor_mock_spec_s spec = { "mock", "benchmark", -1000, 1000, 0.001, 0 };
+
+    while((opt = getopt(argc, argv, "t:b:r:n:l:j")) != -1){
+        switch(opt){
+            case 't': snprintf(type_list, sizeof(type_list), "%s", optarg); break;
+            case 'b': snprintf(batch_list, sizeof(batch_list), "%s", optarg); break;
+            case 'r': rate = atoi(optarg); break;
+            case 'n': events = atoi(optarg); break;
+            case 'l': label = optarg; break;
+            case 'j': json = 1; break;
+            default:
+                fprintf(stderr, "usage: %s [-t types] [-b batches] [-r rate_hz] [-n events] [-l label] [-j]\n", argv[0]);
+                return 1;
+        }
+    }
+    if(events <= 0)
+        events = rate > 0 ? 2000 : 100000;
+
+    sensor_mock_set(true);
+    for(i=0; i<(int)(sizeof(types)/sizeof(types[0])); i++)
+        sensor_mock_add(types[i].type, &spec);
+
+    clock_begin = now_ns();
+    for(i=0; i<1000; i++)
+        now_ns();
+
+    if(!json){
+        printf("clock_gettime %.1f ns, included in every figure\n\n", (now_ns() - clock_begin) / 1000.0);
+        printf("%-14s %5s %6s %9s %7s %7s %7s %9s %7s %7s %7s %11s %11s\n", "", "", "", "event ns", "", "", "", "sample ns",
+                "latency", "", "", "ceiling", "");
+        printf("%-14s %5s %6s %9s %7s %7s %7s %9s %7s %7s %7s %11s %11s\n", "type", "batch", "rate", "mean", "p50", "p99", "p999",
+                "mean", "p50", "p99", "p999", "events/s", "samples/s");
+    }
+
+    for(t = strtok_r(type_list, ",", &save_t); t != NULL; t = strtok_r(NULL, ",", &save_t)){
+        char batches[256];
+
+        for(i=0; i<(int)(sizeof(types)/sizeof(types[0])) && strcmp(types[i].name, t) != 0; i++)
+            ;
+        if(i == (int)(sizeof(types)/sizeof(types[0]))){
+            fprintf(stderr, "unknown type %s\n", t);
+            continue;
+        }
+
+        snprintf(batches, sizeof(batches), "%s", batch_list);
+        for(b = strtok_r(batches, ",", &save_b); b != NULL; b = strtok_r(NULL, ",", &save_b)){
+            int batch = atoi(b);
+
+            if(batch <= 0 || batch > BATCH_MAX){
+                fprintf(stderr, "batch %s out of 1..%d\n", b, BATCH_MAX);
+                continue;
+            }
+            run(types[i].type, types[i].name, batch, rate, events, label, json);
+        }
+    }
+
+    return 0;
+}
@@ -20,28 +20,35 @@
 #include <stdlib.h>
 #include <glib.h>
 #include <sensors.h>
-#include <time.h>
+#include <math.h>
 
-struct xyz_axis {
-    float x,y,z;
-};
-
-static struct xyz_axis angles = {0,0,0};
-static time_t timestamp = 0;
+#define RADIAN_VALUE (57.2957)
 
 static GMainLoop *mainloop;
+static sensor_gyro_integrator_h integrator;
 
-static void test_gyroscope_cb(sensor_data_accuracy_e accuracy, float x, float y, float z, void *user_data)
+static gboolean print_angles(gpointer user_data)
 {
-    time_t current_timestamp = time(0);
-    if(timestamp != 0){
-        const float dT = difftime(current_timestamp, timestamp);
-        angles.x += x * dT;
-        angles.y += y * dT;
-        angles.z += z * dT;
-        printf("angle x=%f y=%f z=%f\n", angles.x, angles.y, angles.z);
-    }
-    timestamp = current_timestamp;
+    float q[4];
+    float x, y, z, w, sinp;
+
+    if(sensor_gyro_integrator_get(integrator, q) != SENSOR_ERROR_NONE)
+        return TRUE;
+
+    x = q[0]; y = q[1]; z = q[2]; w = q[3];
+
+    // rounding puts it slightly past 1 at +-90 degrees of pitch
+    sinp = 2*(w*y - z*x);
+    if(sinp > 1)
+        sinp = 1;
+    else if(sinp < -1)
+        sinp = -1;
+
+    printf("angle x=%f y=%f z=%f\n",
+            atan2(2*(w*x + y*z), 1 - 2*(x*x + y*y)) * RADIAN_VALUE,
+            asin(sinp) * RADIAN_VALUE,
+            atan2(2*(w*z + x*y), 1 - 2*(y*y + z*z)) * RADIAN_VALUE);
+    return TRUE;
 }
 
 static void sig_quit(int signo)
@@ -83,7 +90,8 @@ int main(int argc, char *argv[])
 
 	sensor_create(&handle);
 
-    sensor_gyroscope_set_cb(handle, 0, test_gyroscope_cb, NULL);
+    sensor_gyro_integrator_create(handle, &integrator);
+    g_timeout_add(100, print_angles, NULL);
 
 	if(sensor_start(handle, type) == SENSOR_ERROR_NONE)
 		printf("Success start \n");
@@ -91,7 +99,7 @@ int main(int argc, char *argv[])
 	g_main_loop_run(mainloop);
 	g_main_loop_unref(mainloop);
 
-    sensor_gyroscope_unset_cb(handle);
+    sensor_gyro_integrator_destroy(integrator);
 
 	if(sensor_stop(handle, type) == SENSOR_ERROR_NONE)
 		printf("Success stop \n");
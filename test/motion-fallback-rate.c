@@ -0,0 +1,122 @@
+/*
+ *
+ * Copyright (c) 2011 Samsung Electronics Co., Ltd All Rights Reserved
+ * PROPRIETARY/CONFIDENTIAL
+ *
+ * This software is the confidential and proprietary information of SAMSUNG
+ * ELECTRONICS ("Confidential Information"). You agree and acknowledge that
+ * this software is owned by Samsung and you shall not disclose such
+ * Confidential Information and shall use it only in accordance with the terms
+ * of the license agreement you entered into with SAMSUNG ELECTRONICS. SAMSUNG
+ * make no representations or warranties about the suitability of the software,
+ * either express or implied, including but not limited to the implied
+ * warranties of merchantability, fitness for a particular purpose, or
+ * non-infringement. SAMSUNG shall not be liable for any damages suffered by
+ * licensee arising out of or related to this software.
+ *
+ */
+
+/*
+ * Checks that the gestures detected on the accelerometer keep their rate
+ * when the application reads the accelerometer much slower.
+ *
+ *   motion-fallback-rate
+ *
+ * The mock backend has no motion engine, so shake is detected in the
+ * library. The mock emits at the interval the library registered, the way
+ * a sensor server would, and the test fails when shake is not seen.
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include <sensors.h>
+
+#define USER_INTERVAL_MS    500
+#define SHAKE_HZ            4.0
+#define SHAKE_AMPLITUDE     20.0
+
+static int failed = 0;
+static int shakes = 0;
+
+static void test_accelerometer_cb(unsigned long long timestamp, sensor_data_accuracy_e accuracy, float x, float y, float z, void *user_data)
+{
+}
+
+static void test_shake_cb(unsigned long long timestamp, sensor_motion_shake_e shake, void *user_data)
+{
+    if(shake == SENSOR_MOTION_SHAKE_DETECTED)
+        shakes++;
+}
+
+static void check_interval(const char *what, int expected)
+{
+    int interval = -1;
+
+    sensor_mock_get_interval(SENSOR_ACCELEROMETER, &interval);
+    printf("%-36s %4d ms   %s\n", what, interval, interval == expected ? "PASS" : "FAIL");
+    if(interval != expected)
+        failed = 1;
+}
+
+// two seconds of shaking along x, sampled at the registered interval
+static void shake(void)
+{
+    unsigned long long t = 1000000ull, end = t + 2000000ull;
+    float v[3];
+    int interval;
+
+    while(t < end){
+        double s = (t - 1000000ull) / 1e6;
+
+        v[0] = SHAKE_AMPLITUDE * sin(2 * M_PI * SHAKE_HZ * s);
+        v[1] = 0;
+        v[2] = 9.80665;
+        sensor_mock_emit(SENSOR_ACCELEROMETER, t, SENSOR_DATA_ACCURACY_GOOD, v, 3);
+
+        if(sensor_mock_get_interval(SENSOR_ACCELEROMETER, &interval) != SENSOR_ERROR_NONE || interval <= 0)
+            interval = 100;
+        t += interval * 1000ull;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    sensor_mock_spec_s spec = { "mock", "accelerometer", -40, 40, 0.01, 0 };
+    sensor_h handle;
+
+    sensor_mock_set(true);
+    sensor_mock_add(SENSOR_ACCELEROMETER, &spec);
+    sensor_create(&handle);
+
+    sensor_accelerometer_set_cb(handle, USER_INTERVAL_MS, test_accelerometer_cb, NULL);
+    sensor_start(handle, SENSOR_ACCELEROMETER);
+    check_interval("user callback", USER_INTERVAL_MS);
+
+    sensor_motion_shake_set_cb(handle, test_shake_cb, NULL);
+    sensor_start(handle, SENSOR_MOTION_SHAKE);
+    check_interval("user callback + shake", 10);
+
+    // a later interval of the user does not slow the detection down
+    sensor_accelerometer_set_cb(handle, USER_INTERVAL_MS, test_accelerometer_cb, NULL);
+    check_interval("user callback set again", 10);
+
+    shake();
+    printf("%-36s %4d      %s\n", "shakes detected", shakes, shakes > 0 ? "PASS" : "FAIL");
+    if(shakes == 0)
+        failed = 1;
+
+    sensor_gyroscope_bias_compensation_set(handle, true);
+    sensor_motion_shake_unset_cb(handle);
+    check_interval("user callback + gyroscope bias", 20);
+
+    sensor_gyroscope_bias_compensation_set(handle, false);
+    check_interval("user callback alone", USER_INTERVAL_MS);
+
+    sensor_stop(handle, SENSOR_MOTION_SHAKE);
+    sensor_stop(handle, SENSOR_ACCELEROMETER);
+    sensor_accelerometer_unset_cb(handle);
+    sensor_destroy(handle);
+    sensor_mock_set(false);
+
+    return failed;
+}
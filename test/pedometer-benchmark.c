@@ -0,0 +1,172 @@
+/*
+ *
+ * Copyright (c) 2011 Samsung Electronics Co., Ltd All Rights Reserved
+ * PROPRIETARY/CONFIDENTIAL
+ *
+ * This software is the confidential and proprietary information of SAMSUNG
+ * ELECTRONICS ("Confidential Information"). You agree and acknowledge that
+ * this software is owned by Samsung and you shall not disclose such
+ * Confidential Information and shall use it only in accordance with the terms
+ * of the license agreement you entered into with SAMSUNG ELECTRONICS. SAMSUNG
+ * make no representations or warranties about the suitability of the software,
+ * either express or implied, including but not limited to the implied
+ * warranties of merchantability, fitness for a particular purpose, or
+ * non-infringement. SAMSUNG shall not be liable for any damages suffered by
+ * licensee arising out of or related to this software.
+ *
+ */
+
+/*
+ * Replays a recorded walk through the pedometer and reports the step
+ * accuracy and the CPU cost of the detection.
+ *
+ *   pedometer-benchmark                      synthetic walk with known steps
+ *   pedometer-benchmark walk.csv STEPS       recorded walk, one "timestamp_us,x,y,z" line per sample
+ *
+ * The samples are pushed through the mock backend, so the library dispatches
+ * them through its real callback path without a sensor server.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <sensors.h>
+
+#define SAMPLE_US   20000ull
+
+struct sample {
+    unsigned long long time_stamp;
+    float x, y, z;
+};
+
+static int detected = 0;
+
+static void test_pedometer_cb(unsigned long long timestamp, int steps, void *user_data)
+{
+    detected += steps;
+}
+
+static double frand(void)
+{
+    return rand() / (double)RAND_MAX - 0.5;
+}
+
+// walking and running segments separated by standing and fidgeting
+static int synthesize(struct sample **out, int *steps)
+{
+    static const struct { double seconds, cadence, amplitude; } plan[] = {
+        { 20, 0, 0 }, { 120, 1.8, 3.0 }, { 10, 0, 0 }, { 60, 2.8, 7.0 },
+        { 30, 0, 0.8 }, { 120, 1.6, 2.2 }, { 20, 0, 0 },
+    };
+    int i, n = 0, total = 0;
+    double t = 0;
+    struct sample *s;
+
+    for(i=0; i<(int)(sizeof(plan)/sizeof(plan[0])); i++)
+        total += plan[i].seconds * 1000000 / SAMPLE_US;
+
+    s = malloc(total * sizeof(struct sample));
+    *steps = 0;
+
+    for(i=0; i<(int)(sizeof(plan)/sizeof(plan[0])); i++){
+        int k, count = plan[i].seconds * 1000000 / SAMPLE_US;
+        double phase = 0;
+
+        for(k=0; k<count; k++, n++, t += SAMPLE_US / 1000000.0){
+            double vertical = 0;
+
+            if(plan[i].cadence > 0){
+                phase += 2 * M_PI * plan[i].cadence * SAMPLE_US / 1000000.0;
+                vertical = plan[i].amplitude * (sin(phase) + 0.3 * sin(2 * phase + 0.5));
+            }else{
+                vertical = plan[i].amplitude * frand();
+            }
+
+            s[n].time_stamp = 1000000ull + n * SAMPLE_US;
+            s[n].x = 0.4 * frand() + 0.5 * vertical * 0.3;
+            s[n].y = 9.80665 + vertical + 0.3 * frand();
+            s[n].z = 1.2 + 0.4 * frand();
+        }
+        *steps += (int)(plan[i].cadence * plan[i].seconds);
+    }
+
+    *out = s;
+    return n;
+}
+
+static int load(const char *path, struct sample **out)
+{
+    FILE *f = fopen(path, "r");
+    int n = 0, capacity = 4096;
+    struct sample *s;
+
+    if(f == NULL)
+        return -1;
+
+    s = malloc(capacity * sizeof(struct sample));
+    while(fscanf(f, "%llu,%f,%f,%f", &s[n].time_stamp, &s[n].x, &s[n].y, &s[n].z) == 4){
+        if(++n == capacity){
+            capacity *= 2;
+            s = realloc(s, capacity * sizeof(struct sample));
+        }
+    }
+    fclose(f);
+
+    *out = s;
+    return n;
+}
+
+int main(int argc, char *argv[])
+{
+    int i, n, expected;
+    double cpu_ns, duration_s;
+    struct timespec begin, end;
+    struct sample *samples;
+    float values[3];
+    sensor_h handle;
+    sensor_mock_spec_s spec = { "mock", "accelerometer", -19.6, 19.6, 0.01, 10 };
+
+    if(argc >= 3){
+        n = load(argv[1], &samples);
+        expected = atoi(argv[2]);
+    }else{
+        n = synthesize(&samples, &expected);
+    }
+    if(n < 2){
+        printf("no samples\n");
+        return 1;
+    }
+
+    sensor_mock_set(true);
+    sensor_mock_add(SENSOR_ACCELEROMETER, &spec);
+
+    sensor_create(&handle);
+    sensor_pedometer_set_cb(handle, test_pedometer_cb, NULL);
+    sensor_start(handle, SENSOR_PEDOMETER);
+
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &begin);
+    for(i=0; i<n; i++){
+        values[0] = samples[i].x;
+        values[1] = samples[i].y;
+        values[2] = samples[i].z;
+        sensor_mock_emit(SENSOR_ACCELEROMETER, samples[i].time_stamp, SENSOR_DATA_ACCURACY_GOOD, values, 3);
+    }
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &end);
+
+    cpu_ns = (end.tv_sec - begin.tv_sec) * 1e9 + (end.tv_nsec - begin.tv_nsec);
+    duration_s = (samples[n-1].time_stamp - samples[0].time_stamp) / 1e6;
+
+    printf("samples          %d (%.1f s at %.1f Hz)\n", n, duration_s, (n - 1) / duration_s);
+    printf("steps            %d detected / %d expected\n", detected, expected);
+    printf("accuracy         %.2f %%\n", 100.0 * (1.0 - abs(detected - expected) / (double)expected));
+    printf("cpu per sample   %.1f ns\n", cpu_ns / n);
+    printf("cpu per hour     %.3f ms\n", cpu_ns / 1e6 * (3600.0 / duration_s));
+
+    sensor_pedometer_unset_cb(handle);
+    sensor_stop(handle, SENSOR_PEDOMETER);
+    sensor_destroy(handle);
+    free(samples);
+    return 0;
+}
@@ -0,0 +1,267 @@
+/*
+ *
+ * Copyright (c) 2011 Samsung Electronics Co., Ltd All Rights Reserved
+ * PROPRIETARY/CONFIDENTIAL
+ *
+ * This software is the confidential and proprietary information of SAMSUNG
+ * ELECTRONICS ("Confidential Information"). You agree and acknowledge that
+ * this software is owned by Samsung and you shall not disclose such
+ * Confidential Information and shall use it only in accordance with the terms
+ * of the license agreement you entered into with SAMSUNG ELECTRONICS. SAMSUNG
+ * make no representations or warranties about the suitability of the software,
+ * either express or implied, including but not limited to the implied
+ * warranties of merchantability, fitness for a particular purpose, or
+ * non-infringement. SAMSUNG shall not be liable for any damages suffered by
+ * licensee arising out of or related to this software.
+ *
+ */
+
+/*
+ * Training run of a -DSENSOR_PGO=generate build: replays recordings through
+ * the callback path of the library, the way an application receives them.
+ *
+ *   pgo-train [-r repeat] [recording ...]
+ *
+ * Without a recording, a synthetic capture of a handheld device is recorded
+ * on the mock backend first, then replayed. Every recording is replayed as
+ * fast as possible, 20 times by default, with the callbacks of every data
+ * type set.
+ *
+ * The replay delivers one sample per event. Sensor hubs deliver their FIFO
+ * in batches, so every round also emits the synthetic motion on the mock in
+ * batches of the usual FIFO sizes, to per-sample and to batch callbacks.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <sensors.h>
+
+#define SYNTHETIC_SECONDS   60
+#define SYNTHETIC_HZ        100
+#define SYNTHETIC_PATH      "/tmp/capi-sensor-pgo.rec"
+#define SYNTHETIC_SAMPLES   (SYNTHETIC_SECONDS * SYNTHETIC_HZ)
+
+static const int fifo_sizes[] = { 1, 8, 32, 64 };
+
+#define FIFOS       ((int)(sizeof(fifo_sizes) / sizeof(fifo_sizes[0])))
+#define FIFO_MAX    64
+
+static const sensor_type_e types[] = {
+    SENSOR_ACCELEROMETER, SENSOR_MAGNETIC, SENSOR_GYROSCOPE, SENSOR_LIGHT, SENSOR_PROXIMITY,
+};
+
+#define TYPES ((int)(sizeof(types) / sizeof(types[0])))
+
+// the streams of the handheld motion
+static const sensor_type_e motion_types[] = {
+    SENSOR_ACCELEROMETER, SENSOR_MAGNETIC, SENSOR_GYROSCOPE,
+};
+
+#define MOTION_TYPES ((int)(sizeof(motion_types) / sizeof(motion_types[0])))
+
+static volatile float sink;
+static unsigned long long delivered;
+
+static void xyz_cb(unsigned long long timestamp, sensor_data_accuracy_e accuracy, float x, float y, float z, void *user_data)
+{
+    sink += x + y + z;
+    delivered++;
+}
+
+static void value_cb(unsigned long long timestamp, float value, void *user_data)
+{
+    sink += value;
+    delivered++;
+}
+
+static void batch_cb(sensor_type_e type, const sensor_sample_s *samples, int count, void *user_data)
+{
+    int i;
+
+    for(i=0; i<count; i++)
+        sink += samples[i].values[0] + samples[i].values[1] + samples[i].values[2];
+    delivered += count;
+}
+
+static void set_callbacks(sensor_h handle)
+{
+    int i;
+
+    sensor_accelerometer_set_cb(handle, 10, xyz_cb, NULL);
+    sensor_magnetic_set_cb(handle, 10, xyz_cb, NULL);
+    sensor_gyroscope_set_cb(handle, 10, xyz_cb, NULL);
+    sensor_light_set_cb(handle, 100, value_cb, NULL);
+    sensor_proximity_set_cb(handle, 100, value_cb, NULL);
+
+    for(i=0; i<TYPES; i++)
+        sensor_start(handle, types[i]);
+}
+
+static void mock_sensors(void)
+{
+    sensor_mock_spec_s spec = { "mock", "pgo", -2000, 2000, 0.01, 0 };
+    int k;
+
+    sensor_mock_set(true);
+    for(k=0; k<TYPES; k++)
+        sensor_mock_add(types[k], &spec);
+}
+
+static unsigned long long time_stamp(int i)
+{
+    return 1000000ull + i * (1000000ull / SYNTHETIC_HZ);
+}
+
+// sample i of a phone held in the hand and turned around now and then, in the order of motion_types
+static void motion(int i, float v[MOTION_TYPES][3])
+{
+    double s = (double)i / SYNTHETIC_HZ;
+    double pitch = 0.8 + 0.3 * sin(0.5 * s), roll = 0.2 * sin(1.3 * s) + (fmod(s, 20) > 15 ? 1.5 : 0);
+
+    v[0][0] = -9.80665 * cos(pitch) * sin(roll) + 0.05 * sin(17 * s);
+    v[0][1] = 9.80665 * sin(pitch);
+    v[0][2] = 9.80665 * cos(pitch) * cos(roll) + 0.05 * cos(23 * s);
+
+    v[1][0] = 20 * cos(0.1 * s); v[1][1] = 20 * sin(0.1 * s); v[1][2] = -40;
+
+    v[2][0] = 0.3 * cos(0.5 * s); v[2][1] = 0.26 * cos(1.3 * s); v[2][2] = 0.02;
+}
+
+static int synthesize(const char *path)
+{
+    sensor_h handle;
+    float m[MOTION_TYPES][3], v[3];
+    unsigned long long t;
+    int i, k, err;
+
+    mock_sensors();
+    sensor_create(&handle);
+    set_callbacks(handle);
+    if( (err = sensor_record_start(handle, path, types, TYPES, 4096)) != SENSOR_ERROR_NONE){
+        sensor_destroy(handle);
+        return err;
+    }
+
+    for(i=0; i<SYNTHETIC_SAMPLES; i++){
+        double s = (double)i / SYNTHETIC_HZ;
+
+        t = time_stamp(i);
+        motion(i, m);
+        for(k=0; k<MOTION_TYPES; k++)
+            sensor_mock_emit(motion_types[k], t, SENSOR_DATA_ACCURACY_GOOD, m[k], 3);
+
+        if(i % 10 == 0){
+            v[0] = 300 + 200 * sin(0.05 * s);
+            sensor_mock_emit(SENSOR_LIGHT, t, SENSOR_DATA_ACCURACY_GOOD, v, 1);
+            v[0] = fmod(s, 30) > 25 ? 0 : 5;
+            sensor_mock_emit(SENSOR_PROXIMITY, t, SENSOR_DATA_ACCURACY_GOOD, v, 1);
+        }
+    }
+
+    sensor_record_stop(handle);
+    sensor_destroy(handle);
+    sensor_mock_set(false);
+
+    return SENSOR_ERROR_NONE;
+}
+
+// the handheld motion in FIFO batches, to per-sample callbacks then to batch callbacks
+static void emit_batches(void)
+{
+    static sensor_mock_sample_s batch[MOTION_TYPES][FIFO_MAX];
+    float m[MOTION_TYPES][3];
+    sensor_h handle;
+    int batched, f, i, j, k, n;
+
+    mock_sensors();
+    sensor_create(&handle);
+    set_callbacks(handle);
+
+    for(batched=0; batched<2; batched++){
+        if(batched){
+            for(k=0; k<MOTION_TYPES; k++)
+                sensor_batch_set_cb(handle, motion_types[k], 10, batch_cb, NULL);
+        }
+
+        for(f=0; f<FIFOS; f++){
+            for(i=0; i<SYNTHETIC_SAMPLES; i+=n){
+                n = SYNTHETIC_SAMPLES - i < fifo_sizes[f] ? SYNTHETIC_SAMPLES - i : fifo_sizes[f];
+                for(j=0; j<n; j++){
+                    motion(i + j, m);
+                    for(k=0; k<MOTION_TYPES; k++){
+                        batch[k][j].timestamp = time_stamp(i + j);
+                        batch[k][j].accuracy = SENSOR_DATA_ACCURACY_GOOD;
+                        batch[k][j].values_num = 3;
+                        memcpy(batch[k][j].values, m[k], sizeof(m[k]));
+                    }
+                }
+                for(k=0; k<MOTION_TYPES; k++)
+                    sensor_mock_emit_batch(motion_types[k], batch[k], n);
+            }
+        }
+    }
+
+    sensor_destroy(handle);
+    sensor_mock_set(false);
+}
+
+static int replay(const char *path)
+{
+    sensor_h handle;
+    int err;
+
+    if( (err = sensor_replay_set(path, 0)) != SENSOR_ERROR_NONE)
+        return err;
+
+    sensor_create(&handle);
+    set_callbacks(handle);
+    err = sensor_replay_wait();
+    sensor_destroy(handle);
+
+    sensor_replay_set(NULL, 0);
+    return err;
+}
+
+int main(int argc, char *argv[])
+{
+    static const char *synthetic[] = { SYNTHETIC_PATH };
+    const char **paths;
+    int repeat = 20;
+    int opt, i, r, count;
+
+    while((opt = getopt(argc, argv, "r:")) != -1){
+        switch(opt){
+            case 'r': repeat = atoi(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-r repeat] [recording ...]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    paths = (const char **)argv + optind;
+    count = argc - optind;
+    if(count == 0){
+        if(synthesize(synthetic[0]) != SENSOR_ERROR_NONE){
+            fprintf(stderr, "cannot record %s\n", synthetic[0]);
+            return 1;
+        }
+        paths = synthetic;
+        count = 1;
+    }
+
+    for(r=0; r<repeat; r++){
+        for(i=0; i<count; i++){
+            if(replay(paths[i]) != SENSOR_ERROR_NONE){
+                fprintf(stderr, "cannot replay %s\n", paths[i]);
+                return 1;
+            }
+        }
+        emit_batches();
+    }
+
+    printf("%llu samples delivered\n", delivered);
+    return 0;
+}
@@ -0,0 +1,249 @@
+/*
+ *
+ * Copyright (c) 2011 Samsung Electronics Co., Ltd All Rights Reserved
+ * PROPRIETARY/CONFIDENTIAL
+ *
+ * This software is the confidential and proprietary information of SAMSUNG
+ * ELECTRONICS ("Confidential Information"). You agree and acknowledge that
+ * this software is owned by Samsung and you shall not disclose such
+ * Confidential Information and shall use it only in accordance with the terms
+ * of the license agreement you entered into with SAMSUNG ELECTRONICS. SAMSUNG
+ * make no representations or warranties about the suitability of the software,
+ * either express or implied, including but not limited to the implied
+ * warranties of merchantability, fitness for a particular purpose, or
+ * non-infringement. SAMSUNG shall not be liable for any damages suffered by
+ * licensee arising out of or related to this software.
+ *
+ */
+
+/*
+ * Records an accelerometer and gyroscope capture in the raw and the
+ * compressed encodings, and reports the size of the files and the
+ * encoding and decoding throughput, in MB of 24 byte raw records per second.
+ *
+ *   record-benchmark                 synthetic walk, 30 minutes at 100 Hz
+ *   record-benchmark imu.csv         recorded capture, one "timestamp_us,ax,ay,az,gx,gy,gz" line per sample
+ *
+ * The samples go through the mock backend and the real callback path of the
+ * library, the encoding cost is the difference with a run without recording.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sensors.h>
+
+#define SAMPLE_US       10000ull
+#define ACCEL_LSB       (2 * 2 * 9.80665 / 65536)   // 16 bits over +-2 g
+#define GYRO_LSB        (2 * 2000.0 / 65536)        // 16 bits over +-2000 degrees/s
+#define RAW_RECORD      24
+
+struct sample {
+    unsigned long long time_stamp;
+    float accel[3];
+    float gyro[3];
+};
+
+static struct sample *samples;
+static int sample_count;
+
+struct check {
+    int index[2];
+    double max_error[2];
+    int count;
+};
+
+static void accel_cb(unsigned long long timestamp, sensor_data_accuracy_e accuracy, float x, float y, float z, void *user_data)
+{
+}
+
+static void gyro_cb(unsigned long long timestamp, sensor_data_accuracy_e accuracy, float x, float y, float z, void *user_data)
+{
+}
+
+static double frand(void)
+{
+    return rand() / (double)RAND_MAX - 0.5;
+}
+
+static float quantize(double value, double lsb)
+{
+    return (float)(lrint(value / lsb) * lsb);
+}
+
+// walking with the sensor noise and the time stamp jitter of a phone IMU, on its ADC steps
+static int synthesize(struct sample **out)
+{
+    int i, n = 30 * 60 * 1000000ull / SAMPLE_US;
+    struct sample *s = malloc(n * sizeof(struct sample));
+
+    for(i=0; i<n; i++){
+        double t = i * SAMPLE_US / 1000000.0;
+        double walk = (fmod(t, 300) < 200) ? 1.0 : 0.0;
+        double phase = 2 * M_PI * 1.8 * t;
+
+        s[i].time_stamp = 1000000ull + i * SAMPLE_US + (long long)(frand() * 200);
+        s[i].accel[0] = quantize(walk * 0.8 * sin(phase / 2) + 0.02 * frand(), ACCEL_LSB);
+        s[i].accel[1] = quantize(9.80665 + walk * 2.5 * sin(phase) + 0.02 * frand(), ACCEL_LSB);
+        s[i].accel[2] = quantize(1.2 + walk * 0.6 * sin(phase + 1) + 0.02 * frand(), ACCEL_LSB);
+        s[i].gyro[0] = quantize(walk * 25 * sin(phase + 0.3) + 0.3 * frand(), GYRO_LSB);
+        s[i].gyro[1] = quantize(walk * 40 * sin(phase / 2) + 0.3 * frand(), GYRO_LSB);
+        s[i].gyro[2] = quantize(walk * 10 * sin(phase + 2) + 0.3 * frand(), GYRO_LSB);
+    }
+
+    *out = s;
+    return n;
+}
+
+static int load(const char *path, struct sample **out)
+{
+    FILE *f = fopen(path, "r");
+    int n = 0, capacity = 4096;
+    struct sample *s;
+
+    if(f == NULL)
+        return -1;
+
+    s = malloc(capacity * sizeof(struct sample));
+    while(fscanf(f, "%llu,%f,%f,%f,%f,%f,%f", &s[n].time_stamp, &s[n].accel[0], &s[n].accel[1], &s[n].accel[2],
+                &s[n].gyro[0], &s[n].gyro[1], &s[n].gyro[2]) == 7){
+        if(++n == capacity){
+            capacity *= 2;
+            s = realloc(s, capacity * sizeof(struct sample));
+        }
+    }
+    fclose(f);
+
+    *out = s;
+    return n;
+}
+
+static double cpu_ns(void)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &t);
+    return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+static double emit_all(sensor_h handle, const char *path, sensor_record_format_e format)
+{
+    static const sensor_type_e types[] = { SENSOR_ACCELEROMETER, SENSOR_GYROSCOPE };
+    int i;
+    double begin;
+
+    if(path != NULL){
+        sensor_record_set_format(handle, format);
+        sensor_record_start(handle, path, types, 2, (sample_count * 2 * RAW_RECORD) / 1024 + 64);
+    }
+
+    begin = cpu_ns();
+    for(i=0; i<sample_count; i++){
+        sensor_mock_emit(SENSOR_ACCELEROMETER, samples[i].time_stamp, SENSOR_DATA_ACCURACY_GOOD, samples[i].accel, 3);
+        sensor_mock_emit(SENSOR_GYROSCOPE, samples[i].time_stamp, SENSOR_DATA_ACCURACY_GOOD, samples[i].gyro, 3);
+    }
+    begin = cpu_ns() - begin;
+
+    if(path != NULL)
+        sensor_record_stop(handle);
+    return begin;
+}
+
+static bool count_cb(sensor_type_e type, unsigned long long timestamp, sensor_data_accuracy_e accuracy, const float values[3], void *user_data)
+{
+    (*(int *)user_data)++;
+    return true;
+}
+
+static bool check_cb(sensor_type_e type, unsigned long long timestamp, sensor_data_accuracy_e accuracy, const float values[3], void *user_data)
+{
+    struct check *c = user_data;
+    int k = type == SENSOR_GYROSCOPE;
+    const struct sample *s = &samples[c->index[k]++];
+    const float *expected = k ? s->gyro : s->accel;
+    int i;
+
+    if(timestamp != s->time_stamp)
+        c->max_error[k] = INFINITY;
+    for(i=0; i<3; i++){
+        if(fabs(values[i] - expected[i]) > c->max_error[k])
+            c->max_error[k] = fabs(values[i] - expected[i]);
+    }
+    c->count++;
+    return true;
+}
+
+static void report(const char *name, const char *path, double encode_ns, double raw_mb)
+{
+    struct stat st;
+    struct check c;
+    int count = 0;
+    double decode_ns;
+
+    decode_ns = cpu_ns();
+    sensor_record_foreach_sample(path, count_cb, &count);
+    decode_ns = cpu_ns() - decode_ns;
+
+    memset(&c, 0, sizeof(c));
+    sensor_record_foreach_sample(path, check_cb, &c);
+    stat(path, &st);
+
+    printf("%-11s %9.2f MB %7.2f B/sample %9.1f MB/s encode %9.1f MB/s decode   max error %.2g / %.2g   samples %d\n",
+            name, st.st_size / 1e6, (double)st.st_size / count, raw_mb / (encode_ns / 1e9), raw_mb / (decode_ns / 1e9),
+            c.max_error[0], c.max_error[1], c.count);
+}
+
+int main(int argc, char *argv[])
+{
+    sensor_h handle;
+    double base_ns, raw_ns, compressed_ns, raw_mb;
+    struct stat raw_st, compressed_st;
+    sensor_mock_spec_s accel = { "mock", "accelerometer", -2 * 9.80665, 2 * 9.80665, ACCEL_LSB, 5 };
+    sensor_mock_spec_s gyro = { "mock", "gyroscope", -2000, 2000, GYRO_LSB, 5 };
+    const char *raw_path = "/tmp/record-benchmark.raw";
+    const char *compressed_path = "/tmp/record-benchmark.compressed";
+
+    sample_count = argc >= 2 ? load(argv[1], &samples) : synthesize(&samples);
+    if(sample_count < 2){
+        printf("no samples\n");
+        return 1;
+    }
+
+    sensor_mock_set(true);
+    sensor_mock_add(SENSOR_ACCELEROMETER, &accel);
+    sensor_mock_add(SENSOR_GYROSCOPE, &gyro);
+
+    sensor_create(&handle);
+    sensor_accelerometer_set_cb(handle, 10, accel_cb, NULL);
+    sensor_gyroscope_set_cb(handle, 10, gyro_cb, NULL);
+    sensor_start(handle, SENSOR_ACCELEROMETER);
+    sensor_start(handle, SENSOR_GYROSCOPE);
+
+    // the first run warms the caches up
+    emit_all(handle, NULL, SENSOR_RECORD_FORMAT_RAW);
+    base_ns = emit_all(handle, NULL, SENSOR_RECORD_FORMAT_RAW);
+    raw_ns = emit_all(handle, raw_path, SENSOR_RECORD_FORMAT_RAW) - base_ns;
+    compressed_ns = emit_all(handle, compressed_path, SENSOR_RECORD_FORMAT_COMPRESSED) - base_ns;
+    raw_mb = sample_count * 2.0 * RAW_RECORD / 1e6;
+
+    printf("samples     %d x 2 (%.1f s), dispatch without recording %.1f ns/sample\n",
+            sample_count, (samples[sample_count-1].time_stamp - samples[0].time_stamp) / 1e6, base_ns / (sample_count * 2));
+    report("raw", raw_path, raw_ns, raw_mb);
+    report("compressed", compressed_path, compressed_ns, raw_mb);
+
+    stat(raw_path, &raw_st);
+    stat(compressed_path, &compressed_st);
+    printf("ratio       %.2f\n", (double)raw_st.st_size / compressed_st.st_size);
+
+    sensor_stop(handle, SENSOR_ACCELEROMETER);
+    sensor_stop(handle, SENSOR_GYROSCOPE);
+    sensor_destroy(handle);
+    unlink(raw_path);
+    unlink(compressed_path);
+    free(samples);
+    return 0;
+}
@@ -0,0 +1,339 @@
+/*
+ *
+ * Copyright (c) 2011 Samsung Electronics Co., Ltd All Rights Reserved
+ * PROPRIETARY/CONFIDENTIAL
+ *
+ * This software is the confidential and proprietary information of SAMSUNG
+ * ELECTRONICS ("Confidential Information"). You agree and acknowledge that
+ * this software is owned by Samsung and you shall not disclose such
+ * Confidential Information and shall use it only in accordance with the terms
+ * of the license agreement you entered into with SAMSUNG ELECTRONICS. SAMSUNG
+ * make no representations or warranties about the suitability of the software,
+ * either express or implied, including but not limited to the implied
+ * warranties of merchantability, fitness for a particular purpose, or
+ * non-infringement. SAMSUNG shall not be liable for any damages suffered by
+ * licensee arising out of or related to this software.
+ *
+ */
+
+/*
+ * Grows the number of handles on the mock backend and measures, for each count:
+ *  - the cost of creating a handle with an accelerometer and a gyroscope
+ *    subscription, started, and the heap it takes;
+ *  - the dispatch of an accelerometer event fanned out to every handle: its
+ *    cost, its cost per callback, and the latency to the first and the last
+ *    callback;
+ *  - the throughput of set_cb/unset_cb/start/stop churned from the threads,
+ *    and the dispatch cost meanwhile;
+ *  - the cost of destroying a handle, and the heap not given back.
+ *
+ *   stress-benchmark [-n 1,10,100,500] [-T threads] [-e events] [-d churn_ms] [-l label] [-j]
+ *
+ * The handles are split between the threads, each creates, churns and
+ * destroys its own, the events are emitted from the main thread. Operations
+ * that fail are counted, a table of the backend running out shows there.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <sensors.h>
+
+#define THREADS_MAX     64
+
+struct worker {
+    pthread_t thread;
+    sensor_h *handles;
+    int count;
+    unsigned long long ops;
+    unsigned long long failures;
+};
+
+struct result {
+    double p50, p99, max;
+};
+
+static volatile int churning;
+static int callbacks;
+static unsigned long long first_callback_ns, last_callback_ns;
+
+static unsigned long long now_ns(void)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000000000ull + t.tv_nsec;
+}
+
+// in use in all the arenas
+static long long heap_bytes(void)
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+    return mallinfo2().uordblks;
+#else
+    return mallinfo().uordblks;
+#endif
+}
+
+static void accelerometer_cb(unsigned long long timestamp, sensor_data_accuracy_e accuracy, float x, float y, float z, void *user_data)
+{
+    last_callback_ns = now_ns();
+    if(callbacks++ == 0)
+        first_callback_ns = last_callback_ns;
+}
+
+static void gyroscope_cb(unsigned long long timestamp, sensor_data_accuracy_e accuracy, float x, float y, float z, void *user_data)
+{
+}
+
+static void count(struct worker *w, int err)
+{
+    w->ops++;
+    if(err != SENSOR_ERROR_NONE)
+        w->failures++;
+}
+
+static void *create_all(void *arg)
+{
+    struct worker *w = arg;
+    int i;
+
+    for(i=0; i<w->count; i++){
+        count(w, sensor_create(&w->handles[i]));
+        count(w, sensor_accelerometer_set_cb(w->handles[i], 10, accelerometer_cb, NULL));
+        count(w, sensor_gyroscope_set_cb(w->handles[i], 10, gyroscope_cb, NULL));
+        count(w, sensor_start(w->handles[i], SENSOR_ACCELEROMETER));
+        count(w, sensor_start(w->handles[i], SENSOR_GYROSCOPE));
+    }
+    return NULL;
+}
+
+// every subscription is torn down and set up again, the handles stay started
+static void *churn(void *arg)
+{
+    struct worker *w = arg;
+    int i;
+
+    while(churning){
+        for(i=0; i<w->count && churning; i++){
+            count(w, sensor_accelerometer_unset_cb(w->handles[i]));
+            count(w, sensor_accelerometer_set_cb(w->handles[i], 10, accelerometer_cb, NULL));
+            count(w, sensor_stop(w->handles[i], SENSOR_GYROSCOPE));
+            count(w, sensor_start(w->handles[i], SENSOR_GYROSCOPE));
+        }
+    }
+    return NULL;
+}
+
+static void *destroy_all(void *arg)
+{
+    struct worker *w = arg;
+    int i;
+
+    for(i=0; i<w->count; i++)
+        count(w, sensor_destroy(w->handles[i]));
+    return NULL;
+}
+
+// wall time of a phase run by every worker
+static double run_workers(struct worker *workers, int threads, void *(*phase)(void *))
+{
+    unsigned long long begin = now_ns();
+    int i;
+
+    for(i=0; i<threads; i++){
+        workers[i].ops = 0;
+        pthread_create(&workers[i].thread, NULL, phase, &workers[i]);
+    }
+    for(i=0; i<threads; i++)
+        pthread_join(workers[i].thread, NULL);
+    return now_ns() - begin;
+}
+
+static int compare(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+static struct result summarize(double *values, int n)
+{
+    struct result r;
+
+    qsort(values, n, sizeof(double), compare);
+    r.p50 = values[n / 2];
+    r.p99 = values[(int)(n * 0.99)];
+    r.max = values[n - 1];
+    return r;
+}
+
+// events emitted back to back, at most events of them or until the duration is over
+static int emit(int events, unsigned long long duration_ns, double *cost, double *first, double *last, double *per_callback)
+{
+    static const float values[3] = { 0.1f, 9.8f, 0.2f };
+    static unsigned long long timestamp = 1000000;
+    unsigned long long begin = now_ns(), t0, t1;
+    double delivered = 0, total = 0;
+    int i;
+
+    for(i=0; i<events && (duration_ns == 0 || now_ns() - begin < duration_ns); i++){
+        callbacks = 0;
+        first_callback_ns = last_callback_ns = 0;
+        timestamp += 10000;
+
+        t0 = now_ns();
+        sensor_mock_emit(SENSOR_ACCELEROMETER, timestamp, SENSOR_DATA_ACCURACY_GOOD, values, 3);
+        t1 = now_ns();
+
+        cost[i] = t1 - t0;
+        if(first != NULL){
+            first[i] = (callbacks > 0 ? first_callback_ns : t1) - t0;
+            last[i] = (callbacks > 0 ? last_callback_ns : t1) - t0;
+        }
+        delivered += callbacks;
+        total += cost[i];
+    }
+
+    if(per_callback != NULL)
+        *per_callback = delivered > 0 ? total / delivered : 0;
+    return i;
+}
+
+static void run(int handles, int threads, int events, int churn_ms, const char *label, int json)
+{
+    struct worker workers[THREADS_MAX];
+    sensor_h *all = calloc(handles, sizeof(sensor_h));
+    double *cost = malloc(events * sizeof(double));
+    double *first = malloc(events * sizeof(double));
+    double *last = malloc(events * sizeof(double));
+    double create_ns, destroy_ns, churn_ns, per_callback;
+    struct result c, f, l, cc;
+    unsigned long long churn_ops = 0, failures = 0;
+    long long heap_begin, heap_created, heap_end;
+    int i, n, emitted;
+
+    if(threads > handles)
+        threads = handles;
+
+    for(i=0, n=0; i<threads; i++){
+        memset(&workers[i], 0, sizeof(workers[i]));
+        workers[i].handles = all + n;
+        workers[i].count = handles / threads + (i < handles % threads);
+        n += workers[i].count;
+    }
+
+    heap_begin = heap_bytes();
+    create_ns = run_workers(workers, threads, create_all);
+    heap_created = heap_bytes();
+
+    // warm up, then fan out
+    emit(events / 10 + 1, 0, cost, NULL, NULL, NULL);
+    emitted = emit(events, 0, cost, first, last, &per_callback);
+    c = summarize(cost, emitted);
+    f = summarize(first, emitted);
+    l = summarize(last, emitted);
+
+    churning = 1;
+    for(i=0; i<threads; i++)
+        pthread_create(&workers[i].thread, NULL, churn, &workers[i]);
+    churn_ns = now_ns();
+    emitted = emit(events, churn_ms * 1000000ull, cost, NULL, NULL, NULL);
+    // the threads churn for the whole duration even when the events run out
+    while(now_ns() - churn_ns < churn_ms * 1000000ull)
+        usleep(1000);
+    churning = 0;
+    for(i=0; i<threads; i++){
+        pthread_join(workers[i].thread, NULL);
+        churn_ops += workers[i].ops;
+    }
+    churn_ns = now_ns() - churn_ns;
+    cc = summarize(cost, emitted);
+
+    destroy_ns = run_workers(workers, threads, destroy_all);
+    heap_end = heap_bytes();
+
+    for(i=0; i<threads; i++)
+        failures += workers[i].failures;
+
+    if(json){
+        printf("{\"label\":\"%s\",\"handles\":%d,\"threads\":%d,"
+                "\"create_us_per_handle\":%.2f,\"heap_bytes_per_handle\":%.0f,"
+                "\"event_ns\":{\"p50\":%.0f,\"p99\":%.0f,\"max\":%.0f},\"callback_ns\":%.1f,"
+                "\"first_callback_ns\":{\"p50\":%.0f,\"p99\":%.0f},\"last_callback_ns\":{\"p50\":%.0f,\"p99\":%.0f},"
+                "\"churn_ops_per_s\":%.0f,\"churn_event_ns\":{\"p50\":%.0f,\"p99\":%.0f,\"max\":%.0f},"
+                "\"destroy_us_per_handle\":%.2f,\"leaked_bytes_per_handle\":%.0f,\"failures\":%llu}\n",
+                label, handles, threads,
+                create_ns / 1000 / handles, (double)(heap_created - heap_begin) / handles,
+                c.p50, c.p99, c.max, per_callback,
+                f.p50, f.p99, l.p50, l.p99,
+                churn_ops * 1e9 / churn_ns, cc.p50, cc.p99, cc.max,
+                destroy_ns / 1000 / handles, (double)(heap_end - heap_begin) / handles, failures);
+    }else{
+        printf("%7d %7d %9.2f %8.0f %9.0f %9.0f %8.1f %8.0f %9.0f %11.0f %9.0f %9.2f %7.0f %8llu\n",
+                handles, threads, create_ns / 1000 / handles, (double)(heap_created - heap_begin) / handles,
+                c.p50, c.p99, per_callback, f.p50, l.p99,
+                churn_ops * 1e9 / churn_ns, cc.p99,
+                destroy_ns / 1000 / handles, (double)(heap_end - heap_begin) / handles, failures);
+    }
+
+    free(all);
+    free(cost);
+    free(first);
+    free(last);
+}
+
+int main(int argc, char *argv[])
+{
+    char handle_list[256] = "1,10,100,500";
+    const char *label = "";
+    int threads = 4, events = 2000, churn_ms = 1000, json = 0;
+    int opt;
+    char *h, *save;
+    sensor_mock_spec_s spec = { "mock", "stress", -1000, 1000, 0.001, 0 };
+
+    while((opt = getopt(argc, argv, "n:T:e:d:l:j")) != -1){
+        switch(opt){
+            case 'n': snprintf(handle_list, sizeof(handle_list), "%s", optarg); break;
+            case 'T': threads = atoi(optarg); break;
+            case 'e': events = atoi(optarg); break;
+            case 'd': churn_ms = atoi(optarg); break;
+            case 'l': label = optarg; break;
+            case 'j': json = 1; break;
+            default:
+                fprintf(stderr, "usage: %s [-n handles] [-T threads] [-e events] [-d churn_ms] [-l label] [-j]\n", argv[0]);
+                return 1;
+        }
+    }
+    if(threads < 1 || threads > THREADS_MAX || events <= 0 || churn_ms <= 0){
+        fprintf(stderr, "threads in 1..%d, events and churn_ms above 0\n", THREADS_MAX);
+        return 1;
+    }
+
+    sensor_mock_set(true);
+    sensor_mock_add(SENSOR_ACCELEROMETER, &spec);
+    sensor_mock_add(SENSOR_GYROSCOPE, &spec);
+
+    if(!json){
+        printf("%7s %7s %9s %8s %9s %9s %8s %8s %9s %11s %9s %9s %7s %8s\n", "", "", "create", "heap", "event ns", "", "ns per",
+                "first", "last", "churn", "churn", "destroy", "leak", "");
+        printf("%7s %7s %9s %8s %9s %9s %8s %8s %9s %11s %9s %9s %7s %8s\n", "handles", "threads", "us/handle", "B/handle",
+                "p50", "p99", "callback", "p50 ns", "p99 ns", "ops/s", "event p99", "us/handle", "B", "failures");
+    }
+
+    for(h = strtok_r(handle_list, ",", &save); h != NULL; h = strtok_r(NULL, ",", &save)){
+        int handles = atoi(h);
+
+        if(handles <= 0){
+            fprintf(stderr, "handle count %s out of range\n", h);
+            continue;
+        }
+        run(handles, threads, events, churn_ms, label, json);
+    }
+
+    return 0;
+}
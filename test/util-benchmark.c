@@ -0,0 +1,318 @@
+/*
+ *
+ * Copyright (c) 2011 Samsung Electronics Co., Ltd All Rights Reserved
+ * PROPRIETARY/CONFIDENTIAL
+ *
+ * This software is the confidential and proprietary information of SAMSUNG
+ * ELECTRONICS ("Confidential Information"). You agree and acknowledge that
+ * this software is owned by Samsung and you shall not disclose such
+ * Confidential Information and shall use it only in accordance with the terms
+ * of the license agreement you entered into with SAMSUNG ELECTRONICS. SAMSUNG
+ * make no representations or warranties about the suitability of the software,
+ * either express or implied, including but not limited to the implied
+ * warranties of merchantability, fitness for a particular purpose, or
+ * non-infringement. SAMSUNG shall not be liable for any damages suffered by
+ * licensee arising out of or related to this software.
+ *
+ */
+
+/*
+ * Measures the cost of the sensor_util_* kernels, over the accelerometer and
+ * magnetic samples of a recording or over a synthetic handheld capture.
+ *
+ *   util-benchmark [-f recording] [-l label] [-j] [-c baseline] [-t tolerance_percent]
+ *
+ * Every kernel runs over all the inputs for at least 100 ms, 5 times, the
+ * fastest run is reported. The kernels are plain C, a build of the library
+ * for another instruction set (-mfpu=neon, -mavx2, ...) is compared by
+ * running it with its own label.
+ *
+ * -j prints one JSON object per kernel. With -c, the JSON lines of a
+ * previous run, the exit status is 1 when a kernel got slower than its
+ * baseline by more than the tolerance, 15% by default, and 2 when the
+ * baseline holds none of the kernels.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <sensors.h>
+
+#define SYNTHETIC_SAMPLES   4096
+#define MIN_RUN_NS          100000000.0
+#define RUNS                5
+
+struct input {
+    float gravity[3];
+    float magnetic[3];
+    float R[9];
+    float I[9];
+    float latitude, longitude, altitude;
+};
+
+static struct input *inputs;
+static int input_count;
+static volatile float sink;
+
+static struct {
+    float accel[3];
+    int has_accel;
+    int capacity;
+} loading;
+
+static double now_ns(void)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+static double frand(void)
+{
+    return rand() / (double)RAND_MAX - 0.5;
+}
+
+// somewhere on land, at a few hundred meters
+static void place(struct input *in)
+{
+    in->latitude = frand() * 120;
+    in->longitude = frand() * 360;
+    in->altitude = 200 + frand() * 400;
+}
+
+// device to world rotation of a yaw around z, then a pitch around x, then a roll around y
+static void rotation(double yaw, double pitch, double roll, double m[9])
+{
+    double cy = cos(yaw), sy = sin(yaw), cp = cos(pitch), sp = sin(pitch), cr = cos(roll), sr = sin(roll);
+
+    m[0] = cy*cr - sy*sp*sr; m[1] = -sy*cp; m[2] = cy*sr + sy*sp*cr;
+    m[3] = sy*cr + cy*sp*sr; m[4] = cy*cp;  m[5] = sy*sr - cy*sp*cr;
+    m[6] = -cp*sr;           m[7] = sp;     m[8] = cp*cr;
+}
+
+// a phone held up and panned around, with the noise of the sensors
+static void synthesize(void)
+{
+    static const double up[3] = { 0, 0, 9.80665 };
+    static const double field[3] = { 0, 22, -40 };
+    double m[9];
+    int i, k;
+
+    inputs = malloc(SYNTHETIC_SAMPLES * sizeof(struct input));
+    for(i=0; i<SYNTHETIC_SAMPLES; i++){
+        double t = i * 0.01;
+        struct input *in = &inputs[i];
+
+        rotation(1.2 * sin(0.4 * t), 1.1 + 0.3 * sin(0.7 * t), 0.2 * sin(1.3 * t), m);
+
+        // world vectors seen from the device, through the transpose
+        for(k=0; k<3; k++){
+            in->gravity[k] = m[k]*up[0] + m[3+k]*up[1] + m[6+k]*up[2] + 0.05 * frand();
+            in->magnetic[k] = m[k]*field[0] + m[3+k]*field[1] + m[6+k]*field[2] + 0.5 * frand();
+        }
+        place(in);
+    }
+    input_count = SYNTHETIC_SAMPLES;
+}
+
+static bool load_cb(sensor_type_e type, unsigned long long timestamp, sensor_data_accuracy_e accuracy, const float values[3], void *user_data)
+{
+    if(type == SENSOR_ACCELEROMETER){
+        memcpy(loading.accel, values, sizeof(loading.accel));
+        loading.has_accel = 1;
+        return true;
+    }
+
+    if(type != SENSOR_MAGNETIC || !loading.has_accel)
+        return true;
+
+    if(input_count == loading.capacity){
+        loading.capacity = loading.capacity ? loading.capacity * 2 : 4096;
+        inputs = realloc(inputs, loading.capacity * sizeof(struct input));
+    }
+    memcpy(inputs[input_count].gravity, loading.accel, sizeof(loading.accel));
+    memcpy(inputs[input_count].magnetic, values, sizeof(inputs[input_count].magnetic));
+    place(&inputs[input_count]);
+    input_count++;
+    return true;
+}
+
+static void k_rotation_matrix(struct input *in)
+{
+    sensor_util_get_rotation_matrix(in->gravity[0], in->gravity[1], in->gravity[2],
+            in->magnetic[0], in->magnetic[1], in->magnetic[2], in->R, in->I);
+    sink += in->R[4];
+}
+
+static void k_remap(struct input *in)
+{
+    float out[9];
+
+    sensor_util_remap_coordinate_system(in->R, sensor_util_axis_x, sensor_util_axis_z, out);
+    sink += out[4];
+}
+
+static void k_orientation(struct input *in)
+{
+    float values[3];
+
+    sensor_util_get_orientation(in->R, values);
+    sink += values[0];
+}
+
+static void k_angle_change(struct input *in)
+{
+    float change[3];
+
+    sensor_util_get_angle_change(in->R, in == inputs ? in->R : (in - 1)->R, change);
+    sink += change[0];
+}
+
+static void k_inclination(struct input *in)
+{
+    float inclination;
+
+    sensor_util_get_inclination(in->I, &inclination);
+    sink += inclination;
+}
+
+static void k_declination(struct input *in)
+{
+    float declination;
+
+    sensor_util_get_declination(in->latitude, in->longitude, in->altitude, &declination);
+    sink += declination;
+}
+
+static const struct {
+    const char *name;
+    void (*run)(struct input *in);
+} kernels[] = {
+    { "rotation_matrix", k_rotation_matrix },
+    { "remap_coordinate_system", k_remap },
+    { "orientation", k_orientation },
+    { "angle_change", k_angle_change },
+    { "inclination", k_inclination },
+    { "declination", k_declination },
+};
+
+#define KERNELS ((int)(sizeof(kernels) / sizeof(kernels[0])))
+
+static double measure(int k)
+{
+    double best = 0;
+    int r, i;
+
+    for(r=0; r<RUNS; r++){
+        double begin = now_ns(), elapsed;
+        long long calls = 0;
+
+        do{
+            for(i=0; i<input_count; i++)
+                kernels[k].run(&inputs[i]);
+            calls += input_count;
+            elapsed = now_ns() - begin;
+        }while(elapsed < MIN_RUN_NS);
+
+        if(r == 0 || elapsed / calls < best)
+            best = elapsed / calls;
+    }
+    return best;
+}
+
+// ns per call of a kernel in the JSON lines of a previous run, 0 when absent
+static double baseline_ns(const char *path, const char *kernel)
+{
+    FILE *f = fopen(path, "r");
+    char line[512], name[64];
+    double ns = 0;
+    const char *p;
+
+    if(f == NULL)
+        return 0;
+
+    while(fgets(line, sizeof(line), f) != NULL){
+        if((p = strstr(line, "\"kernel\":\"")) == NULL || sscanf(p, "\"kernel\":\"%63[^\"]\"", name) != 1 || strcmp(name, kernel) != 0)
+            continue;
+        if((p = strstr(line, "\"ns\":")) != NULL)
+            sscanf(p, "\"ns\":%lf", &ns);
+    }
+    fclose(f);
+    return ns;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *path = NULL, *label = "", *baseline = NULL;
+    double tolerance = 15;
+    int json = 0, regressions = 0;
+    int opt, k;
+
+    while((opt = getopt(argc, argv, "f:l:jc:t:")) != -1){
+        switch(opt){
+            case 'f': path = optarg; break;
+            case 'l': label = optarg; break;
+            case 'j': json = 1; break;
+            case 'c': baseline = optarg; break;
+            case 't': tolerance = atof(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-f recording] [-l label] [-j] [-c baseline] [-t tolerance_percent]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    // a gate without a baseline would pass whatever the timings
+    if(baseline != NULL){
+        for(k=0; k<KERNELS && baseline_ns(baseline, kernels[k].name) == 0; k++)
+            ;
+        if(k == KERNELS){
+            fprintf(stderr, "no kernel in the baseline %s\n", baseline);
+            return 2;
+        }
+    }
+
+    srand(1);
+    if(path != NULL){
+        if(sensor_record_foreach_sample(path, load_cb, NULL) != SENSOR_ERROR_NONE || input_count == 0){
+            fprintf(stderr, "no accelerometer and magnetic samples in %s\n", path);
+            return 2;
+        }
+    }else{
+        synthesize();
+    }
+
+    // the matrices the other kernels read
+    for(k=0; k<input_count; k++)
+        k_rotation_matrix(&inputs[k]);
+
+    if(!json)
+        printf("%d inputs from %s\n\n%-24s %10s %14s %10s\n", input_count, path ? path : "a synthetic capture",
+                "kernel", "ns/call", "calls/s", "baseline");
+
+    for(k=0; k<KERNELS; k++){
+        double ns = measure(k);
+        double base = baseline != NULL ? baseline_ns(baseline, kernels[k].name) : 0;
+        int slower = base > 0 && ns > base * (1 + tolerance / 100);
+
+        if(json){
+            printf("{\"label\":\"%s\",\"kernel\":\"%s\",\"inputs\":%d,\"ns\":%.2f,\"calls_per_s\":%.0f}\n",
+                    label, kernels[k].name, input_count, ns, 1e9 / ns);
+        }else if(base > 0){
+            printf("%-24s %10.2f %14.0f %10.2f %+6.1f%%%s\n", kernels[k].name, ns, 1e9 / ns, base,
+                    (ns / base - 1) * 100, slower ? "  REGRESSION" : "");
+        }else{
+            printf("%-24s %10.2f %14.0f\n", kernels[k].name, ns, 1e9 / ns);
+        }
+        regressions += slower;
+    }
+
+    if(regressions > 0)
+        fprintf(stderr, "%d kernel(s) slower than the baseline by more than %.0f%%\n", regressions, tolerance);
+
+    free(inputs);
+    return regressions > 0;
+}